@@ -12,17 +12,42 @@
 #include <utility>
 #include <string>
 #include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <unordered_map>
 #include <libKitsunemimiCommon/common_items/data_items.h>
 
 namespace Kitsunemimi
 {
+namespace Json
+{
+class JsonItem;
+}
+
 namespace Jinja2
 {
-class Jinja2ParserInterface;
-class Jinja2Item;
-class ReplaceItem;
-class IfItem;
-class ForLoopItem;
+class Jinja2Template;
+class Jinja2TemplateCache;
+class Jinja2Sink;
+class Jinja2PreparedContext;
+struct TemplateProfile;
+struct RenderLimits;
+
+struct TemplateCacheStatistics
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t numberOfEntries = 0;
+    uint64_t numberOfBytes = 0;
+};
+
+// loads the template-string of an included template by the name of the include
+typedef std::function<bool(const std::string &name,
+                           std::string &templateString,
+                           std::string &errorMessage)> Jinja2IncludeLoader;
 
 class Jinja2Converter
 {
@@ -36,42 +61,88 @@ public:
                  const std::string &jsonInput,
                  std::string &errorMessage);
 
+    bool convert(std::string &result,
+                 const std::string &templateString,
+                 Json::JsonItem &jsonInput,
+                 std::string &errorMessage);
+
     bool convert(std::string &result,
                  const std::string &templateString,
                  DataMap* input,
                  std::string &errorMessage);
 
+    bool convert(std::string &result,
+                 const std::string &templateString,
+                 const Jinja2PreparedContext &context,
+                 std::string &errorMessage);
+
+    bool convert(Jinja2Sink &sink,
+                 const std::string &templateString,
+                 DataMap* input,
+                 std::string &errorMessage);
+
+    Jinja2Template* compile(const std::string &templateString,
+                            std::string &errorMessage);
+    Jinja2Template* compile(const std::string &templateString,
+                            DataMap* staticContext,
+                            std::string &errorMessage);
+
+    bool generateCode(const std::vector<std::string> &templateStrings,
+                      const std::vector<std::string> &functionNames,
+                      std::string &code,
+                      std::string &errorMessage);
+
+    // template-cache
+    void setCacheLimits(const uint64_t maxEntries,
+                        const uint64_t maxBytes);
+    void clearCache();
+    TemplateCacheStatistics getCacheStatistics();
+
+    // includes
+    void setIncludeLoader(const Jinja2IncludeLoader &loader);
+    void clearIncludes();
+    uint64_t getNumberOfIncludes();
+
+    // render-limits
+    void setRenderLimits(const RenderLimits &limits);
+    RenderLimits getRenderLimits() const;
+
+    // profiling
+    void setProfiling(const bool enabled);
+    bool getProfile(TemplateProfile &profile,
+                    const std::string &templateString);
+
 private:
     Jinja2Converter(const bool traceParsing = false);
 
-    static Jinja2Converter* m_instance;
-
-    Jinja2ParserInterface* m_driver = nullptr;
-    std::mutex m_lock;
-
-    bool processItem(DataMap* input,
-                     Kitsunemimi::Jinja2::Jinja2Item* part,
-                     std::string &output,
-                     std::string &errorMessage);
-    bool processReplace(DataMap* input,
-                        ReplaceItem* replaceObject,
-                        std::string &output,
-                        std::string &errorMessage);
-    bool processIfCondition(DataMap* input,
-                            IfItem* ifCondition,
-                            std::string &output,
-                            std::string &errorMessage);
-    bool processForLoop(DataMap* input,
-                        ForLoopItem* forLoop,
-                        std::string &output,
-                        std::string &errorMessage);
+    static std::atomic<Jinja2Converter*> m_instance;
+    static std::mutex m_instanceLock;
+
+    bool m_traceParsing = false;
+    std::atomic<bool> m_profiling;
+
+    // render-limits for new compiled templates
+    std::atomic<uint64_t> m_maxOutputSize;
+    std::atomic<uint64_t> m_maxLoopIterations;
+    std::atomic<uint64_t> m_maxNestingDepth;
+    Jinja2TemplateCache* m_cache = nullptr;
 
-    const std::pair<std::string, bool> getString(DataMap* input,
-                                                 DataArray* jsonPath);
-    const std::pair<DataItem*, bool> getItem(DataMap* input,
-                                             DataArray* jsonPath);
+    // compiled included templates, which are shared by all templates, which include them
+    std::mutex m_includeLock;
+    Jinja2IncludeLoader m_includeLoader;
+    std::unordered_map<std::string, std::shared_ptr<Jinja2Template>> m_includes;
 
-    const std::string createErrorMessage(DataArray* jsonPath);
+    bool hasRenderLimits() const;
+    std::shared_ptr<Jinja2Template> getTemplate(const std::string &templateString,
+                                                const uint64_t hash,
+                                                std::string &errorMessage);
+    Jinja2Template* compileTemplate(const std::string &templateString,
+                                    DataMap* staticContext,
+                                    std::vector<std::string> &includeStack,
+                                    std::string &errorMessage);
+    std::shared_ptr<Jinja2Template> getInclude(const std::string &name,
+                                               std::vector<std::string> &includeStack,
+                                               std::string &errorMessage);
 };
 
 }  // namespace Jinja2
@@ -0,0 +1,54 @@
+/**
+ *  @file    jinja2_generated.h
+ *
+ *  @brief   runtime-functions for the C++-code, which is generated from templates by the
+ *           offline-compiler, and the registration of the generated functions
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2GENERATED_H
+#define JINJA2GENERATED_H
+
+#include <stdint.h>
+#include <string>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// signature of a generated template-function, which renders the template like
+// Jinja2Template::render
+typedef bool (*Jinja2GeneratedFunction)(DataMap* input,
+                                        std::string &output,
+                                        std::string &errorMessage);
+
+// registration
+bool registerGeneratedTemplate(const char* templateString,
+                               const uint64_t templateSize,
+                               Jinja2GeneratedFunction function);
+bool unregisterGeneratedTemplate(const std::string &templateString);
+Jinja2GeneratedFunction getGeneratedTemplate(const std::string &templateString);
+Jinja2GeneratedFunction getGeneratedTemplate(const std::string &templateString,
+                                             const uint64_t hash);
+
+// functions, which are called by the generated code
+void appendGeneratedValue(std::string &output,
+                          DataItem* item);
+bool evaluateGeneratedCondition(DataItem* item,
+                                const uint32_t compareType,
+                                const uint32_t constantType,
+                                const int64_t longValue,
+                                const bool boolValue,
+                                const char* text);
+void createGeneratedErrorMessage(std::string &errorMessage,
+                                 const char* path);
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2GENERATED_H
@@ -0,0 +1,51 @@
+/**
+ *  @file    jinja2_prepared_context.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2PREPAREDCONTEXT_H
+#define JINJA2PREPAREDCONTEXT_H
+
+#include <stdint.h>
+#include <string>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Template;
+struct Jinja2ContextIndex;
+
+/**
+ * Input of renders, where all paths are resolved only once into a flat hash-index, so many
+ * templates can be rendered against the same input and each variable is found with only one
+ * probe of the index. The input must stay valid and unchanged as long as the context is used.
+ */
+class Jinja2PreparedContext
+{
+public:
+    Jinja2PreparedContext(DataMap* input);
+    ~Jinja2PreparedContext();
+
+    Jinja2PreparedContext(const Jinja2PreparedContext &other) = delete;
+    Jinja2PreparedContext &operator=(const Jinja2PreparedContext &other) = delete;
+
+    DataMap* getInput() const;
+    uint64_t getNumberOfPaths() const;
+    DataItem* get(const std::string &path) const;
+
+private:
+    friend class Jinja2Template;
+
+    DataMap* m_input = nullptr;
+    Jinja2ContextIndex* m_index = nullptr;
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2PREPAREDCONTEXT_H
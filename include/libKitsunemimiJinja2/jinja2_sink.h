@@ -0,0 +1,113 @@
+/**
+ *  @file    jinja2_sink.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2SINK_H
+#define JINJA2SINK_H
+
+#include <stdint.h>
+#include <string>
+#include <ostream>
+#include <functional>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Template;
+
+//===================================================================
+// Jinja2Sink
+//===================================================================
+/**
+ * Target for the output of a render. The output is collected in a buffer and forwarded in
+ * chunks of the given size, so the complete output has never to be stored in memory.
+ */
+class Jinja2Sink
+{
+public:
+    static const uint64_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    Jinja2Sink(const uint64_t chunkSize = DEFAULT_CHUNK_SIZE);
+    virtual ~Jinja2Sink();
+
+    bool flush();
+    uint64_t getNumberOfWrittenBytes() const;
+
+protected:
+    virtual bool writeChunk(const char* data,
+                            const uint64_t size) = 0;
+
+private:
+    friend class Jinja2Template;
+
+    std::string m_buffer = "";
+    uint64_t m_chunkSize = 0;
+    uint64_t m_numberOfWrittenBytes = 0;
+};
+
+//===================================================================
+// Jinja2StreamSink
+//===================================================================
+class Jinja2StreamSink
+        : public Jinja2Sink
+{
+public:
+    Jinja2StreamSink(std::ostream &stream,
+                     const uint64_t chunkSize = DEFAULT_CHUNK_SIZE);
+    ~Jinja2StreamSink();
+
+protected:
+    bool writeChunk(const char* data,
+                    const uint64_t size);
+
+private:
+    std::ostream* m_stream = nullptr;
+};
+
+//===================================================================
+// Jinja2FileDescriptorSink
+//===================================================================
+class Jinja2FileDescriptorSink
+        : public Jinja2Sink
+{
+public:
+    Jinja2FileDescriptorSink(const int fileDescriptor,
+                             const uint64_t chunkSize = DEFAULT_CHUNK_SIZE);
+    ~Jinja2FileDescriptorSink();
+
+protected:
+    bool writeChunk(const char* data,
+                    const uint64_t size);
+
+private:
+    int m_fileDescriptor = -1;
+};
+
+//===================================================================
+// Jinja2CallbackSink
+//===================================================================
+class Jinja2CallbackSink
+        : public Jinja2Sink
+{
+public:
+    Jinja2CallbackSink(std::function<bool(const char*, const uint64_t)> callback,
+                       const uint64_t chunkSize = DEFAULT_CHUNK_SIZE);
+    ~Jinja2CallbackSink();
+
+protected:
+    bool writeChunk(const char* data,
+                    const uint64_t size);
+
+private:
+    std::function<bool(const char*, const uint64_t)> m_callback;
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2SINK_H
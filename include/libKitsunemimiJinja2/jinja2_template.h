@@ -0,0 +1,348 @@
+/**
+ *  @file    jinja2_template.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2TEMPLATE_H
+#define JINJA2TEMPLATE_H
+
+#include <utility>
+#include <string>
+#include <atomic>
+#include <vector>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Converter;
+class Jinja2Template;
+class Jinja2TemplateBundle;
+class Jinja2Compiler;
+class Jinja2Sink;
+class Jinja2PreparedContext;
+struct Jinja2Bytecode;
+struct Jinja2ContextIndex;
+struct Jinja2LoopFrame;
+struct Jinja2ResumeFrame;
+struct Jinja2ResumeState;
+struct Jinja2PausePoint;
+struct Jinja2RenderBudget;
+struct Jinja2Profiler;
+struct Jinja2InstructionCounters;
+
+struct TemplateStatistics
+{
+    uint64_t numberOfInstructions = 0;
+    uint64_t literalSize = 0;
+    uint64_t numberOfPaths = 0;
+    uint64_t numberOfKeys = 0;
+    uint64_t numberOfConditions = 0;
+    uint64_t maxNestingDepth = 0;
+    // number of bytes of all arrays of the compiled bytecode
+    uint64_t bytecodeSize = 0;
+    // true, if the template contains only text and replacements and is rendered as splice-list
+    bool isSpliceList = false;
+};
+
+struct RenderLimits
+{
+    // limits of each single render, 0 means no limit
+    uint64_t maxOutputSize = 0;
+    // sum of the iterations of all for-loops including nested loops
+    uint64_t maxLoopIterations = 0;
+    // nesting-depth of if-conditions and for-loops including the included templates
+    uint64_t maxNestingDepth = 0;
+};
+
+struct InstructionProfile
+{
+    // type of the instruction: "text", "replace", "if", "else", "for", "endfor" or "include"
+    std::string type = "";
+    // location of the source within the template-string, 0 if not known
+    uint32_t line = 0;
+    uint32_t column = 0;
+
+    uint64_t executions = 0;
+    uint64_t lookups = 0;
+    uint64_t loopIterations = 0;
+    uint64_t emittedBytes = 0;
+    uint64_t parallelLoops = 0;
+};
+
+struct TemplateProfile
+{
+    // duration of parsing and compiling in nanoseconds
+    uint64_t parseTime = 0;
+
+    // summed values of all profiled renders
+    uint64_t numberOfRenders = 0;
+    uint64_t renderTime = 0;
+    uint64_t visitedInstructions = 0;
+    uint64_t replaceLookups = 0;
+    uint64_t ifLookups = 0;
+    uint64_t forLookups = 0;
+    uint64_t loopIterations = 0;
+    uint64_t emittedBytes = 0;
+    // number of loops, which were split between multiple threads
+    uint64_t parallelLoops = 0;
+
+    std::vector<InstructionProfile> instructions;
+};
+
+class Jinja2RenderState
+{
+public:
+    Jinja2RenderState();
+    ~Jinja2RenderState();
+
+    const std::string &getOutput() const;
+    uint64_t getNumberOfRenderedSegments() const;
+    void clear();
+
+private:
+    friend class Jinja2Template;
+
+    // template, which has filled the state, and the output of each of its segments. The id is
+    // also compared, because a new template can get the address of a deleted one.
+    const Jinja2Template* m_template = nullptr;
+    uint64_t m_templateId = 0;
+    std::vector<std::string> m_segmentOutputs;
+    std::string m_output = "";
+    std::string m_buffer = "";
+    uint64_t m_numberOfRenderedSegments = 0;
+};
+
+class Jinja2RenderContinuation
+{
+public:
+    Jinja2RenderContinuation();
+    ~Jinja2RenderContinuation();
+
+    Jinja2RenderContinuation(const Jinja2RenderContinuation &other) = delete;
+    Jinja2RenderContinuation &operator=(const Jinja2RenderContinuation &other) = delete;
+
+    bool isFinished() const;
+    const char* getData() const;
+    uint64_t getSize() const;
+    void consume(const uint64_t numberOfBytes);
+    void clear();
+
+private:
+    friend class Jinja2Template;
+
+    // template and input of the render, which must stay valid until the render is finished
+    const Jinja2Template* m_template = nullptr;
+    DataMap* m_input = nullptr;
+    Jinja2ResumeState* m_state = nullptr;
+
+    // rendered output, where the first bytes until the offset are already consumed
+    std::string m_output = "";
+    uint64_t m_outputOffset = 0;
+};
+
+class Jinja2Template
+{
+public:
+    // maximum nesting-depth of if-conditions and for-loops
+    static const uint32_t MAX_NESTING_DEPTH = 256;
+
+    ~Jinja2Template();
+
+    bool render(DataMap* input,
+                std::string &result,
+                std::string &errorMessage) const;
+    bool render(DataMap* input,
+                Jinja2Sink &sink,
+                std::string &errorMessage) const;
+    bool render(const Jinja2PreparedContext &context,
+                std::string &result,
+                std::string &errorMessage) const;
+    bool render(const Jinja2PreparedContext &context,
+                Jinja2Sink &sink,
+                std::string &errorMessage) const;
+    bool renderBatch(const std::vector<DataMap*> &inputs,
+                     std::vector<std::string> &results,
+                     std::vector<std::string> &errorMessages,
+                     const uint32_t numberOfThreads = 0) const;
+
+    uint64_t estimateOutputSize() const;
+    TemplateStatistics getStatistics() const;
+
+    void setParallelLoops(const uint64_t minNumberOfElements,
+                          const uint32_t numberOfThreads = 0);
+    void setRenderLimits(const RenderLimits &limits);
+    RenderLimits getRenderLimits() const;
+
+    // dependencies
+    const std::vector<std::string> getDependencies() const;
+    uint64_t getNumberOfSegments() const;
+    const std::vector<std::string> getSegmentDependencies(const uint64_t segmentId) const;
+    bool isAffected(const std::vector<std::string> &changedPaths) const;
+    bool renderIncremental(DataMap* input,
+                           const std::vector<std::string> &changedPaths,
+                           Jinja2RenderState &state,
+                           bool &outputChanged,
+                           std::string &errorMessage) const;
+
+    // resumable rendering
+    void beginRender(DataMap* input,
+                     Jinja2RenderContinuation &continuation) const;
+    void beginRender(const Jinja2PreparedContext &context,
+                     Jinja2RenderContinuation &continuation) const;
+    bool continueRender(Jinja2RenderContinuation &continuation,
+                        const uint64_t maxPendingSize,
+                        std::string &errorMessage) const;
+
+    // profiling
+    void setProfiling(const bool enabled);
+    bool isProfiling() const;
+    TemplateProfile getProfile() const;
+    void resetProfile();
+    const std::string dumpProfile() const;
+
+private:
+    friend class Jinja2Converter;
+    friend class Jinja2TemplateBundle;
+    friend class Jinja2Compiler;
+
+    Jinja2Template(Jinja2Bytecode* bytecode);
+
+    Jinja2Bytecode* m_bytecode = nullptr;
+
+    // unique id of the template within the process, which is never reused
+    uint64_t m_id = 0;
+
+    // running average of the bytes, which were added by replacements and loops in earlier renders
+    mutable std::atomic<uint64_t> m_averageDynamicSize;
+
+    // settings for rendering big loops in parallel
+    uint64_t m_parallelLoopThreshold = 0;
+    uint32_t m_parallelLoopThreads = 0;
+
+    RenderLimits m_renderLimits;
+
+    // counters of the profiled renders, nullptr if profiling is disabled
+    Jinja2Profiler* m_profiler = nullptr;
+    uint64_t m_parseTime = 0;
+
+    bool renderResult(DataMap* input,
+                      const Jinja2ContextIndex* contextIndex,
+                      const bool allowParallel,
+                      std::string &result,
+                      std::string &errorMessage) const;
+    bool renderSink(DataMap* input,
+                    const Jinja2ContextIndex* contextIndex,
+                    Jinja2Sink &sink,
+                    std::string &errorMessage) const;
+    bool execute(DataMap* input,
+                 const Jinja2ContextIndex* contextIndex,
+                 std::string &output,
+                 Jinja2Sink* sink,
+                 Jinja2RenderBudget &budget,
+                 const uint32_t startPos,
+                 const uint32_t endPos,
+                 const bool allowParallel,
+                 std::string &errorMessage) const;
+    bool executeSpliceList(DataMap* input,
+                           const Jinja2ContextIndex* contextIndex,
+                           std::string &output,
+                           Jinja2Sink* sink,
+                           const Jinja2RenderBudget &budget,
+                           std::string &errorMessage) const;
+    template<bool PROFILE>
+    bool executeRange(DataMap* input,
+                      const Jinja2ContextIndex* contextIndex,
+                      std::string &output,
+                      Jinja2Sink* sink,
+                      Jinja2RenderBudget &budget,
+                      std::vector<Jinja2LoopFrame> &loops,
+                      const uint32_t startPos,
+                      const uint32_t endPos,
+                      const bool allowParallel,
+                      Jinja2PausePoint* pause,
+                      Jinja2InstructionCounters* counters,
+                      std::string &errorMessage) const;
+    template<bool PROFILE>
+    bool executeParallelLoop(DataMap* input,
+                             const Jinja2ContextIndex* contextIndex,
+                             std::string &output,
+                             Jinja2Sink* sink,
+                             Jinja2RenderBudget &budget,
+                             const std::vector<Jinja2LoopFrame> &loops,
+                             const Jinja2LoopFrame &frame,
+                             const uint32_t bodyBegin,
+                             const uint32_t bodyEnd,
+                             Jinja2InstructionCounters* counters,
+                             std::string &errorMessage) const;
+    template<bool PROFILE>
+    bool executeInclude(DataMap* input,
+                        const Jinja2ContextIndex* contextIndex,
+                        std::string &output,
+                        Jinja2Sink* sink,
+                        Jinja2RenderBudget &budget,
+                        const std::vector<Jinja2LoopFrame> &loops,
+                        const uint32_t includeId,
+                        const bool allowParallel,
+                        std::string &errorMessage) const;
+    void createIncludeLoops(const uint32_t includeId,
+                            const std::vector<Jinja2LoopFrame> &loops,
+                            std::vector<Jinja2LoopFrame> &includeLoops) const;
+    bool resumeFrame(DataMap* input,
+                     const Jinja2ContextIndex* contextIndex,
+                     Jinja2ResumeFrame &frame,
+                     Jinja2RenderBudget &budget,
+                     std::string &output,
+                     const uint64_t pauseSize,
+                     Jinja2InstructionCounters* counters,
+                     uint32_t &includeId,
+                     std::string &errorMessage) const;
+    bool reachedPause(Jinja2PausePoint* pause,
+                      const std::string &output,
+                      const uint32_t nextPos,
+                      uint64_t &checkSize) const;
+    bool flushSink(Jinja2Sink &sink,
+                   std::string &errorMessage) const;
+
+    // render-limits
+    bool checkNestingDepth(std::string &errorMessage) const;
+    bool createBudget(const uint64_t outputSize,
+                      Jinja2RenderBudget &budget,
+                      std::string &errorMessage) const;
+    uint64_t getCheckSize(const Jinja2Sink* sink,
+                          const Jinja2RenderBudget &budget) const;
+    bool checkOutput(std::string &output,
+                     Jinja2Sink* sink,
+                     Jinja2RenderBudget &budget,
+                     uint64_t &checkSize,
+                     std::string &errorMessage) const;
+    bool chargeIterations(Jinja2RenderBudget &budget,
+                          const uint64_t numberOfIterations,
+                          const uint32_t pathId,
+                          std::string &errorMessage) const;
+    void updateSizeEstimation(const uint64_t outputSize) const;
+
+    DataItem* getItem(DataMap* input,
+                      const Jinja2ContextIndex* contextIndex,
+                      const Jinja2LoopFrame* loops,
+                      const uint64_t numberOfLoops,
+                      const uint32_t pathId) const;
+
+    bool isSegmentAffected(const uint64_t segmentId,
+                           const std::vector<std::string> &changedPaths) const;
+
+    const std::string getPathString(const uint32_t pathId) const;
+    const std::string createErrorMessage(const uint32_t pathId) const;
+    const std::string createOutputLimitError(const Jinja2RenderBudget &budget) const;
+    const std::string createLoopLimitError(const Jinja2RenderBudget &budget,
+                                           const uint32_t pathId) const;
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2TEMPLATE_H
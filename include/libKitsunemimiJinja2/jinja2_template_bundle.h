@@ -0,0 +1,63 @@
+/**
+ *  @file    jinja2_template_bundle.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2TEMPLATEBUNDLE_H
+#define JINJA2TEMPLATEBUNDLE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Template;
+struct Jinja2Bytecode;
+
+/**
+ * File with multiple precompiled templates. The file is mapped into the memory and the
+ * templates are rendered directly from the mapped file, so loading requires no parsing and
+ * multiple processes share the same memory-pages.
+ */
+class Jinja2TemplateBundle
+{
+public:
+    Jinja2TemplateBundle();
+    ~Jinja2TemplateBundle();
+
+    static bool writeFile(const std::string &filePath,
+                          const std::vector<std::string> &names,
+                          const std::vector<Jinja2Template*> &templates,
+                          std::string &errorMessage);
+
+    bool loadFile(const std::string &filePath,
+                  std::string &errorMessage);
+
+    uint64_t getNumberOfTemplates() const;
+    const std::vector<std::string> getNames() const;
+    Jinja2Template* getTemplate(const std::string &name) const;
+
+private:
+    std::shared_ptr<const void> m_mappedFile;
+    uint64_t m_fileSize = 0;
+    std::unordered_map<std::string, uint64_t> m_entries;
+
+    void fillBytecode(const uint64_t entryId,
+                      Jinja2Bytecode &bytecode) const;
+    bool validateFile(std::string &errorMessage);
+    static bool validateBytecode(const Jinja2Bytecode &bytecode,
+                                 std::string &errorMessage);
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2TEMPLATEBUNDLE_H
@@ -0,0 +1,81 @@
+/**
+ *  @file    jinja2_template_registry.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2TEMPLATEREGISTRY_H
+#define JINJA2TEMPLATEREGISTRY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Template;
+struct Jinja2RegistrySnapshot;
+
+/**
+ * Registry of compiled templates by name, which can be updated at runtime. New versions are
+ * compiled outside of the registry and published with an atomic swap of an immutable
+ * snapshot, so reading threads are never blocked by updates. Renders, which already use an
+ * old version, keep it until they are finished.
+ */
+class Jinja2TemplateRegistry
+{
+public:
+    Jinja2TemplateRegistry();
+    ~Jinja2TemplateRegistry();
+
+    bool update(const std::string &name,
+                const std::string &templateString,
+                std::string &errorMessage);
+    bool update(const std::string &name,
+                const std::string &templateString,
+                DataMap* staticContext,
+                std::string &errorMessage);
+    void publish(const std::string &name,
+                 const std::shared_ptr<Jinja2Template> &compiledTemplate);
+    bool remove(const std::string &name);
+
+    std::shared_ptr<Jinja2Template> get(const std::string &name) const;
+    uint64_t getVersion(const std::string &name) const;
+    uint64_t getNumberOfTemplates() const;
+    const std::vector<std::string> getNames() const;
+
+    bool render(const std::string &name,
+                DataMap* input,
+                std::string &result,
+                std::string &errorMessage) const;
+
+private:
+    // current snapshot, which is replaced as a whole by each update
+    std::atomic<Jinja2RegistrySnapshot*> m_snapshot;
+
+    // readers register at the counter of the current epoch, so an update can wait until all
+    // readers, which could have seen the old snapshot, are finished, before it is deleted
+    std::atomic<uint64_t> m_epoch;
+    mutable std::atomic<uint64_t> m_readers[2];
+
+    // updates are serialized among each other, but never block the readers
+    std::mutex m_updateLock;
+    uint64_t m_nextVersion = 1;
+
+    uint64_t beginRead() const;
+    void endRead(const uint64_t epoch) const;
+    void replaceSnapshot(Jinja2RegistrySnapshot* newSnapshot);
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2TEMPLATEREGISTRY_H
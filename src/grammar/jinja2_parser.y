@@ -49,6 +49,8 @@ class Jinja2ParserInterface;
 
 // The parsing context.
 %param { Kitsunemimi::Jinja2::Jinja2ParserInterface& driver }
+// The state of the reentrant scanner.
+%param { void* scanner }
 
 %locations
 
@@ -57,7 +59,8 @@ class Jinja2ParserInterface;
 #include <jinja2_parsing/jinja2_parser_interface.h>
 # undef YY_DECL
 # define YY_DECL \
-    Kitsunemimi::Jinja2::Jinja2Parser::symbol_type jinja2lex (Kitsunemimi::Jinja2::Jinja2ParserInterface& driver)
+    Kitsunemimi::Jinja2::Jinja2Parser::symbol_type jinja2lex (Kitsunemimi::Jinja2::Jinja2ParserInterface& driver, \
+                                                              void* yyscanner)
 YY_DECL;
 }
 
@@ -65,15 +68,11 @@ YY_DECL;
 %define api.token.prefix {Jinja2_}
 %token
     END  0  "end of file"
-    BLANK  " "
-    LINEBREAK  "\n"
     EXPRESTART  "{{"
     EXPREEND  "}}"
     EXPRESTART_SP  "{%"
     EXPREEND_SP  "%}"
     DOT  "."
-    BRACKOPEN  "["
-    BRACKCLOSE  "]"
     IS  "is"
     IN  "in"
     IF  "if"
@@ -81,25 +80,33 @@ YY_DECL;
     ENDFOR  "endfor"
     ELSE  "else"
     ENDIF  "endif"
+    INCLUDE  "include"
+    COMPARE_EQUAL  "=="
+    COMPARE_UNEQUAL  "!="
+    COMPARE_GREATER_EQUAL  ">="
+    COMPARE_GREATER  ">"
+    COMPARE_SMALLER_EQUAL  "<="
+    COMPARE_SMALLER  "<"
 ;
 
 
+%token <std::string> TEXT "text"
 %token <std::string> DEFAULTRULE "defaultrule"
 %token <std::string> IDENTIFIER "identifier"
+%token <std::string> STRING "string"
 %token <long> NUMBER "number"
 
-%type <std::string> blancs
-%type <std::string> linebreaks
-
 %type  <Jinja2Item*> part
 %type  <Jinja2Item*> replace_rule
-%type  <DataArray*> json_path
-%type  <std::string> defaultroute
+%type  <Jinja2Item*> include_rule
+%type  <Jinja2Path*> json_path
+%type  <Kitsunemimi::Jinja2::IfItem::compareTypes> compare_type
 
 %type  <Jinja2Item*> if_condition_start
+%type  <uint32_t> if_condition_else
 
-%type  <Jinja2Item*> for_loop
 %type  <Jinja2Item*> for_loop_start
+%type  <uint32_t> for_loop_end
 
 %%
 %start startpoint;
@@ -110,6 +117,12 @@ startpoint:
     {
         driver.setOutput($1->startPoint);
     }
+|
+    %empty
+    {
+        // empty templates have no items and are rendered into an empty string
+        driver.setOutput(nullptr);
+    }
 
 part:
     part replace_rule
@@ -120,6 +133,14 @@ part:
         $$ = $2;
     }
 |
+    part include_rule
+    {
+        $1->next = $2;
+        $2->startPoint = $1->startPoint;
+
+        $$ = $2;
+    }
+|
     part if_condition_start part if_condition_end
     {
         IfItem* tempItem = dynamic_cast<IfItem*>($2);
@@ -136,6 +157,7 @@ part:
         IfItem* tempItem = dynamic_cast<IfItem*>($2);
         tempItem->ifChild = $3->startPoint;
         tempItem->elseChild = $5->startPoint;
+        tempItem->elsePosition = $4;
 
         $1->next = tempItem;
         tempItem->startPoint = $1->startPoint;
@@ -147,6 +169,7 @@ part:
     {
         ForLoopItem* tempItem = dynamic_cast<ForLoopItem*>($2);
         tempItem->forChild = $3->startPoint;
+        tempItem->endPosition = $4;
 
         $1->next = tempItem;
         tempItem->startPoint = $1->startPoint;
@@ -154,15 +177,27 @@ part:
         $$ = tempItem;
     }
 |
-    part defaultroute
+    part "text"
     {
-        TextItem* tempItem = new TextItem();
-        tempItem->text = $2;
+        if($1->getType() == Jinja2Item::TEXT_ITEM)
+        {
+            // merge neighbouring text into the already existing text-item
+            TextItem* tempItem = dynamic_cast<TextItem*>($1);
+            tempItem->text.append($2);
 
-        $1->next = tempItem;
-        tempItem->startPoint = $1->startPoint;
+            $$ = tempItem;
+        }
+        else
+        {
+            TextItem* tempItem = driver.createItem<TextItem>();
+            tempItem->text = $2;
+            tempItem->position = driver.getPosition(@2);
 
-        $$ = tempItem;
+            $1->next = tempItem;
+            tempItem->startPoint = $1->startPoint;
+
+            $$ = tempItem;
+        }
     }
 |
     replace_rule
@@ -170,6 +205,12 @@ part:
         $1->startPoint = $1;
         $$ = $1;
     }
+|
+    include_rule
+    {
+        $1->startPoint = $1;
+        $$ = $1;
+    }
 |
     if_condition_start part if_condition_end
     {
@@ -185,6 +226,7 @@ part:
         IfItem* tempItem = dynamic_cast<IfItem*>($1);
         tempItem->ifChild = $2->startPoint;
         tempItem->elseChild = $4->startPoint;
+        tempItem->elsePosition = $3;
         tempItem->startPoint = tempItem;
         $$ = tempItem;
     }
@@ -193,184 +235,140 @@ part:
     {
         ForLoopItem* tempItem = dynamic_cast<ForLoopItem*>($1);
         tempItem->forChild = $2->startPoint;
+        tempItem->endPosition = $3;
         tempItem->startPoint = tempItem;
         $$ = tempItem;
     }
 |
-    defaultroute
+    "text"
     {
-        TextItem* tempItem = new TextItem();
+        TextItem* tempItem = driver.createItem<TextItem>();
         tempItem->text = $1;
+        tempItem->position = driver.getPosition(@1);
         tempItem->startPoint = tempItem;
         $$ = tempItem;
     }
 
 replace_rule:
-    "{{" blancs json_path blancs "}}"
+    "{{" json_path "}}"
     {
-        ReplaceItem* result = new ReplaceItem();
-        result->iterateArray = *$3;
+        ReplaceItem* result = driver.createItem<ReplaceItem>();
+        result->iterateArray = $2;
+        result->position = driver.getPosition(@1);
         $$ = result;
     }
 
-if_condition_start:
-    "{%" blancs "if" blancs json_path blancs "is" blancs "identifier" blancs "%}"
+include_rule:
+    "{%" "include" "string" "%}"
     {
-        IfItem* result = new IfItem();
-        result->leftSide = *$5;
-        result->rightSide = DataValue($9);
+        IncludeItem* result = driver.createItem<IncludeItem>();
+        result->name = $3;
+        result->position = driver.getPosition(@1);
         $$ = result;
     }
-|
-    "{%" blancs "if" blancs json_path blancs "is" blancs "number" blancs "%}"
+
+if_condition_start:
+    "{%" "if" json_path compare_type "identifier" "%}"
     {
-        IfItem* result = new IfItem();
-        result->leftSide = *$5;
-        result->rightSide = DataValue($9);
+        IfItem* result = driver.createItem<IfItem>();
+        result->position = driver.getPosition(@1);
+        result->leftSide = $3;
+        result->ifType = $4;
+        result->rightSide = DataValue($5);
         $$ = result;
     }
 |
-    "{%" blancs "if" blancs json_path blancs "%}"
-    {
-        IfItem* result = new IfItem();
-        result->leftSide = *$5;
-        result->rightSide = DataValue(true);
-        $$ = result;
-    }
-
-if_condition_else:
-   "{%" blancs "else" blancs "%}"
-
-if_condition_end:
-   "{%" blancs "endif" blancs "%}"
-
-for_loop_start:
-    "{%" blancs "for" blancs "identifier" blancs "in" blancs json_path blancs "%}"
+    "{%" "if" json_path compare_type "number" "%}"
     {
-        ForLoopItem* result = new ForLoopItem();
-        result->tempVarName = $5;
-        result->iterateArray = *$9;
+        IfItem* result = driver.createItem<IfItem>();
+        result->position = driver.getPosition(@1);
+        result->leftSide = $3;
+        result->ifType = $4;
+        result->rightSide = DataValue($5);
         $$ = result;
     }
-
-for_loop_end:
-    "{%" blancs "endfor" blancs "%}"
-
-json_path:
-    json_path "." "identifier"
-    {
-        $1->append(new DataValue($3));
-        $$ = $1;
-    }
 |
-    "identifier"
+    "{%" "if" json_path "%}"
     {
-        DataArray* tempItem = new DataArray();
-        tempItem->append(new DataValue($1));
-        $$ = tempItem;
+        IfItem* result = driver.createItem<IfItem>();
+        result->position = driver.getPosition(@1);
+        result->leftSide = $3;
+        result->ifType = IfItem::IS_TRUE;
+        result->rightSide = DataValue(true);
+        $$ = result;
     }
 
-defaultroute:
-    linebreaks
-    {
-        $$ = $1;
-    }
-|
-    "in"
-    {
-        $$ = "in";
-    }
-|
+compare_type:
     "is"
     {
-        $$ = "is";
-    }
-|
-    "for"
-    {
-        $$ = "for";
+        $$ = IfItem::EQUAL;
     }
 |
-    "if"
+    "=="
     {
-        $$ = "if";
+        $$ = IfItem::EQUAL;
     }
 |
-    "endfor"
+    "!="
     {
-        $$ = "endfor";
+        $$ = IfItem::UNEQUAL;
     }
 |
-    "else"
+    ">="
     {
-        $$ = "else";
+        $$ = IfItem::GREATER_EQUAL;
     }
 |
-    "endif"
+    ">"
     {
-        $$ = "endif";
+        $$ = IfItem::GREATER;
     }
 |
-    "["
+    "<="
     {
-        $$ = "[";
+        $$ = IfItem::SMALLER_EQUAL;
     }
 |
-    "]"
+    "<"
     {
-        $$ = "]";
-    }
-|
-    "."
-    {
-        $$ = ".";
-    }
-|
-    "number"
-    {
-        $$ = std::to_string($1);
-    }
-|
-    "identifier"
-    {
-        $$ = $1;
-    }
-|
-    "defaultrule"
-    {
-        $$ = $1;
-    }
-|
-    blancs
-    {
-        $$ = $1;
+        $$ = IfItem::SMALLER;
     }
 
-blancs:
-    blancs " "
+if_condition_else:
+   "{%" "else" "%}"
     {
-        $$ = $1 + " ";
+        $$ = driver.getPosition(@1);
     }
-|
-    " "
+
+if_condition_end:
+   "{%" "endif" "%}"
+
+for_loop_start:
+    "{%" "for" "identifier" "in" json_path "%}"
     {
-        $$ = std::string(" ");
+        ForLoopItem* result = driver.createItem<ForLoopItem>();
+        result->position = driver.getPosition(@1);
+        result->tempVarName = $3;
+        result->iterateArray = $5;
+        $$ = result;
     }
-|
-    %empty
+
+for_loop_end:
+    "{%" "endfor" "%}"
     {
-        $$ = std::string();
+        $$ = driver.getPosition(@1);
     }
 
-linebreaks:
-    linebreaks "\n"
+json_path:
+    json_path "." "identifier"
     {
-        $$ = $1 + "\n";
+        driver.appendToPath($1, $3);
+        $$ = $1;
     }
 |
-    "\n"
+    "identifier"
     {
-        $$ = std::string("\n");
+        $$ = driver.createPath($1);
     }
 %%
 
@@ -0,0 +1,241 @@
+/**
+ *  @file    jinja2_arena.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_ARENA_H
+#define JINJA2_ARENA_H
+
+#include <stdint.h>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+//===================================================================
+// Jinja2Arena
+//===================================================================
+/**
+ * Bump-allocator for the objects of one parsing-run. Memory is requested in big blocks and all
+ * objects are freed at once, when the arena is cleared or deleted.
+ */
+class Jinja2Arena
+{
+public:
+    Jinja2Arena(const uint64_t blockSize = 16 * 1024);
+    ~Jinja2Arena();
+
+    // the blocks are owned by the arena, so a copy would free them twice
+    Jinja2Arena(const Jinja2Arena &other) = delete;
+    Jinja2Arena &operator=(const Jinja2Arena &other) = delete;
+
+    void* allocate(const uint64_t size,
+                   const uint64_t alignment);
+    const char* copyString(const char* data,
+                           const uint64_t size);
+    void clear();
+
+    /**
+     * @brief create a new object within the arena. The destructor of the object is called,
+     *        when the arena is cleared.
+     *
+     * @param args arguments for the constructor of the object
+     *
+     * @return pointer to the new object
+     */
+    template<typename T, typename... ARGS>
+    T* create(ARGS&&... args)
+    {
+        void* memory = allocate(sizeof(T), alignof(T));
+        T* object = new(memory) T(std::forward<ARGS>(args)...);
+
+        if(std::is_trivially_destructible<T>::value == false) {
+            registerDestructor(object, &destroyObject<T>);
+        }
+
+        return object;
+    }
+
+private:
+    // header of each memory-block, followed by the usable memory of the block
+    struct Block
+    {
+        Block* next = nullptr;
+        uint64_t size = 0;
+    };
+
+    // destructors are stored within the arena as linked list too
+    struct Destructor
+    {
+        void* object = nullptr;
+        void (*function)(void*) = nullptr;
+        Destructor* next = nullptr;
+    };
+
+    uint64_t m_blockSize = 0;
+    Block* m_blocks = nullptr;
+    uint8_t* m_currentPos = nullptr;
+    uint8_t* m_currentEnd = nullptr;
+    Destructor* m_destructors = nullptr;
+
+    void addBlock(const uint64_t minSize);
+    void registerDestructor(void* object,
+                            void (*function)(void*));
+
+    template<typename T>
+    static void destroyObject(void* object)
+    {
+        static_cast<T*>(object)->~T();
+    }
+};
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param blockSize default-size of the memory-blocks
+ */
+inline
+Jinja2Arena::Jinja2Arena(const uint64_t blockSize)
+{
+    m_blockSize = blockSize;
+}
+
+/**
+ * @brief destructor
+ */
+inline
+Jinja2Arena::~Jinja2Arena()
+{
+    clear();
+}
+
+/**
+ * @brief get memory from the arena
+ *
+ * @param size number of requested bytes
+ * @param alignment alignment of the requested memory. Must be a power of 2.
+ *
+ * @return pointer to the memory
+ */
+inline void*
+Jinja2Arena::allocate(const uint64_t size,
+                      const uint64_t alignment)
+{
+    uintptr_t pos = reinterpret_cast<uintptr_t>(m_currentPos);
+    pos = (pos + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+
+    if(m_currentPos == nullptr
+            || pos + size > reinterpret_cast<uintptr_t>(m_currentEnd))
+    {
+        addBlock(size + alignment);
+        pos = reinterpret_cast<uintptr_t>(m_currentPos);
+        pos = (pos + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    }
+
+    m_currentPos = reinterpret_cast<uint8_t*>(pos + size);
+
+    return reinterpret_cast<void*>(pos);
+}
+
+/**
+ * @brief copy a string into the arena
+ *
+ * @param data pointer to the string
+ * @param size length of the string
+ *
+ * @return pointer to the null-terminated copy within the arena
+ */
+inline const char*
+Jinja2Arena::copyString(const char* data,
+                        const uint64_t size)
+{
+    char* result = static_cast<char*>(allocate(size + 1, 1));
+    memcpy(result, data, size);
+    result[size] = '\0';
+
+    return result;
+}
+
+/**
+ * @brief call the destructors of all objects of the arena and free all memory-blocks
+ */
+inline void
+Jinja2Arena::clear()
+{
+    // objects are destroyed in reverse order of creation
+    Destructor* destructor = m_destructors;
+    while(destructor != nullptr)
+    {
+        destructor->function(destructor->object);
+        destructor = destructor->next;
+    }
+    m_destructors = nullptr;
+
+    Block* block = m_blocks;
+    while(block != nullptr)
+    {
+        Block* next = block->next;
+        delete[] reinterpret_cast<uint8_t*>(block);
+        block = next;
+    }
+
+    m_blocks = nullptr;
+    m_currentPos = nullptr;
+    m_currentEnd = nullptr;
+}
+
+/**
+ * @brief add a new memory-block to the arena
+ *
+ * @param minSize minimum number of usable bytes in the new block
+ */
+inline void
+Jinja2Arena::addBlock(const uint64_t minSize)
+{
+    uint64_t size = m_blockSize;
+    if(minSize > size) {
+        size = minSize;
+    }
+
+    uint8_t* memory = new uint8_t[sizeof(Block) + size];
+    Block* block = new(memory) Block();
+    block->size = size;
+    block->next = m_blocks;
+    m_blocks = block;
+
+    m_currentPos = memory + sizeof(Block);
+    m_currentEnd = m_currentPos + size;
+}
+
+/**
+ * @brief register the destructor of an object, which is called when the arena is cleared
+ *
+ * @param object pointer to the object
+ * @param function destructor-function for the object
+ */
+inline void
+Jinja2Arena::registerDestructor(void* object,
+                                void (*function)(void*))
+{
+    void* memory = allocate(sizeof(Destructor), alignof(Destructor));
+    Destructor* destructor = new(memory) Destructor();
+    destructor->object = object;
+    destructor->function = function;
+    destructor->next = m_destructors;
+    m_destructors = destructor;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_ARENA_H
@@ -0,0 +1,377 @@
+/**
+ *  @file    jinja2_bytecode.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_BYTECODE_H
+#define JINJA2_BYTECODE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include <jinja2_items.h>
+#include <jinja2_profiler.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Template;
+struct Jinja2ContextIndex;
+
+//===================================================================
+// Jinja2OpCode
+//===================================================================
+enum Jinja2OpCode : uint32_t
+{
+    // append text of the string-pool to the output
+    // arg0 = offset within the string-pool, arg1 = length of the text
+    EMIT_TEXT = 0,
+
+    // append the value of a path within the input to the output
+    // arg0 = id of the path
+    EMIT_VAR = 1,
+
+    // continue behind the instruction, if the condition is true, else jump
+    // arg0 = id of the condition, arg1 = jump-target
+    JUMP_IF_FALSE = 2,
+
+    // unconditional jump
+    // arg1 = jump-target
+    JUMP = 3,
+
+    // start a new loop over an array of the input, or jump behind the loop, if the array is empty
+    // arg0 = id of the path of the array, arg1 = jump-target behind the loop,
+    // arg2 = id of the key with the name of the loop-variable
+    LOOP_BEGIN = 4,
+
+    // go to the next element of the current loop and jump back to the begin of the loop-body,
+    // or remove the loop, if all elements of the array were processed
+    // arg1 = jump-target at the begin of the loop-body
+    LOOP_NEXT = 5,
+
+    // render a shared compiled template with the same input and the active loop-variables
+    // arg0 = id of the include within the bytecode
+    INCLUDE = 6
+};
+
+// All structs, which are referenced by the views of the bytecode, have a fixed layout without
+// pointers, so they can be written into a bundle-file and used directly from the mapped file.
+
+//===================================================================
+// Jinja2Instruction
+//===================================================================
+struct Jinja2Instruction
+{
+    Jinja2OpCode opCode = EMIT_TEXT;
+    uint32_t arg0 = 0;
+    uint32_t arg1 = 0;
+    uint32_t arg2 = 0;
+};
+
+//===================================================================
+// Jinja2Key
+//===================================================================
+struct Jinja2Key
+{
+    uint64_t hash = 0;
+    // name of the key within the string-pool, null-terminated
+    uint32_t nameOffset = 0;
+    uint32_t length = 0;
+};
+
+//===================================================================
+// Jinja2CompiledPath
+//===================================================================
+struct Jinja2CompiledPath
+{
+    // position of the first key-id within the path-segments of the bytecode
+    uint32_t firstSegment = 0;
+    uint32_t numberOfSegments = 0;
+};
+
+//===================================================================
+// Jinja2Condition
+//===================================================================
+enum Jinja2ConstantType : uint32_t
+{
+    STRING_CONSTANT = 0,
+    INT_CONSTANT = 1,
+    // identifiers "true", "True", "false" and "False", which are also compared as strings
+    BOOL_CONSTANT = 2
+};
+
+struct Jinja2Condition
+{
+    uint32_t pathId = 0;
+    uint32_t compareType = IfItem::EQUAL;
+
+    // right side of the condition is converted only once at compile-time
+    uint32_t constantType = STRING_CONSTANT;
+    uint32_t boolValue = 0;
+    int64_t longValue = 0;
+
+    // text of the right side within the string-pool, null-terminated
+    uint32_t textOffset = 0;
+    uint32_t textLength = 0;
+};
+
+//===================================================================
+// Jinja2SourceLocation
+//===================================================================
+struct Jinja2SourceLocation
+{
+    // line and column of the tag or text within the template-string, starting with 1
+    uint32_t line = 0;
+    uint32_t column = 0;
+};
+
+//===================================================================
+// Jinja2Segment
+//===================================================================
+// top-level part of a template, which can be rendered independent of the other parts,
+// because no jump and no loop leaves its range of instructions
+struct Jinja2Segment
+{
+    uint32_t firstInstruction = 0;
+    uint32_t endInstruction = 0;
+
+    // position of the first path-id within the segment-dependencies of the bytecode
+    uint32_t firstDependency = 0;
+    uint32_t numberOfDependencies = 0;
+};
+
+//===================================================================
+// Jinja2Splice
+//===================================================================
+// templates with only text and replacements are rendered as list of splices, where each
+// splice is a text followed by the value of a path
+const uint32_t NO_SPLICE_PATH = UINT32_MAX;
+
+struct Jinja2Splice
+{
+    // text within the string-pool, can be empty
+    uint32_t textOffset = 0;
+    uint32_t textLength = 0;
+
+    // id of the path, or NO_SPLICE_PATH for the text at the end of the template
+    uint32_t pathId = NO_SPLICE_PATH;
+};
+
+//===================================================================
+// Jinja2Include
+//===================================================================
+// included templates are compiled only once and shared between all templates, which include
+// them, so they can not be written into bundle-files
+struct Jinja2Include
+{
+    std::shared_ptr<Jinja2Template> includedTemplate;
+
+    // key-id within the included template for each key of this template, or UINT32_MAX, so
+    // the loop-variables can be forwarded into the included template
+    std::vector<uint32_t> keyMapping;
+
+    // ids of the paths within this template, which are read by the included template
+    std::vector<uint32_t> dependencies;
+};
+
+//===================================================================
+// Jinja2LoopFrame
+//===================================================================
+// loop-variables are bound within the frames of the active loops and not within the input, so
+// the input is never modified while rendering
+struct Jinja2LoopFrame
+{
+    DataArray* array = nullptr;
+    DataItem* value = nullptr;
+    uint64_t index = 0;
+    uint32_t keyId = 0;
+};
+
+//===================================================================
+// Jinja2SharedBudget
+//===================================================================
+// limits of all chunks of a parallel loop together. Each chunk adds its output and iterations
+// to the counters, and all chunks stop, when one of them has failed.
+struct Jinja2SharedBudget
+{
+    // number of bytes, which a chunk renders between two updates of the output-counter
+    static const uint64_t CHECK_STEP = 16 * 1024;
+
+    std::atomic<uint64_t> outputSize;
+    std::atomic<uint64_t> iterations;
+    std::atomic<bool> cancelled;
+
+    // first output-size of all chunks together, which is too big, and the maximum number of
+    // iterations of all chunks together
+    uint64_t outputLimit = UINT64_MAX;
+    uint64_t remainingIterations = UINT64_MAX;
+
+    Jinja2SharedBudget()
+        : outputSize(0),
+          iterations(0),
+          cancelled(false) {}
+};
+
+//===================================================================
+// Jinja2RenderBudget
+//===================================================================
+// remaining limits of a single render. The output-limit is the first size of the output-buffer,
+// which is too big, and it is moved back by the bytes, which are flushed out of the buffer.
+struct Jinja2RenderBudget
+{
+    uint64_t outputLimit = UINT64_MAX;
+    uint64_t remainingIterations = UINT64_MAX;
+
+    // configured limits for the error-messages
+    uint64_t maxOutputSize = 0;
+    uint64_t maxLoopIterations = 0;
+
+    // shared budget, if the render is a chunk of a parallel loop, else nullptr. The
+    // output-limit of a chunk is then the size, where the shared budget is updated next.
+    Jinja2SharedBudget* shared = nullptr;
+    uint64_t reportedSize = 0;
+};
+
+//===================================================================
+// Jinja2ResumeState
+//===================================================================
+// position of a resumable render within one template. Each include gets its own frame on top
+// of the frame of the including template.
+struct Jinja2ResumeFrame
+{
+    const Jinja2Template* compiledTemplate = nullptr;
+    uint32_t pos = 0;
+    std::vector<Jinja2LoopFrame> loops;
+};
+
+struct Jinja2ResumeState
+{
+    std::vector<Jinja2ResumeFrame> frames;
+    Jinja2RenderBudget budget;
+
+    // index of a prepared context, or nullptr to search in the input
+    const Jinja2ContextIndex* contextIndex = nullptr;
+
+    // counters and time of the started template, which are added to its profile, when the
+    // render is finished. Like in normal renders, included templates are not profiled.
+    std::vector<Jinja2InstructionCounters> counters;
+    uint64_t renderTime = 0;
+};
+
+// point, where a range of instructions is paused, so a resumable render can be continued there
+struct Jinja2PausePoint
+{
+    // size of the output, where the range is paused behind the current instruction
+    uint64_t pauseSize = UINT64_MAX;
+
+    // position of the next instruction and the id of a reached include, else UINT32_MAX
+    uint32_t pos = 0;
+    uint32_t includeId = UINT32_MAX;
+};
+
+//===================================================================
+// Jinja2BytecodeStorage
+//===================================================================
+struct Jinja2BytecodeStorage
+{
+    std::vector<Jinja2Instruction> instructions;
+
+    // one string for the literal text of all EMIT_TEXT-instructions, the names of the keys
+    // and the texts of the conditions
+    std::string stringPool = "";
+
+    // all names of path-segments and loop-variables are interned as keys, so each name
+    // exist only once within the bytecode and paths are only lists of key-ids
+    std::vector<Jinja2Key> keys;
+    std::vector<uint32_t> pathSegments;
+    std::vector<Jinja2CompiledPath> paths;
+
+    std::vector<Jinja2Condition> conditions;
+
+    // location of the source of each instruction, which is only used for the profiling-output
+    // and not written into bundle-files
+    std::vector<Jinja2SourceLocation> sourceLocations;
+};
+
+//===================================================================
+// Jinja2Bytecode
+//===================================================================
+struct Jinja2Bytecode
+{
+    // views, which are used while rendering. They point into the storage of a new compiled
+    // template or into the memory of a mapped bundle-file.
+    const Jinja2Instruction* instructions = nullptr;
+    const char* stringPool = nullptr;
+    const Jinja2Key* keys = nullptr;
+    const uint32_t* pathSegments = nullptr;
+    const Jinja2CompiledPath* paths = nullptr;
+    const Jinja2Condition* conditions = nullptr;
+
+    uint32_t numberOfInstructions = 0;
+    uint32_t stringPoolSize = 0;
+    uint32_t numberOfKeys = 0;
+    uint32_t numberOfPathSegments = 0;
+    uint32_t numberOfPaths = 0;
+    uint32_t numberOfConditions = 0;
+
+    uint32_t maxNestingDepth = 0;
+
+    // number of bytes of all literal text of the template
+    uint64_t literalSize = 0;
+
+    // names of the keys as strings, because the data-items of the input can only be searched
+    // with strings
+    std::vector<std::string> keyNames;
+
+    // paths with dots as separator and their hashes, so they can be searched within the index
+    // of a prepared context with only one probe
+    std::vector<std::string> pathNames;
+    std::vector<uint64_t> pathHashes;
+
+    // top-level segments and the ids of the paths within the input, which are read by each
+    // segment. They are derived from the instructions and so not part of bundle-files.
+    std::vector<Jinja2Segment> segments;
+    std::vector<uint32_t> segmentDependencies;
+
+    std::vector<Jinja2Include> includes;
+
+    // flat list of text and paths for templates with only text and replacements, which are
+    // rendered without the interpreter. Empty for all other templates.
+    std::vector<Jinja2Splice> splices;
+
+    // memory behind the views
+    Jinja2BytecodeStorage storage;
+    std::shared_ptr<const void> mappedFile;
+
+    /**
+     * @brief let the views point to the storage of the bytecode
+     */
+    void useStorage()
+    {
+        instructions = storage.instructions.data();
+        stringPool = storage.stringPool.c_str();
+        keys = storage.keys.data();
+        pathSegments = storage.pathSegments.data();
+        paths = storage.paths.data();
+        conditions = storage.conditions.data();
+
+        numberOfInstructions = static_cast<uint32_t>(storage.instructions.size());
+        stringPoolSize = static_cast<uint32_t>(storage.stringPool.size());
+        numberOfKeys = static_cast<uint32_t>(storage.keys.size());
+        numberOfPathSegments = static_cast<uint32_t>(storage.pathSegments.size());
+        numberOfPaths = static_cast<uint32_t>(storage.paths.size());
+        numberOfConditions = static_cast<uint32_t>(storage.conditions.size());
+    }
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_BYTECODE_H
@@ -0,0 +1,523 @@
+/**
+ *  @file    jinja2_code_generator.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <jinja2_code_generator.h>
+
+#include <jinja2_bytecode.h>
+#include <jinja2_condition.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief constructor
+ */
+Jinja2CodeGenerator::Jinja2CodeGenerator() {}
+
+/**
+ * @brief destructor
+ */
+Jinja2CodeGenerator::~Jinja2CodeGenerator() {}
+
+/**
+ * @brief write the includes, which are necessary for the generated functions
+ *
+ * @param code reference for the generated code
+ */
+void
+Jinja2CodeGenerator::generateFileHeader(std::string &code)
+{
+    code += "// generated by jinja2c - do not edit\n";
+    code += "\n";
+    code += "#include <libKitsunemimiJinja2/jinja2_generated.h>\n";
+    code += "\n";
+    code += "#include <stdint.h>\n";
+    code += "#include <string>\n";
+    code += "\n";
+    code += "using Kitsunemimi::Jinja2::appendGeneratedValue;\n";
+    code += "using Kitsunemimi::Jinja2::evaluateGeneratedCondition;\n";
+    code += "using Kitsunemimi::Jinja2::createGeneratedErrorMessage;\n";
+}
+
+/**
+ * @brief convert a parsed template into a C++-function with the signature of
+ *        Jinja2GeneratedFunction. Text becomes constant char-arrays, replacements direct
+ *        lookups within the input and if-conditions and for-loops native control-flow. The
+ *        function is registered with the template-string at the start of the program.
+ *
+ * @param root root of the parsed item-tree, nullptr for an empty template
+ * @param templateString parsed template-string
+ * @param functionName name of the generated function
+ * @param templateId unique id of the template within the generated file
+ * @param code reference for the generated code
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the template contains items, which can not be generated, else true
+ */
+bool
+Jinja2CodeGenerator::generate(Jinja2Item* root,
+                              const std::string &templateString,
+                              const std::string &functionName,
+                              const uint32_t templateId,
+                              std::string &code,
+                              std::string &errorMessage)
+{
+    m_prefix = "T" + std::to_string(templateId) + "_";
+    m_constants = "";
+    m_body = "";
+    m_keyConstants.clear();
+    m_numberOfTexts = 0;
+    m_numberOfVariables = 0;
+    m_loopVariables.clear();
+
+    if(generateItem(root, "    ", errorMessage) == false)
+    {
+        m_constants.clear();
+        m_body.clear();
+        return false;
+    }
+
+    const std::string templateConstant = m_prefix + "TEMPLATE";
+
+    code += "\n";
+    code += "//==================================================================================\n";
+    code += "// " + functionName + "\n";
+    code += "//==================================================================================\n";
+    code += "namespace\n";
+    code += "{\n";
+    code += "const char " + templateConstant + "[] =\n";
+    code += createStringLiteral(templateString, "    ") + ";\n";
+    code += m_constants;
+    code += "}\n";
+    code += "\n";
+    code += "bool\n";
+    code += functionName + "(Kitsunemimi::DataMap* input,\n";
+    code += std::string(functionName.size() + 1, ' ') + "std::string &output,\n";
+    code += std::string(functionName.size() + 1, ' ') + "std::string &errorMessage)\n";
+    code += "{\n";
+    code += "    (void)input;\n";
+    code += "    (void)errorMessage;\n";
+    code += m_body;
+    code += "    return true;\n";
+    code += "}\n";
+    code += "\n";
+    code += "namespace\n";
+    code += "{\n";
+    code += "const bool " + m_prefix + "REGISTERED =\n";
+    code += "    Kitsunemimi::Jinja2::registerGeneratedTemplate(" + templateConstant + ",\n";
+    code += "                                                   sizeof(" + templateConstant + ") - 1,\n";
+    code += "                                                   &" + functionName + ");\n";
+    code += "}\n";
+
+    m_constants.clear();
+    m_body.clear();
+
+    return true;
+}
+
+/**
+ * @brief generate the code for a list of parsed items
+ *
+ * @param part first item of the list
+ * @param indent indentation of the generated code
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if an item can not be generated, else true
+ */
+bool
+Jinja2CodeGenerator::generateItem(Jinja2Item* part,
+                                  const std::string &indent,
+                                  std::string &errorMessage)
+{
+    while(part != nullptr)
+    {
+        switch(part->getType())
+        {
+            //------------------------------------------------------
+            case Jinja2Item::TEXT_ITEM:
+            {
+                generateText(static_cast<TextItem*>(part)->text, indent);
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::REPLACE_ITEM:
+            {
+                generateReplace(static_cast<ReplaceItem*>(part), indent);
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::IF_ITEM:
+            {
+                if(generateIfCondition(static_cast<IfItem*>(part), indent, errorMessage) == false) {
+                    return false;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::FOR_ITEM:
+            {
+                if(generateForLoop(static_cast<ForLoopItem*>(part), indent, errorMessage) == false) {
+                    return false;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::INCLUDE_ITEM:
+            {
+                // included templates are loaded at runtime, so they can not be generated
+                errorMessage =  "error while generating code \n";
+                errorMessage += "    templates with includes can not be converted into code \n";
+                return false;
+            }
+            //------------------------------------------------------
+            default:
+            {
+                // a function, which silently drops a part of the output, is never generated
+                errorMessage =  "error while generating code \n";
+                errorMessage += "    unknown item-type ";
+                errorMessage += std::to_string(static_cast<uint32_t>(part->getType()));
+                errorMessage += " within the template \n";
+                return false;
+            }
+        }
+
+        part = part->next;
+    }
+
+    return true;
+}
+
+/**
+ * @brief generate a constant char-array for a text and the code to append it
+ *
+ * @param text text of the template
+ * @param indent indentation of the generated code
+ */
+void
+Jinja2CodeGenerator::generateText(const std::string &text,
+                                  const std::string &indent)
+{
+    if(text.size() == 0) {
+        return;
+    }
+
+    const std::string name = m_prefix + "TEXT_" + std::to_string(m_numberOfTexts);
+    m_numberOfTexts++;
+
+    m_constants += "const char " + name + "[] =\n";
+    m_constants += createStringLiteral(text, "    ") + ";\n";
+
+    m_body += indent + "output.append(" + name + ", sizeof(" + name + ") - 1);\n";
+}
+
+/**
+ * @brief generate the lookup of a replacement and the code to append its value
+ *
+ * @param replaceItem item to generate
+ * @param indent indentation of the generated code
+ */
+void
+Jinja2CodeGenerator::generateReplace(ReplaceItem* replaceItem,
+                                     const std::string &indent)
+{
+    m_body += indent + "{\n";
+    const std::string value = generatePath(replaceItem->iterateArray, indent + "    ");
+    m_body += indent + "    appendGeneratedValue(output, " + value + ");\n";
+    m_body += indent + "}\n";
+}
+
+/**
+ * @brief generate an if-condition with a constant right side, which is converted already here
+ *
+ * @param ifItem item to generate
+ * @param indent indentation of the generated code
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if an item of the branches can not be generated, else true
+ */
+bool
+Jinja2CodeGenerator::generateIfCondition(IfItem* ifItem,
+                                         const std::string &indent,
+                                         std::string &errorMessage)
+{
+    Jinja2Condition condition;
+    condition.compareType = ifItem->ifType;
+    const std::string text = ifItem->rightSide.toString();
+    initConditionConstant(condition, text, ifItem->rightSide);
+
+    m_body += indent + "{\n";
+    const std::string value = generatePath(ifItem->leftSide, indent + "    ");
+
+    // the minimum value can not be written as negative literal
+    std::string longValue = std::to_string(condition.longValue) + "LL";
+    if(condition.longValue == INT64_MIN) {
+        longValue = "(-9223372036854775807LL - 1)";
+    }
+
+    m_body += indent + "    if(evaluateGeneratedCondition(" + value + ", "
+              + std::to_string(condition.compareType) + ", "
+              + std::to_string(condition.constantType) + ", "
+              + longValue + ", "
+              + (condition.boolValue != 0 ? "true" : "false") + ", "
+              + createStringLiteral(text, "") + "))\n";
+    m_body += indent + "    {\n";
+    if(generateItem(ifItem->ifChild, indent + "        ", errorMessage) == false) {
+        return false;
+    }
+    m_body += indent + "    }\n";
+
+    if(ifItem->elseChild != nullptr)
+    {
+        m_body += indent + "    else\n";
+        m_body += indent + "    {\n";
+        if(generateItem(ifItem->elseChild, indent + "        ", errorMessage) == false) {
+            return false;
+        }
+        m_body += indent + "    }\n";
+    }
+
+    m_body += indent + "}\n";
+
+    return true;
+}
+
+/**
+ * @brief generate a native loop over an array of the input
+ *
+ * @param forLoopItem item to generate
+ * @param indent indentation of the generated code
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if an item of the loop-body can not be generated, else true
+ */
+bool
+Jinja2CodeGenerator::generateForLoop(ForLoopItem* forLoopItem,
+                                     const std::string &indent,
+                                     std::string &errorMessage)
+{
+    m_body += indent + "{\n";
+    const std::string value = generatePath(forLoopItem->iterateArray, indent + "    ");
+
+    const std::string id = std::to_string(m_numberOfVariables);
+    m_numberOfVariables++;
+    const std::string array = "array" + id;
+    const std::string index = "index" + id;
+    const std::string element = "element" + id;
+
+    m_body += indent + "    if(" + value + "->getType() != Kitsunemimi::DataItem::ARRAY_TYPE)\n";
+    m_body += indent + "    {\n";
+    m_body += indent + "        createGeneratedErrorMessage(errorMessage, "
+              + createStringLiteral(getPathString(forLoopItem->iterateArray), "") + ");\n";
+    m_body += indent + "        return false;\n";
+    m_body += indent + "    }\n";
+    m_body += indent + "    Kitsunemimi::DataArray* " + array + " = " + value + "->toArray();\n";
+    m_body += indent + "    for(uint64_t " + index + " = 0; "
+              + index + " < " + array + "->size(); "
+              + index + "++)\n";
+    m_body += indent + "    {\n";
+    m_body += indent + "        Kitsunemimi::DataItem* " + element
+              + " = " + array + "->get(" + index + ");\n";
+
+    m_loopVariables.push_back(std::make_pair(forLoopItem->tempVarName, element));
+    const bool success = generateItem(forLoopItem->forChild, indent + "        ", errorMessage);
+    m_loopVariables.pop_back();
+    if(success == false) {
+        return false;
+    }
+
+    m_body += indent + "    }\n";
+    m_body += indent + "}\n";
+
+    return true;
+}
+
+/**
+ * @brief generate the lookup of a path within the loop-variables or the input and the
+ *        error-handling, if the path doesn't exist
+ *
+ * @param jsonPath path of the parser
+ * @param indent indentation of the generated code
+ *
+ * @return name of the variable with the found item
+ */
+const std::string
+Jinja2CodeGenerator::generatePath(Jinja2Path* jsonPath,
+                                  const std::string &indent)
+{
+    const std::string value = "value" + std::to_string(m_numberOfVariables);
+    m_numberOfVariables++;
+
+    // the innermost loop-variable with the name of the first segment shadows the outer
+    // loops and the input
+    Jinja2PathSegment* segment = jsonPath->first;
+    const std::string firstName(segment->name, segment->length);
+
+    std::string source = "";
+    for(uint64_t i = m_loopVariables.size(); i > 0; i--)
+    {
+        if(m_loopVariables[i - 1].first == firstName)
+        {
+            source = m_loopVariables[i - 1].second;
+            break;
+        }
+    }
+
+    if(source == "")
+    {
+        source = "input->get(" + getKeyConstant(firstName) + ")";
+    }
+    m_body += indent + "Kitsunemimi::DataItem* " + value + " = " + source + ";\n";
+
+    segment = segment->next;
+    while(segment != nullptr)
+    {
+        const std::string key = getKeyConstant(std::string(segment->name, segment->length));
+        m_body += indent + "if(" + value + " != nullptr) {\n";
+        m_body += indent + "    " + value + " = " + value + "->get(" + key + ");\n";
+        m_body += indent + "}\n";
+        segment = segment->next;
+    }
+
+    m_body += indent + "if(" + value + " == nullptr)\n";
+    m_body += indent + "{\n";
+    m_body += indent + "    createGeneratedErrorMessage(errorMessage, "
+              + createStringLiteral(getPathString(jsonPath), "") + ");\n";
+    m_body += indent + "    return false;\n";
+    m_body += indent + "}\n";
+
+    return value;
+}
+
+/**
+ * @brief get the constant for a key. Each key exists only once for each template.
+ *
+ * @param name name of the key
+ *
+ * @return name of the constant
+ */
+const std::string
+Jinja2CodeGenerator::getKeyConstant(const std::string &name)
+{
+    auto it = m_keyConstants.find(name);
+    if(it != m_keyConstants.end()) {
+        return it->second;
+    }
+
+    const std::string constant = m_prefix + "KEY_" + std::to_string(m_keyConstants.size());
+    m_constants += "const std::string " + constant + "(" + createStringLiteral(name, "") + ");\n";
+    m_keyConstants.insert(std::make_pair(name, constant));
+
+    return constant;
+}
+
+/**
+ * @brief convert a path into a string with dots between the segments
+ *
+ * @param jsonPath path of the parser
+ *
+ * @return path as string
+ */
+const std::string
+Jinja2CodeGenerator::getPathString(Jinja2Path* jsonPath)
+{
+    std::string result = "";
+    Jinja2PathSegment* segment = jsonPath->first;
+    while(segment != nullptr)
+    {
+        if(segment != jsonPath->first) {
+            result += ".";
+        }
+        result.append(segment->name, segment->length);
+        segment = segment->next;
+    }
+
+    return result;
+}
+
+/**
+ * @brief convert a text into a C++-string-literal. Long texts are split into multiple
+ *        literals, one for each line of the text.
+ *
+ * @param text text to convert
+ * @param indent indentation of the literals, if the text is split. An empty indentation
+ *               returns the text as single literal.
+ *
+ * @return string-literal
+ */
+const std::string
+Jinja2CodeGenerator::createStringLiteral(const std::string &text,
+                                         const std::string &indent)
+{
+    std::string result = indent + "\"";
+    uint64_t lineLength = 0;
+
+    for(uint64_t i = 0; i < text.size(); i++)
+    {
+        const unsigned char character = static_cast<unsigned char>(text[i]);
+        switch(character)
+        {
+            case '\\':
+                result += "\\\\";
+                break;
+            case '"':
+                result += "\\\"";
+                break;
+            case '?':
+                // avoid trigraphs
+                result += "\\?";
+                break;
+            case '\n':
+                result += "\\n";
+                break;
+            case '\t':
+                result += "\\t";
+                break;
+            case '\r':
+                result += "\\r";
+                break;
+            default:
+            {
+                if(character < 0x20 || character >= 0x7F)
+                {
+                    // always three octal digits, so following digits are not part of it
+                    char escaped[5];
+                    escaped[0] = '\\';
+                    escaped[1] = static_cast<char>('0' + ((character >> 6) & 7));
+                    escaped[2] = static_cast<char>('0' + ((character >> 3) & 7));
+                    escaped[3] = static_cast<char>('0' + (character & 7));
+                    escaped[4] = '\0';
+                    result += escaped;
+                }
+                else
+                {
+                    result += static_cast<char>(character);
+                }
+                break;
+            }
+        }
+        lineLength++;
+
+        // start a new literal after each newline and after long lines
+        if(indent != ""
+                && i + 1 < text.size()
+                && (character == '\n' || lineLength >= 80))
+        {
+            result += "\"\n" + indent + "\"";
+            lineLength = 0;
+        }
+    }
+
+    result += "\"";
+
+    return result;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
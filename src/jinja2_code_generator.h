@@ -0,0 +1,76 @@
+/**
+ *  @file    jinja2_code_generator.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_CODE_GENERATOR_H
+#define JINJA2_CODE_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <jinja2_items.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+class Jinja2CodeGenerator
+{
+public:
+    Jinja2CodeGenerator();
+    ~Jinja2CodeGenerator();
+
+    static void generateFileHeader(std::string &code);
+    bool generate(Jinja2Item* root,
+                  const std::string &templateString,
+                  const std::string &functionName,
+                  const uint32_t templateId,
+                  std::string &code,
+                  std::string &errorMessage);
+
+private:
+    // prefix for all constants of the current template
+    std::string m_prefix = "";
+
+    std::string m_constants = "";
+    std::string m_body = "";
+    std::unordered_map<std::string, std::string> m_keyConstants;
+    uint32_t m_numberOfTexts = 0;
+    uint32_t m_numberOfVariables = 0;
+
+    // names of the loop-variables of the template and of the generated code for each loop
+    std::vector<std::pair<std::string, std::string>> m_loopVariables;
+
+    bool generateItem(Jinja2Item* part,
+                      const std::string &indent,
+                      std::string &errorMessage);
+    void generateText(const std::string &text,
+                      const std::string &indent);
+    void generateReplace(ReplaceItem* replaceItem,
+                         const std::string &indent);
+    bool generateIfCondition(IfItem* ifItem,
+                             const std::string &indent,
+                             std::string &errorMessage);
+    bool generateForLoop(ForLoopItem* forLoopItem,
+                         const std::string &indent,
+                         std::string &errorMessage);
+
+    const std::string generatePath(Jinja2Path* jsonPath,
+                                   const std::string &indent);
+    const std::string getKeyConstant(const std::string &name);
+
+    static const std::string getPathString(Jinja2Path* jsonPath);
+    static const std::string createStringLiteral(const std::string &text,
+                                                 const std::string &indent);
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_CODE_GENERATOR_H
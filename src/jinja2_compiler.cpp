@@ -0,0 +1,661 @@
+/**
+ *  @file    jinja2_compiler.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <jinja2_compiler.h>
+
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <jinja2_hash.h>
+#include <jinja2_output.h>
+#include <jinja2_condition.h>
+#include <jinja2_dependencies.h>
+#include <jinja2_splice_list.h>
+#include <jinja2_context_index.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief constructor
+ */
+Jinja2Compiler::Jinja2Compiler() {}
+
+/**
+ * @brief destructor
+ */
+Jinja2Compiler::~Jinja2Compiler() {}
+
+/**
+ * @brief set the function, which resolves the names of includes into compiled templates.
+ *        Without resolver each include is an error.
+ *
+ * @param resolver function to get the shared compiled template for a name
+ */
+void
+Jinja2Compiler::setIncludeResolver(const Jinja2IncludeResolver &resolver)
+{
+    m_includeResolver = resolver;
+}
+
+/**
+ * @brief lower the item-tree of the parser into a flat list of instructions
+ *
+ * @param root root of the parsed item-tree, nullptr for an empty template
+ * @param templateString parsed template-string, which is used to convert the positions of the
+ *                       items into lines and columns
+ * @param bytecode reference for the resulting bytecode
+ * @param staticContext data-object with values, which are already known at compile-time and
+ *                      never change. Replacements and if-conditions, which can be resolved
+ *                      with this values, are evaluated here and not while rendering.
+ *                      Can be nullptr.
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Compiler::compile(Jinja2Item* root,
+                        const std::string &templateString,
+                        Jinja2Bytecode &bytecode,
+                        DataMap* staticContext,
+                        std::string &errorMessage)
+{
+    m_bytecode = &bytecode;
+    m_staticContext = staticContext;
+    m_keyIds.clear();
+    m_pathIds.clear();
+    m_loopVariables.clear();
+    m_lastJumpTarget = 0;
+
+    m_templateString = &templateString;
+    m_sourcePosition = 0;
+    m_scanPosition = 0;
+    m_scanLocation.line = 1;
+    m_scanLocation.column = 1;
+
+    const bool success = compileItem(root, 0, errorMessage);
+    bytecode.useStorage();
+    if(success)
+    {
+        analyzeDependencies(bytecode);
+        createSpliceList(bytecode);
+        createPathNames(bytecode);
+    }
+
+    m_keyIds.clear();
+    m_pathIds.clear();
+    m_loopVariables.clear();
+    m_staticContext = nullptr;
+    m_templateString = nullptr;
+    m_bytecode = nullptr;
+
+    return success;
+}
+
+/**
+ * @brief lower a list of parsed items. The items of the list are processed in a loop, so only
+ *        nested if-conditions and for-loops increase the depth of the call-stack.
+ *
+ * @param part first item of the list
+ * @param depth nesting-depth of the list within the template
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Compiler::compileItem(Jinja2Item* part,
+                            const uint32_t depth,
+                            std::string &errorMessage)
+{
+    if(depth > Jinja2Template::MAX_NESTING_DEPTH)
+    {
+        errorMessage =  "error while compiling jinja2-template \n";
+        errorMessage += "    maximum nesting-depth of ";
+        errorMessage += std::to_string(Jinja2Template::MAX_NESTING_DEPTH);
+        errorMessage += " for if-conditions and for-loops reached \n";
+        return false;
+    }
+
+    if(depth > m_bytecode->maxNestingDepth) {
+        m_bytecode->maxNestingDepth = depth;
+    }
+
+    while(part != nullptr)
+    {
+        m_sourcePosition = part->position;
+
+        switch(part->getType())
+        {
+            //------------------------------------------------------
+            case Jinja2Item::TEXT_ITEM:
+            {
+                compileText(static_cast<TextItem*>(part)->text);
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::REPLACE_ITEM:
+            {
+                compileReplace(static_cast<ReplaceItem*>(part));
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::IF_ITEM:
+            {
+                IfItem* ifItem = static_cast<IfItem*>(part);
+                if(compileIfCondition(ifItem, depth, errorMessage) == false) {
+                    return false;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::FOR_ITEM:
+            {
+                ForLoopItem* forLoopItem = static_cast<ForLoopItem*>(part);
+                if(compileForLoop(forLoopItem, depth, errorMessage) == false) {
+                    return false;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            case Jinja2Item::INCLUDE_ITEM:
+            {
+                IncludeItem* includeItem = static_cast<IncludeItem*>(part);
+                if(compileInclude(includeItem, depth, errorMessage) == false) {
+                    return false;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            default:
+                break;
+        }
+
+        part = part->next;
+    }
+
+    return true;
+}
+
+/**
+ * @brief lower a text into an EMIT_TEXT-instruction and copy the text into the string-pool. If
+ *        the last instruction is also an EMIT_TEXT-instruction and no jump-target is between
+ *        them, the text is merged into the last instruction.
+ *
+ * @param text text to lower
+ */
+void
+Jinja2Compiler::compileText(const std::string &text)
+{
+    if(text.size() == 0) {
+        return;
+    }
+
+    const uint32_t offset = static_cast<uint32_t>(m_bytecode->storage.stringPool.size());
+    const uint32_t length = static_cast<uint32_t>(text.size());
+
+    m_bytecode->storage.stringPool.append(text);
+    m_bytecode->literalSize += length;
+
+    if(getPosition() > 0
+            && getPosition() != m_lastJumpTarget)
+    {
+        // text of the last instruction has to be directly in front of the new text
+        Jinja2Instruction &last = m_bytecode->storage.instructions.back();
+        if(last.opCode == EMIT_TEXT
+                && last.arg0 + last.arg1 == offset)
+        {
+            last.arg1 += length;
+            return;
+        }
+    }
+
+    addInstruction(EMIT_TEXT, offset, length);
+}
+
+/**
+ * @brief lower a replace-item into an EMIT_VAR-instruction, or into text, if the value is
+ *        already known within the static context
+ *
+ * @param replaceItem item to lower
+ */
+void
+Jinja2Compiler::compileReplace(ReplaceItem* replaceItem)
+{
+    DataItem* staticItem = getStaticItem(replaceItem->iterateArray);
+    if(staticItem != nullptr)
+    {
+        std::string text = "";
+        appendValue(text, staticItem);
+        compileText(text);
+        return;
+    }
+
+    addInstruction(EMIT_VAR, addPath(replaceItem->iterateArray));
+}
+
+/**
+ * @brief lower an if-condition into a conditional jump over the if-branch and, if there is an
+ *        else-branch, an unconditional jump over the else-branch
+ *
+ * @param ifItem item to lower
+ * @param depth nesting-depth of the if-condition within the template
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Compiler::compileIfCondition(IfItem* ifItem,
+                                   const uint32_t depth,
+                                   std::string &errorMessage)
+{
+    Jinja2Condition condition;
+    condition.compareType = ifItem->ifType;
+    const std::string text = ifItem->rightSide.toString();
+    initConditionConstant(condition, text, ifItem->rightSide);
+
+    // if the value is already known, only the branch, which would be used, is lowered. The
+    // text of the condition is not needed in the string-pool in this case.
+    DataItem* staticItem = getStaticItem(ifItem->leftSide);
+    if(staticItem != nullptr)
+    {
+        if(evaluateCondition(condition, text.c_str(), staticItem)) {
+            return compileItem(ifItem->ifChild, depth + 1, errorMessage);
+        }
+        return compileItem(ifItem->elseChild, depth + 1, errorMessage);
+    }
+
+    condition.pathId = addPath(ifItem->leftSide);
+    condition.textOffset = addString(text);
+    condition.textLength = static_cast<uint32_t>(text.size());
+
+    const uint32_t conditionId = static_cast<uint32_t>(m_bytecode->storage.conditions.size());
+    m_bytecode->storage.conditions.push_back(condition);
+
+    const uint32_t conditionalJump = addInstruction(JUMP_IF_FALSE, conditionId);
+    if(compileItem(ifItem->ifChild, depth + 1, errorMessage) == false) {
+        return false;
+    }
+
+    if(ifItem->elseChild == nullptr)
+    {
+        setJumpTarget(conditionalJump);
+        return true;
+    }
+
+    m_sourcePosition = ifItem->elsePosition;
+    const uint32_t jumpOverElse = addInstruction(JUMP);
+    setJumpTarget(conditionalJump);
+    if(compileItem(ifItem->elseChild, depth + 1, errorMessage) == false) {
+        return false;
+    }
+    setJumpTarget(jumpOverElse);
+
+    return true;
+}
+
+/**
+ * @brief lower a for-loop into a LOOP_BEGIN-instruction, the loop-body and a LOOP_NEXT-instruction
+ *
+ * @param forLoopItem item to lower
+ * @param depth nesting-depth of the for-loop within the template
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Compiler::compileForLoop(ForLoopItem* forLoopItem,
+                               const uint32_t depth,
+                               std::string &errorMessage)
+{
+    const uint32_t loopBegin = addInstruction(LOOP_BEGIN,
+                                              addPath(forLoopItem->iterateArray),
+                                              0,
+                                              addKey(forLoopItem->tempVarName));
+    const uint32_t bodyBegin = getPosition();
+    m_lastJumpTarget = bodyBegin;
+
+    // the loop-variable shadows values of the static context with the same name
+    m_loopVariables.push_back(forLoopItem->tempVarName);
+    const bool success = compileItem(forLoopItem->forChild, depth + 1, errorMessage);
+    m_loopVariables.pop_back();
+
+    if(success == false) {
+        return false;
+    }
+
+    m_sourcePosition = forLoopItem->endPosition;
+    addInstruction(LOOP_NEXT, 0, bodyBegin);
+    setJumpTarget(loopBegin);
+
+    return true;
+}
+
+/**
+ * @brief lower an include into an INCLUDE-instruction, which renders the shared compiled form
+ *        of the included template
+ *
+ * @param includeItem item to lower
+ * @param depth nesting-depth of the include within the template
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Compiler::compileInclude(IncludeItem* includeItem,
+                               const uint32_t depth,
+                               std::string &errorMessage)
+{
+    if(m_includeResolver == nullptr)
+    {
+        errorMessage =  "error while compiling jinja2-template \n";
+        errorMessage += "    include of template '" + includeItem->name + "'";
+        errorMessage += " can not be resolved \n";
+        return false;
+    }
+
+    Jinja2Include include;
+    include.includedTemplate = m_includeResolver(includeItem->name, errorMessage);
+    if(include.includedTemplate == nullptr) {
+        return false;
+    }
+
+    // loops of the included template are nested within the loops around the include
+    const Jinja2Bytecode &includedBytecode = *include.includedTemplate->m_bytecode;
+    const uint32_t includedDepth = depth + includedBytecode.maxNestingDepth;
+    if(includedDepth > Jinja2Template::MAX_NESTING_DEPTH)
+    {
+        errorMessage =  "error while compiling jinja2-template \n";
+        errorMessage += "    maximum nesting-depth of ";
+        errorMessage += std::to_string(Jinja2Template::MAX_NESTING_DEPTH);
+        errorMessage += " for if-conditions and for-loops reached within included template '";
+        errorMessage += includeItem->name + "' \n";
+        return false;
+    }
+
+    if(includedDepth > m_bytecode->maxNestingDepth) {
+        m_bytecode->maxNestingDepth = includedDepth;
+    }
+
+    // the loop-variables, which are active at the include, already exist as keys
+    std::unordered_map<std::string, uint32_t> includedKeys;
+    for(uint32_t i = 0; i < includedBytecode.keyNames.size(); i++) {
+        includedKeys.insert(std::make_pair(includedBytecode.keyNames[i], i));
+    }
+
+    include.keyMapping.resize(m_bytecode->keyNames.size(), UINT32_MAX);
+    for(const std::string &loopVariable : m_loopVariables)
+    {
+        auto it = includedKeys.find(loopVariable);
+        if(it != includedKeys.end()) {
+            include.keyMapping[addKey(loopVariable)] = it->second;
+        }
+    }
+
+    // dependencies of the included template are copied as paths of this template
+    for(const std::string &dependency : include.includedTemplate->getDependencies())
+    {
+        std::vector<std::string> names;
+        uint64_t begin = 0;
+        while(begin <= dependency.size())
+        {
+            uint64_t end = dependency.find('.', begin);
+            if(end == std::string::npos) {
+                end = dependency.size();
+            }
+            names.push_back(dependency.substr(begin, end - begin));
+            begin = end + 1;
+        }
+
+        include.dependencies.push_back(addPath(names));
+    }
+
+    const uint32_t includeId = static_cast<uint32_t>(m_bytecode->includes.size());
+    m_bytecode->includes.push_back(include);
+    addInstruction(INCLUDE, includeId);
+
+    return true;
+}
+
+/**
+ * @brief append a new instruction to the bytecode
+ *
+ * @return position of the new instruction
+ */
+uint32_t
+Jinja2Compiler::addInstruction(const Jinja2OpCode opCode,
+                               const uint32_t arg0,
+                               const uint32_t arg1,
+                               const uint32_t arg2)
+{
+    Jinja2Instruction instruction;
+    instruction.opCode = opCode;
+    instruction.arg0 = arg0;
+    instruction.arg1 = arg1;
+    instruction.arg2 = arg2;
+
+    m_bytecode->storage.instructions.push_back(instruction);
+    m_bytecode->storage.sourceLocations.push_back(getSourceLocation(m_sourcePosition));
+
+    return static_cast<uint32_t>(m_bytecode->storage.instructions.size() - 1);
+}
+
+/**
+ * @brief convert a path of the parser into a list of key-ids and add it to the bytecode
+ *
+ * @param jsonPath path of the parser
+ *
+ * @return id of the new path
+ */
+uint32_t
+Jinja2Compiler::addPath(Jinja2Path* jsonPath)
+{
+    std::vector<std::string> names;
+    names.reserve(jsonPath->numberOfSegments);
+
+    Jinja2PathSegment* segment = jsonPath->first;
+    while(segment != nullptr)
+    {
+        names.push_back(std::string(segment->name, segment->length));
+        segment = segment->next;
+    }
+
+    return addPath(names);
+}
+
+/**
+ * @brief convert a list of names into a list of key-ids and add it as path to the bytecode
+ *
+ * @param names names of the segments of the path
+ *
+ * @return id of the new path
+ */
+uint32_t
+Jinja2Compiler::addPath(const std::vector<std::string> &names)
+{
+    // identical paths are stored only once
+    std::string pathString = "";
+    for(uint64_t i = 0; i < names.size(); i++)
+    {
+        if(i != 0) {
+            pathString.append(".");
+        }
+        pathString.append(names[i]);
+    }
+
+    auto it = m_pathIds.find(pathString);
+    if(it != m_pathIds.end()) {
+        return it->second;
+    }
+
+    Jinja2CompiledPath path;
+    path.firstSegment = static_cast<uint32_t>(m_bytecode->storage.pathSegments.size());
+    path.numberOfSegments = static_cast<uint32_t>(names.size());
+
+    for(const std::string &name : names) {
+        m_bytecode->storage.pathSegments.push_back(addKey(name));
+    }
+
+    const uint32_t pathId = static_cast<uint32_t>(m_bytecode->storage.paths.size());
+    m_bytecode->storage.paths.push_back(path);
+    m_pathIds.insert(std::make_pair(pathString, pathId));
+
+    return pathId;
+}
+
+/**
+ * @brief intern a name of a path-segment or loop-variable as key of the bytecode. Hash and
+ *        length of the key are calculated only once here and not while rendering.
+ *
+ * @param name name of the key
+ *
+ * @return id of the key
+ */
+uint32_t
+Jinja2Compiler::addKey(const std::string &name)
+{
+    auto it = m_keyIds.find(name);
+    if(it != m_keyIds.end()) {
+        return it->second;
+    }
+
+    Jinja2Key key;
+    key.hash = calculateHash(name);
+    key.nameOffset = addString(name);
+    key.length = static_cast<uint32_t>(name.size());
+
+    const uint32_t keyId = static_cast<uint32_t>(m_bytecode->storage.keys.size());
+    m_bytecode->storage.keys.push_back(key);
+    m_bytecode->keyNames.push_back(name);
+    m_keyIds.insert(std::make_pair(name, keyId));
+
+    return keyId;
+}
+
+/**
+ * @brief add a null-terminated string to the string-pool
+ *
+ * @param text string to add
+ *
+ * @return offset of the string within the string-pool
+ */
+uint32_t
+Jinja2Compiler::addString(const std::string &text)
+{
+    const uint32_t offset = static_cast<uint32_t>(m_bytecode->storage.stringPool.size());
+    m_bytecode->storage.stringPool.append(text);
+    m_bytecode->storage.stringPool.push_back('\0');
+
+    return offset;
+}
+
+/**
+ * @brief get position of the next instruction, which is used as jump-target
+ *
+ * @return position behind the last instruction
+ */
+uint32_t
+Jinja2Compiler::getPosition() const
+{
+    return static_cast<uint32_t>(m_bytecode->storage.instructions.size());
+}
+
+/**
+ * @brief set the position of the next instruction as jump-target of an already existing
+ *        jump-instruction
+ *
+ * @param instructionPos position of the jump-instruction
+ *
+ * @return new jump-target
+ */
+uint32_t
+Jinja2Compiler::setJumpTarget(const uint32_t instructionPos)
+{
+    m_lastJumpTarget = getPosition();
+    m_bytecode->storage.instructions[instructionPos].arg1 = m_lastJumpTarget;
+
+    return m_lastJumpTarget;
+}
+
+/**
+ * @brief search the item of a path within the static context
+ *
+ * @param jsonPath path of the parser
+ *
+ * @return pointer to the item, if found, else nullptr
+ */
+DataItem*
+Jinja2Compiler::getStaticItem(Jinja2Path* jsonPath) const
+{
+    if(m_staticContext == nullptr) {
+        return nullptr;
+    }
+
+    // paths, which start with a loop-variable, can only be resolved while rendering
+    const std::string firstName(jsonPath->first->name, jsonPath->first->length);
+    for(const std::string &loopVariable : m_loopVariables)
+    {
+        if(loopVariable == firstName) {
+            return nullptr;
+        }
+    }
+
+    DataItem* tempJson = m_staticContext;
+    Jinja2PathSegment* segment = jsonPath->first;
+    while(segment != nullptr)
+    {
+        tempJson = tempJson->get(std::string(segment->name, segment->length));
+        if(tempJson == nullptr) {
+            return nullptr;
+        }
+        segment = segment->next;
+    }
+
+    return tempJson;
+}
+
+/**
+ * @brief convert a byte-offset within the template-string into line and column. The
+ *        instructions are created in the order of the template, so the string is scanned only
+ *        once from the last converted position.
+ *
+ * @param position byte-offset within the template-string
+ *
+ * @return line and column of the position
+ */
+Jinja2SourceLocation
+Jinja2Compiler::getSourceLocation(const uint32_t position)
+{
+    // restart the scan, if the position is in front of the last one
+    if(position < m_scanPosition)
+    {
+        m_scanPosition = 0;
+        m_scanLocation.line = 1;
+        m_scanLocation.column = 1;
+    }
+
+    const std::string &templateString = *m_templateString;
+    while(m_scanPosition < position
+          && m_scanPosition < templateString.size())
+    {
+        if(templateString[m_scanPosition] == '\n')
+        {
+            m_scanLocation.line++;
+            m_scanLocation.column = 1;
+        }
+        else
+        {
+            m_scanLocation.column++;
+        }
+        m_scanPosition++;
+    }
+
+    return m_scanLocation;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
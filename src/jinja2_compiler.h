@@ -0,0 +1,97 @@
+/**
+ *  @file    jinja2_compiler.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_COMPILER_H
+#define JINJA2_COMPILER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+
+#include <jinja2_bytecode.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// returns the shared compiled template for the name of an include, or nullptr in case of an error
+typedef std::function<std::shared_ptr<Jinja2Template>(const std::string &name,
+                                                      std::string &errorMessage)>
+        Jinja2IncludeResolver;
+
+class Jinja2Compiler
+{
+public:
+    Jinja2Compiler();
+    ~Jinja2Compiler();
+
+    void setIncludeResolver(const Jinja2IncludeResolver &resolver);
+
+    bool compile(Jinja2Item* root,
+                 const std::string &templateString,
+                 Jinja2Bytecode &bytecode,
+                 DataMap* staticContext,
+                 std::string &errorMessage);
+
+private:
+    Jinja2Bytecode* m_bytecode = nullptr;
+    std::unordered_map<std::string, uint32_t> m_keyIds;
+    std::unordered_map<std::string, uint32_t> m_pathIds;
+
+    Jinja2IncludeResolver m_includeResolver;
+
+    // values, which are already known at compile-time
+    DataMap* m_staticContext = nullptr;
+    std::vector<std::string> m_loopVariables;
+
+    // position of the last jump-target, where no text can be merged into the previous text
+    uint32_t m_lastJumpTarget = 0;
+
+    // byte-offset of the item, which is currently lowered, and the state of the forward-scan
+    // to convert the byte-offsets into lines and columns
+    const std::string* m_templateString = nullptr;
+    uint32_t m_sourcePosition = 0;
+    uint32_t m_scanPosition = 0;
+    Jinja2SourceLocation m_scanLocation;
+
+    bool compileItem(Jinja2Item* part,
+                     const uint32_t depth,
+                     std::string &errorMessage);
+    void compileText(const std::string &text);
+    void compileReplace(ReplaceItem* replaceItem);
+    bool compileIfCondition(IfItem* ifItem,
+                            const uint32_t depth,
+                            std::string &errorMessage);
+    bool compileForLoop(ForLoopItem* forLoopItem,
+                        const uint32_t depth,
+                        std::string &errorMessage);
+    bool compileInclude(IncludeItem* includeItem,
+                        const uint32_t depth,
+                        std::string &errorMessage);
+
+    uint32_t addInstruction(const Jinja2OpCode opCode,
+                            const uint32_t arg0 = 0,
+                            const uint32_t arg1 = 0,
+                            const uint32_t arg2 = 0);
+    uint32_t addPath(Jinja2Path* jsonPath);
+    uint32_t addPath(const std::vector<std::string> &names);
+    uint32_t addKey(const std::string &name);
+    uint32_t addString(const std::string &text);
+    uint32_t getPosition() const;
+    uint32_t setJumpTarget(const uint32_t instructionPos);
+    DataItem* getStaticItem(Jinja2Path* jsonPath) const;
+    Jinja2SourceLocation getSourceLocation(const uint32_t position);
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_COMPILER_H
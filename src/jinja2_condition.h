@@ -0,0 +1,191 @@
+/**
+ *  @file    jinja2_condition.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_CONDITION_H
+#define JINJA2_CONDITION_H
+
+#include <string>
+#include <cstring>
+
+#include <jinja2_bytecode.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// result of a comparison of values with different types
+const int NOT_COMPARABLE = 2;
+
+/**
+ * @brief convert the right side of a parsed if-condition into the constant of the condition
+ *
+ * @param condition reference to the condition, which should be filled
+ * @param text right side of the if-condition as string
+ * @param rightSide parsed right side of the if-condition
+ */
+inline void
+initConditionConstant(Jinja2Condition &condition,
+                      const std::string &text,
+                      DataValue &rightSide)
+{
+    if(rightSide.getValueType() == DataItem::INT_TYPE)
+    {
+        condition.constantType = INT_CONSTANT;
+        condition.longValue = rightSide.getLong();
+        return;
+    }
+
+    condition.constantType = STRING_CONSTANT;
+    if(text == "true"
+            || text == "True")
+    {
+        condition.constantType = BOOL_CONSTANT;
+        condition.boolValue = 1;
+    }
+    if(text == "false"
+            || text == "False")
+    {
+        condition.constantType = BOOL_CONSTANT;
+        condition.boolValue = 0;
+    }
+}
+
+/**
+ * @brief compare a value of the input with the constant of a condition on their native types,
+ *        so no strings have to be created
+ *
+ * @param condition condition with the constant
+ * @param text text of the constant
+ * @param item item of the input
+ *
+ * @return -1, 0 or 1, if the item is smaller, equal or greater than the constant, or
+ *         NOT_COMPARABLE, if the types of the values don't match
+ */
+inline int
+compareWithConstant(const Jinja2Condition &condition,
+                    const char* text,
+                    DataItem* item)
+{
+    if(item->getType() != DataItem::VALUE_TYPE) {
+        return NOT_COMPARABLE;
+    }
+
+    DataValue* value = item->toValue();
+    switch(value->getValueType())
+    {
+        case DataItem::STRING_TYPE:
+        {
+            const int result = strcmp(value->content.stringValue, text);
+
+            // numbers are only compared for equality with the text of the number
+            if(condition.constantType == INT_CONSTANT
+                    && result != 0)
+            {
+                return NOT_COMPARABLE;
+            }
+
+            return (result > 0) - (result < 0);
+        }
+        case DataItem::INT_TYPE:
+        {
+            if(condition.constantType != INT_CONSTANT) {
+                return NOT_COMPARABLE;
+            }
+
+            const int64_t left = value->getLong();
+            return (left > condition.longValue) - (left < condition.longValue);
+        }
+        case DataItem::FLOAT_TYPE:
+        {
+            if(condition.constantType != INT_CONSTANT) {
+                return NOT_COMPARABLE;
+            }
+
+            const double left = value->getDouble();
+            const double right = static_cast<double>(condition.longValue);
+            return (left > right) - (left < right);
+        }
+        case DataItem::BOOL_TYPE:
+        {
+            if(condition.constantType != BOOL_CONSTANT) {
+                return NOT_COMPARABLE;
+            }
+
+            const int left = value->getBool() ? 1 : 0;
+            const int right = condition.boolValue != 0 ? 1 : 0;
+            return left - right;
+        }
+        default:
+            break;
+    }
+
+    return NOT_COMPARABLE;
+}
+
+/**
+ * @brief check if an if-condition is true. Is used while rendering and while compiling with a
+ *        static context, so both have the same behavior.
+ *
+ * @param condition condition to check
+ * @param text text of the right side of the condition
+ * @param item item of the input, which was found for the left side of the condition
+ *
+ * @return true, if the condition is true, else false
+ */
+inline bool
+evaluateCondition(const Jinja2Condition &condition,
+                  const char* text,
+                  DataItem* item)
+{
+    // conditions without compare-value check for a true-value like "{% if item %}"
+    if(condition.compareType == IfItem::IS_TRUE)
+    {
+        if(item->getType() != DataItem::VALUE_TYPE) {
+            return false;
+        }
+
+        DataValue* value = item->toValue();
+        if(value->getValueType() == DataItem::BOOL_TYPE) {
+            return value->getBool();
+        }
+        if(value->getValueType() == DataItem::STRING_TYPE)
+        {
+            return strcmp(value->content.stringValue, "true") == 0
+                   || strcmp(value->content.stringValue, "True") == 0;
+        }
+
+        return false;
+    }
+
+    const int result = compareWithConstant(condition, text, item);
+    switch(condition.compareType)
+    {
+        case IfItem::EQUAL:
+            return result == 0;
+        case IfItem::UNEQUAL:
+            return result != 0;
+        case IfItem::GREATER:
+            return result == 1;
+        case IfItem::GREATER_EQUAL:
+            return result == 1 || result == 0;
+        case IfItem::SMALLER:
+            return result == -1;
+        case IfItem::SMALLER_EQUAL:
+            return result == -1 || result == 0;
+        default:
+            break;
+    }
+
+    return false;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_CONDITION_H
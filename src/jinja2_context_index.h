@@ -0,0 +1,185 @@
+/**
+ *  @file    jinja2_context_index.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_CONTEXT_INDEX_H
+#define JINJA2_CONTEXT_INDEX_H
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <jinja2_bytecode.h>
+#include <jinja2_hash.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+//===================================================================
+// Jinja2ContextIndex
+//===================================================================
+// flat hash-table of all paths of an input, which can be reached over maps, with the same
+// paths with dots as separator as the paths of the compiled templates
+struct Jinja2ContextEntry
+{
+    uint64_t hash = 0;
+    DataItem* item = nullptr;
+
+    // path within the path-pool of the index
+    uint64_t pathOffset = 0;
+    uint64_t pathLength = 0;
+};
+
+struct Jinja2ContextIndex
+{
+    // open addressing with linear probing, where the number of slots is a power of two and
+    // at least the double of the number of paths, so a search ends at the next free slot
+    std::vector<Jinja2ContextEntry> slots;
+    uint64_t mask = 0;
+    uint64_t numberOfPaths = 0;
+    std::string pathPool = "";
+
+    /**
+     * @brief search a path within the index
+     *
+     * @param hash hash of the path
+     * @param path path with dots as separator
+     *
+     * @return pointer to the item, if found, else nullptr
+     */
+    DataItem* find(const uint64_t hash,
+                   const std::string &path) const
+    {
+        uint64_t pos = hash & mask;
+        while(slots[pos].item != nullptr)
+        {
+            // the path is compared too, because different paths can have the same hash
+            const Jinja2ContextEntry &entry = slots[pos];
+            if(entry.hash == hash
+                    && entry.pathLength == path.size()
+                    && memcmp(&pathPool[entry.pathOffset], path.c_str(), path.size()) == 0)
+            {
+                return entry.item;
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        return nullptr;
+    }
+};
+
+/**
+ * @brief fill an index with all paths of an input. Arrays are not indexed, because paths of
+ *        templates can not point into arrays. Keys with a dot can not be reached by a path and
+ *        are skipped.
+ *
+ * @param index index, which should be filled
+ * @param input input, which should be indexed
+ */
+inline void
+createContextIndex(Jinja2ContextIndex &index,
+                   DataMap* input)
+{
+    std::vector<Jinja2ContextEntry> entries;
+
+    // maps are processed with an own stack, so deep inputs can not overflow the call-stack
+    std::vector<std::pair<DataMap*, uint64_t>> stack;
+    stack.push_back(std::make_pair(input, UINT64_MAX));
+    while(stack.size() > 0)
+    {
+        DataMap* map = stack.back().first;
+        const uint64_t parentId = stack.back().second;
+        stack.pop_back();
+
+        for(const auto &child : map->map)
+        {
+            if(child.second == nullptr
+                    || child.first.find('.') != std::string::npos)
+            {
+                continue;
+            }
+
+            Jinja2ContextEntry entry;
+            entry.item = child.second;
+            entry.pathOffset = index.pathPool.size();
+            if(parentId != UINT64_MAX)
+            {
+                const Jinja2ContextEntry &parent = entries[parentId];
+                const std::string parentPath = index.pathPool.substr(parent.pathOffset,
+                                                                     parent.pathLength);
+                index.pathPool += parentPath;
+                index.pathPool += ".";
+            }
+            index.pathPool += child.first;
+            entry.pathLength = index.pathPool.size() - entry.pathOffset;
+            entry.hash = calculateHash(&index.pathPool[entry.pathOffset], entry.pathLength);
+            entries.push_back(entry);
+
+            if(child.second->getType() == DataItem::MAP_TYPE) {
+                stack.push_back(std::make_pair(child.second->toMap(), entries.size() - 1));
+            }
+        }
+    }
+
+    uint64_t numberOfSlots = 1;
+    while(numberOfSlots < entries.size() * 2) {
+        numberOfSlots *= 2;
+    }
+
+    index.slots.assign(numberOfSlots, Jinja2ContextEntry());
+    index.mask = numberOfSlots - 1;
+    index.numberOfPaths = entries.size();
+    for(const Jinja2ContextEntry &entry : entries)
+    {
+        // each path exist only once within an input, so the free slot is used directly
+        uint64_t pos = entry.hash & index.mask;
+        while(index.slots[pos].item != nullptr) {
+            pos = (pos + 1) & index.mask;
+        }
+        index.slots[pos] = entry;
+    }
+}
+
+/**
+ * @brief create the names and hashes of all paths of a bytecode, so paths can be searched
+ *        within an index of a prepared context
+ *
+ * @param bytecode bytecode, which gets the names of its paths
+ */
+inline void
+createPathNames(Jinja2Bytecode &bytecode)
+{
+    bytecode.pathNames.clear();
+    bytecode.pathHashes.clear();
+    bytecode.pathNames.reserve(bytecode.numberOfPaths);
+    bytecode.pathHashes.reserve(bytecode.numberOfPaths);
+
+    for(uint32_t pathId = 0; pathId < bytecode.numberOfPaths; pathId++)
+    {
+        const Jinja2CompiledPath &path = bytecode.paths[pathId];
+
+        std::string name = "";
+        for(uint32_t i = 0; i < path.numberOfSegments; i++)
+        {
+            if(i != 0) {
+                name += ".";
+            }
+            name += bytecode.keyNames[bytecode.pathSegments[path.firstSegment + i]];
+        }
+
+        bytecode.pathHashes.push_back(calculateHash(name));
+        bytecode.pathNames.push_back(name);
+    }
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_CONTEXT_INDEX_H
@@ -7,12 +7,22 @@
 */
 
 #include <libKitsunemimiJinja2/jinja2_converter.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_sink.h>
+#include <libKitsunemimiJinja2/jinja2_generated.h>
+#include <libKitsunemimiJinja2/jinja2_prepared_context.h>
 
 #include <jinja2_parsing/jinja2_parser_interface.h>
+#include <jinja2_template_cache.h>
+#include <jinja2_hash.h>
+#include <jinja2_compiler.h>
+#include <jinja2_code_generator.h>
 #include <libKitsunemimiJson/json_item.h>
 
 #include <jinja2_items.h>
 
+#include <chrono>
+
 using Kitsunemimi::DataItem;
 using Kitsunemimi::DataArray;
 using Kitsunemimi::DataValue;
@@ -23,14 +33,21 @@ namespace Kitsunemimi
 namespace Jinja2
 {
 
-Kitsunemimi::Jinja2::Jinja2Converter* Jinja2Converter::m_instance = nullptr;
+std::atomic<Jinja2Converter*> Jinja2Converter::m_instance(nullptr);
+std::mutex Jinja2Converter::m_instanceLock;
 
 /**
  * @brief Iconstructor
  */
 Jinja2Converter::Jinja2Converter(const bool traceParsing)
+    : m_profiling(false),
+      m_maxOutputSize(0),
+      m_maxLoopIterations(0),
+      m_maxNestingDepth(0)
 {
-    m_driver = new Jinja2ParserInterface(traceParsing);
+    m_traceParsing = traceParsing;
+    m_cache = new Jinja2TemplateCache(Jinja2TemplateCache::DEFAULT_MAX_ENTRIES,
+                                      Jinja2TemplateCache::DEFAULT_MAX_BYTES);
 }
 
 /**
@@ -41,19 +58,33 @@ Jinja2Converter::Jinja2Converter(const bool traceParsing)
 Jinja2Converter*
 Jinja2Converter::getInstance()
 {
-    if(m_instance == nullptr) {
-        m_instance = new Jinja2Converter();
+    Jinja2Converter* instance = m_instance.load(std::memory_order_acquire);
+    if(instance != nullptr) {
+        return instance;
+    }
+
+    // the lock is only used for the first creation of the instance and not while converting
+    m_instanceLock.lock();
+    instance = m_instance.load(std::memory_order_relaxed);
+    if(instance == nullptr)
+    {
+        instance = new Jinja2Converter();
+        m_instance.store(instance, std::memory_order_release);
     }
+    m_instanceLock.unlock();
 
-    return m_instance;
+    return instance;
 }
 
 /**
- * @brief Idestructor which only deletes the parser-interface to avoid memory-lead
+ * @brief Idestructor which deletes the template-cache and resets the static instance
  */
 Jinja2Converter::~Jinja2Converter()
 {
-    delete m_driver;
+    delete m_cache;
+
+    Jinja2Converter* self = this;
+    m_instance.compare_exchange_strong(self, nullptr);
 }
 
 /**
@@ -81,18 +112,18 @@ Jinja2Converter::convert(std::string &result,
         return success;
     }
 
-    return convert(result,
-                   templateString,
-                   item.getItemContent()->copy()->toMap(),
-                   errorMessage);
+    return convert(result, templateString, item, errorMessage);
 }
 
 /**
- * @brief convert-method for the external using to fill a jinja2-formated template
+ * @brief convert-method for the external using to fill a jinja2-formated template with an
+ *        already parsed json-input. The input is used directly and not copied, so the same
+ *        parsed input can be used for multiple templates.
  *
  * @param result reference for the output-string
  * @param templateString jinj2-formated string
- * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param jsonInput parsed json-object with the information,
+ *                  which should be filled in the jinja2-template
  * @param errorMessage reference for error-message output
  *
  * @return true, if successful, else false
@@ -100,309 +131,559 @@ Jinja2Converter::convert(std::string &result,
 bool
 Jinja2Converter::convert(std::string &result,
                          const std::string &templateString,
-                         DataMap* input,
+                         Json::JsonItem &jsonInput,
                          std::string &errorMessage)
 {
-    bool success = false;
+    DataItem* content = jsonInput.getItemContent();
+    if(content == nullptr
+            || content->getType() != DataItem::MAP_TYPE)
+    {
+        errorMessage =  "error while converting jinja2-template \n";
+        errorMessage += "    json-input is not a json-object \n";
+        return false;
+    }
 
-    m_lock.lock();
-    // parse jinja2-template into a json-tree
-    success = m_driver->parse(templateString);
+    return convert(result, templateString, content->toMap(), errorMessage);
+}
 
-    // process a failure
-    if(success == false)
+/**
+ * @brief convert-method for the external using to fill a jinja2-formated template. Compiled
+ *        templates are stored in a cache, so the same template-string is parsed only once.
+ *        If a generated function is registered for the template-string, it is used instead,
+ *        as long as no render-limits are set.
+ *
+ * @param result reference for the output-string
+ * @param templateString jinj2-formated string
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Converter::convert(std::string &result,
+                         const std::string &templateString,
+                         DataMap* input,
+                         std::string &errorMessage)
+{
+    // generated functions can not check render-limits, so they are only used without limits
+    const uint64_t hash = calculateHash(templateString);
+    Jinja2GeneratedFunction generatedFunction = getGeneratedTemplate(templateString, hash);
+    if(generatedFunction != nullptr
+            && hasRenderLimits() == false)
     {
-        errorMessage = m_driver->getErrorMessage();
-        m_lock.unlock();
-        return success;
+        return generatedFunction(input, result, errorMessage);
     }
 
-    // convert the json-tree from the parser into a string
-    // by filling the input into it
-    Jinja2Item* output = m_driver->getOutput();
-    success = processItem(input,
-                          output,
-                          result,
-                          errorMessage);
-
-    delete output;
-    m_lock.unlock();
+    std::shared_ptr<Jinja2Template> compiledTemplate = getTemplate(templateString,
+                                                                   hash,
+                                                                   errorMessage);
+    if(compiledTemplate == nullptr) {
+        return false;
+    }
 
-    return success;
+    // convert the compiled template into a string by filling the input into it
+    return compiledTemplate->render(input, result, errorMessage);
 }
 
 /**
- * @brief Process a json-array, which is a list of parsed parts of the jinja2-template
+ * @brief convert-method for the external using to fill a jinja2-formated template with a
+ *        prepared context, which can be shared by all templates with the same input
  *
- * @param input The json-object with the items, which sould be filled in the template
- * @param part The Jinja2Item with the jinja2-content
- * @param output
+ * @param result reference for the output-string
+ * @param templateString jinj2-formated string
+ * @param context prepared context with the input of the render
  * @param errorMessage reference for error-message output
  *
- * @return true, if step was successful, else false
+ * @return true, if successful, else false
  */
 bool
-Jinja2Converter::processItem(DataMap* input,
-                             Jinja2Item* part,
-                             std::string &output,
-                             std::string &errorMessage)
+Jinja2Converter::convert(std::string &result,
+                         const std::string &templateString,
+                         const Jinja2PreparedContext &context,
+                         std::string &errorMessage)
 {
-    if(part == nullptr) {
-        return true;
+    // generated functions access the input directly and don't need the index, but they can
+    // not check render-limits
+    const uint64_t hash = calculateHash(templateString);
+    Jinja2GeneratedFunction generatedFunction = getGeneratedTemplate(templateString, hash);
+    if(generatedFunction != nullptr
+            && hasRenderLimits() == false)
+    {
+        return generatedFunction(context.getInput(), result, errorMessage);
     }
 
-    //------------------------------------------------------
-    if(part->getType() == Jinja2Item::TEXT_ITEM)
-    {
-        TextItem* textItem = dynamic_cast<TextItem*>(part);
-        output.append(textItem->text);
-        return processItem(input, part->next, output, errorMessage);
+    std::shared_ptr<Jinja2Template> compiledTemplate = getTemplate(templateString,
+                                                                   hash,
+                                                                   errorMessage);
+    if(compiledTemplate == nullptr) {
+        return false;
     }
-    //------------------------------------------------------
-    if(part->getType() == Jinja2Item::REPLACE_ITEM)
-    {
-        ReplaceItem* replaceItem = dynamic_cast<ReplaceItem*>(part);
-        if(processReplace(input, replaceItem, output, errorMessage) == false) {
-            return false;
-        }
+
+    return compiledTemplate->render(context, result, errorMessage);
+}
+
+/**
+ * @brief convert-method for the external using to fill a jinja2-formated template and write
+ *        the output in chunks into a sink, while rendering
+ *
+ * @param sink target for the output
+ * @param templateString jinj2-formated string
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Converter::convert(Jinja2Sink &sink,
+                         const std::string &templateString,
+                         DataMap* input,
+                         std::string &errorMessage)
+{
+    std::shared_ptr<Jinja2Template> compiledTemplate = getTemplate(templateString,
+                                                                   calculateHash(templateString),
+                                                                   errorMessage);
+    if(compiledTemplate == nullptr) {
+        return false;
     }
-    //------------------------------------------------------
-    if(part->getType() == Jinja2Item::IF_ITEM)
-    {
-        IfItem* ifItem = dynamic_cast<IfItem*>(part);
-        if(processIfCondition(input, ifItem, output, errorMessage) == false) {
-            return false;
-        }
+
+    return compiledTemplate->render(input, sink, errorMessage);
+}
+
+/**
+ * @brief get compiled template from the cache or compile it, if not cached
+ *
+ * @param templateString jinj2-formated string
+ * @param hash hash of the template-string, which is shared with the search of the
+ *             generated functions
+ * @param errorMessage reference for error-message output
+ *
+ * @return pointer to the compiled template, if successful, else nullptr
+ */
+std::shared_ptr<Jinja2Template>
+Jinja2Converter::getTemplate(const std::string &templateString,
+                             const uint64_t hash,
+                             std::string &errorMessage)
+{
+    // try to reuse an already compiled template
+    std::shared_ptr<Jinja2Template> compiledTemplate = m_cache->get(templateString, hash);
+    if(compiledTemplate != nullptr) {
+        return compiledTemplate;
     }
-    //------------------------------------------------------
-    if(part->getType() == Jinja2Item::FOR_ITEM)
-    {
-        ForLoopItem* forLoopItem = dynamic_cast<ForLoopItem*>(part);
-        if(processForLoop(input, forLoopItem, output, errorMessage) == false) {
-            return false;
-        }
+
+    // parse jinja2-template into a compiled template
+    Jinja2Template* newTemplate = compile(templateString, errorMessage);
+    if(newTemplate == nullptr) {
+        return compiledTemplate;
     }
-    //------------------------------------------------------
 
-    return true;
+    compiledTemplate = std::shared_ptr<Jinja2Template>(newTemplate);
+    m_cache->insert(templateString, compiledTemplate);
+
+    return compiledTemplate;
 }
 
 /**
- * @brief Resolve an replace-rule of the parsed jinja2-template
+ * @brief parse a jinja2-formated template once and lower it into bytecode, so it can be
+ *        rendered multiple times
  *
- * @param input The json-object with the items, which sould be filled in the template
- * @param replaceObject ReplaceItem with the replacement-information
- * @param output Pointer to the output-string for the result of the convertion
+ * @param templateString jinj2-formated string
  * @param errorMessage reference for error-message output
  *
- * @return true, if step was successful, else false
+ * @return pointer to the compiled template, if successful, else nullptr. The caller takes the
+ *         ownership of the template and has to delete it.
  */
-bool
-Jinja2Converter::processReplace(DataMap* input,
-                                ReplaceItem* replaceObject,
-                                std::string &output,
-                                std::string &errorMessage)
+Jinja2Template*
+Jinja2Converter::compile(const std::string &templateString,
+                         std::string &errorMessage)
+{
+    return compile(templateString, nullptr, errorMessage);
+}
+
+/**
+ * @brief parse a jinja2-formated template once and lower it into bytecode with values, which
+ *        are already known at compile-time. Replacements and if-conditions, which can be
+ *        resolved with the static context, are evaluated only once here and dead branches are
+ *        removed. Values of the static context can not be changed by the input of a render.
+ *
+ * @param templateString jinj2-formated string
+ * @param staticContext data-object with values, which never change. It is only used within
+ *                      this call and not stored within the template. Can be nullptr.
+ * @param errorMessage reference for error-message output
+ *
+ * @return pointer to the compiled template, if successful, else nullptr. The caller takes the
+ *         ownership of the template and has to delete it.
+ */
+Jinja2Template*
+Jinja2Converter::compile(const std::string &templateString,
+                         DataMap* staticContext,
+                         std::string &errorMessage)
+{
+    std::vector<std::string> includeStack;
+    return compileTemplate(templateString, staticContext, includeStack, errorMessage);
+}
+
+/**
+ * @brief parse a jinja2-formated template and lower it into bytecode. Includes are resolved
+ *        into the shared compiled templates of the converter.
+ *
+ * @param templateString jinj2-formated string
+ * @param staticContext data-object with values, which never change. Can be nullptr.
+ * @param includeStack names of the included templates, which are currently compiled, to
+ *                     detect cycles of includes
+ * @param errorMessage reference for error-message output
+ *
+ * @return pointer to the compiled template, if successful, else nullptr
+ */
+Jinja2Template*
+Jinja2Converter::compileTemplate(const std::string &templateString,
+                                 DataMap* staticContext,
+                                 std::vector<std::string> &includeStack,
+                                 std::string &errorMessage)
 {
-    // get information
-    std::pair<std::string, bool> jsonValue = getString(input, &replaceObject->iterateArray);
+    // each call use its own parser-interface with its own reentrant scanner, so multiple
+    // templates can be parsed in parallel without a lock
+    Jinja2ParserInterface driver(m_traceParsing);
+    const auto start = std::chrono::steady_clock::now();
+
+    // parse jinja2-template into a json-tree
+    const bool success = driver.parse(templateString);
 
     // process a failure
-    if(jsonValue.second == false)
+    if(success == false)
     {
-        errorMessage = createErrorMessage(&replaceObject->iterateArray);
-        return false;
+        errorMessage = driver.getErrorMessage();
+        return nullptr;
     }
 
-    // insert the replacement
-    output.append(jsonValue.first);
+    // lower the item-tree into a flat list of instructions. The tree is not necessary for
+    // rendering and is freed together with the arena of the parser-interface.
+    Jinja2Bytecode* bytecode = new Jinja2Bytecode();
+    Jinja2Compiler compiler;
+    compiler.setIncludeResolver([this, &includeStack](const std::string &name,
+                                                      std::string &includeError)
+    {
+        return getInclude(name, includeStack, includeError);
+    });
+    const bool compileSuccess = compiler.compile(driver.getOutput(),
+                                                   templateString,
+                                                   *bytecode,
+                                                   staticContext,
+                                                   errorMessage);
+
+    if(compileSuccess == false)
+    {
+        delete bytecode;
+        return nullptr;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
 
-    return processItem(input, replaceObject->next, output, errorMessage);
+    Jinja2Template* newTemplate = new Jinja2Template(bytecode);
+    newTemplate->m_parseTime = static_cast<uint64_t>(duration.count());
+    newTemplate->setProfiling(m_profiling.load(std::memory_order_relaxed));
+    newTemplate->setRenderLimits(getRenderLimits());
+
+    return newTemplate;
 }
 
 /**
- * @brief Resolve an if-condition of the parsed jinja2-template
+ * @brief get the shared compiled form of an included template or load and compile it, if it
+ *        was not used before. The lock is not held while compiling, so included templates can
+ *        contain includes too.
  *
- * @param input The json-object with the items, which sould be filled in the template
- * @param ifCondition Jinja2Item with the if-condition-information
- * @param output Pointer to the output-string for the result of the convertion
+ * @param name name of the include
+ * @param includeStack names of the included templates, which are currently compiled
+ * @param errorMessage reference for error-message output
  *
- * @return true, if step was successful, else false
+ * @return pointer to the compiled template, if successful, else nullptr
  */
-bool
-Jinja2Converter::processIfCondition(DataMap* input,
-                                    IfItem* ifCondition,
-                                    std::string &output,
-                                    std::string &errorMessage)
+std::shared_ptr<Jinja2Template>
+Jinja2Converter::getInclude(const std::string &name,
+                            std::vector<std::string> &includeStack,
+                            std::string &errorMessage)
 {
-    // get information
-    std::pair<std::string, bool> jsonValue = getString(input, &ifCondition->leftSide);
-
-    // process a failure
-    if(jsonValue.second == false)
+    Jinja2IncludeLoader loader;
     {
-        errorMessage = createErrorMessage(&ifCondition->leftSide);
-        return false;
+        std::lock_guard<std::mutex> guard(m_includeLock);
+        auto it = m_includes.find(name);
+        if(it != m_includes.end()) {
+            return it->second;
+        }
+        loader = m_includeLoader;
     }
 
-    // run the if-condition of the jinja2-template
-    if(jsonValue.first == ifCondition->rightSide.toString()
-        || jsonValue.first == "True"
-        || jsonValue.first == "true")
+    if(loader == nullptr)
     {
-        processItem(input, ifCondition->ifChild, output, errorMessage);
+        errorMessage =  "error while compiling jinja2-template \n";
+        errorMessage += "    include of template '" + name + "' is not possible,";
+        errorMessage += " because no include-loader is set \n";
+        return nullptr;
     }
-    else
+
+    for(const std::string &includeName : includeStack)
     {
-        if(ifCondition->elseChild != nullptr) {
-            processItem(input, ifCondition->elseChild, output, errorMessage);
+        if(includeName != name) {
+            continue;
+        }
+
+        errorMessage =  "error while compiling jinja2-template \n";
+        errorMessage += "    cycle of includes: ";
+        for(const std::string &stackName : includeStack) {
+            errorMessage += stackName + " -> ";
         }
+        errorMessage += name + " \n";
+        return nullptr;
+    }
+
+    std::string templateString = "";
+    std::string loaderError = "";
+    if(loader(name, templateString, loaderError) == false)
+    {
+        errorMessage =  "error while compiling jinja2-template \n";
+        errorMessage += "    failed to load included template '" + name + "': ";
+        errorMessage += loaderError + " \n";
+        return nullptr;
     }
 
-    return processItem(input, ifCondition->next, output, errorMessage);
+    includeStack.push_back(name);
+    Jinja2Template* newTemplate = compileTemplate(templateString,
+                                                  nullptr,
+                                                  includeStack,
+                                                  errorMessage);
+    includeStack.pop_back();
+
+    if(newTemplate == nullptr)
+    {
+        errorMessage += "    within included template '" + name + "' \n";
+        return nullptr;
+    }
+
+    // another thread could have compiled the same include in the meantime, so the first one
+    // is used by all templates
+    std::shared_ptr<Jinja2Template> includedTemplate(newTemplate);
+    std::lock_guard<std::mutex> guard(m_includeLock);
+
+    return m_includes.insert(std::make_pair(name, includedTemplate)).first->second;
 }
 
 /**
- * @brief Resolve an for-loop of the parsed jinja2-template
+ * @brief convert jinja2-formated templates into C++-code with one function for each template.
+ *        The functions are registered at the start of the program, which contains the code,
+ *        and are used by the convert-methods instead of the compiled templates.
  *
- * @param input The json-object with the items, which sould be filled in the template
- * @param forLoop ForLoopItem with the loop-information
- * @param output Pointer to the output-string for the result of the convertion
+ * @param templateStrings jinj2-formated strings
+ * @param functionNames names of the generated functions, one for each template-string
+ * @param code reference for the generated code
+ * @param errorMessage reference for error-message output
  *
- * @return true, if step was successful, else false
+ * @return true, if successful, else false
  */
 bool
-Jinja2Converter::processForLoop(DataMap* input,
-                                ForLoopItem* forLoop,
-                                std::string &output,
-                                std::string &errorMessage)
+Jinja2Converter::generateCode(const std::vector<std::string> &templateStrings,
+                              const std::vector<std::string> &functionNames,
+                              std::string &code,
+                              std::string &errorMessage)
 {
-    // get information
-    std::pair<DataItem*, bool> jsonValue = getItem(input, &forLoop->iterateArray);
-
-    // process a failure
-    if(jsonValue.second == false)
+    if(templateStrings.size() != functionNames.size())
     {
-        errorMessage = createErrorMessage(&forLoop->iterateArray);
+        errorMessage =  "error while generating code \n";
+        errorMessage += "    number of templates and function-names doesn't match \n";
         return false;
     }
 
-    // loop can only work on json-arrays
-    if(jsonValue.first->getType() != DataItem::ARRAY_TYPE)
-    {
-        // TODO: error-message
-        return false;
-    }
+    code.clear();
+    Jinja2CodeGenerator::generateFileHeader(code);
 
-    // run the loop of the jinja2-template
-    DataArray* array = jsonValue.first->toArray();
-    for(uint32_t i = 0; i < array->size(); i++)
+    Jinja2CodeGenerator generator;
+    for(uint64_t i = 0; i < templateStrings.size(); i++)
     {
-        DataMap* tempLoopInput = input;
-        tempLoopInput->insert(forLoop->tempVarName,
-                              array->get(i), true);
+        Jinja2ParserInterface driver(m_traceParsing);
+        if(driver.parse(templateStrings[i]) == false)
+        {
+            errorMessage = driver.getErrorMessage();
+            return false;
+        }
+
+        // the template must also be valid for the interpreter, for example the nesting-depth
+        Jinja2Bytecode bytecode;
+        Jinja2Compiler compiler;
+        if(compiler.compile(driver.getOutput(),
+                            templateStrings[i],
+                            bytecode,
+                            nullptr,
+                            errorMessage) == false)
+        {
+            return false;
+        }
 
-        if(processItem(tempLoopInput, forLoop->forChild, output, errorMessage) == false) {
+        if(generator.generate(driver.getOutput(),
+                              templateStrings[i],
+                              functionNames[i],
+                              static_cast<uint32_t>(i),
+                              code,
+                              errorMessage) == false)
+        {
             return false;
         }
     }
 
-    return processItem(input, forLoop->next, output, errorMessage);
+    return true;
 }
 
 /**
- * @brief Search a specific string-typed item in the json-input
+ * @brief set the limits of the template-cache, which is used by the convert-methods. Least
+ *        recently used templates are removed from the cache, if a limit is reached.
  *
- * @param input The json-object in which the item sould be searched
- * @param jsonPath Path item in the json-object. It is a DataArray
- *                 which contains only string-objects
+ * @param maxEntries maximum number of cached templates
+ * @param maxBytes maximum summed size of the template-strings of all cached templates
+ */
+void
+Jinja2Converter::setCacheLimits(const uint64_t maxEntries,
+                                const uint64_t maxBytes)
+{
+    m_cache->setLimits(maxEntries, maxBytes);
+}
+
+/**
+ * @brief remove all templates from the template-cache
+ */
+void
+Jinja2Converter::clearCache()
+{
+    m_cache->clear();
+}
+
+/**
+ * @brief set the function to load the template-string of included templates. Each included
+ *        template is loaded and compiled only once and the compiled form is shared by all
+ *        templates, which include it.
  *
- * @return Pair of string and boolean where the boolean shows
- *         if the item was found and is a string-type
- *         and the string contains the item, if the search was successful
+ * @param loader function, which gets the name of the include and writes the template-string
+ *               into the second argument. Returns false and an error-message in case of an
+ *               error. It can be called by multiple threads at the same time.
  */
-const std::pair<std::string, bool>
-Jinja2Converter::getString(DataMap* input,
-                           DataArray* jsonPath)
+void
+Jinja2Converter::setIncludeLoader(const Jinja2IncludeLoader &loader)
 {
-    // init
-    std::pair<std::string, bool> result;
-    result.second = false;
-
-    // make a generic item-search and than try to convert to string
-    std::pair<DataItem*, bool> item = getItem(input, jsonPath);
-    if(item.second == false) {
-        return result;
-    }
+    std::lock_guard<std::mutex> guard(m_includeLock);
+    m_includeLoader = loader;
+}
 
-    result.second = true;
-    result.first = item.first->toString(true);
+/**
+ * @brief remove all compiled included templates, so they are loaded again for new templates.
+ *        Already compiled templates keep their included templates.
+ */
+void
+Jinja2Converter::clearIncludes()
+{
+    std::lock_guard<std::mutex> guard(m_includeLock);
+    m_includes.clear();
+}
 
-    return result;
+/**
+ * @brief get the number of compiled included templates
+ *
+ * @return number of included templates
+ */
+uint64_t
+Jinja2Converter::getNumberOfIncludes()
+{
+    std::lock_guard<std::mutex> guard(m_includeLock);
+    return m_includes.size();
 }
 
 /**
- * @brief Search a specific item in the json-input
+ * @brief enable or disable profiling for all templates, which are compiled after this call.
+ *        Templates, which are already within the template-cache, are not changed.
  *
- * @param input The json-object in which the item sould be searched
- * @param jsonPath Path item in the json-object. It is a DataArray
- *                 which contains only string-objects
+ * @param enabled true to enable profiling
+ */
+void
+Jinja2Converter::setProfiling(const bool enabled)
+{
+    m_profiling.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ * @brief set the render-limits for all templates, which are compiled after this call. The
+ *        template-cache is cleared, so the limits are also used by all following converts.
+ *        Generated functions can not check the limits, so while any limit is set, the
+ *        compiled templates are used instead of them.
  *
- * @return Pair of json-value and boolean where the boolean shows
- *         if the item was found and the json-value contains the item,
- *         if the search was successful
+ * @param limits new limits. Values of 0 disable the single limits.
  */
-const std::pair<DataItem*, bool>
-Jinja2Converter::getItem(DataMap* input,
-                         DataArray* jsonPath)
+void
+Jinja2Converter::setRenderLimits(const RenderLimits &limits)
 {
-    // init
-    std::pair<DataItem*, bool> result;
-    result.second = false;
+    m_maxOutputSize.store(limits.maxOutputSize, std::memory_order_relaxed);
+    m_maxLoopIterations.store(limits.maxLoopIterations, std::memory_order_relaxed);
+    m_maxNestingDepth.store(limits.maxNestingDepth, std::memory_order_relaxed);
 
-    // search for the item
-    DataItem* tempJson = input;
-    for(uint32_t i = 0; i < jsonPath->size(); i++)
-    {
-        tempJson = tempJson->get(jsonPath->get(i)->toString());
-        if(tempJson == nullptr) {
-            return result;
-        }
-    }
+    m_cache->clear();
+}
 
-    result.second = true;
-    result.first = tempJson;
+/**
+ * @brief get the render-limits for new compiled templates
+ *
+ * @return current limits
+ */
+RenderLimits
+Jinja2Converter::getRenderLimits() const
+{
+    RenderLimits limits;
+    limits.maxOutputSize = m_maxOutputSize.load(std::memory_order_relaxed);
+    limits.maxLoopIterations = m_maxLoopIterations.load(std::memory_order_relaxed);
+    limits.maxNestingDepth = m_maxNestingDepth.load(std::memory_order_relaxed);
 
-    return result;
+    return limits;
 }
 
 /**
- * @brief Is called, when an error occurs while compiling and generates an error-message for output
- *
- * @param jsonPath path within the json-object to the item which was not found
+ * @brief check, if any render-limit is set
  *
- * @return error-messaage for the user
+ * @return true, if at least one limit is not 0, else false
  */
-const std::string
-Jinja2Converter::createErrorMessage(DataArray* jsonPath)
+bool
+Jinja2Converter::hasRenderLimits() const
 {
-    std::string errorMessage = "";
-    errorMessage =  "error while converting jinja2-template \n";
-    errorMessage += "    can not find item in path in json-input: ";
+    return m_maxOutputSize.load(std::memory_order_relaxed) != 0
+           || m_maxLoopIterations.load(std::memory_order_relaxed) != 0
+           || m_maxNestingDepth.load(std::memory_order_relaxed) != 0;
+}
 
-    // convert jsonPath into a string
-    for(uint32_t i = 0; i < jsonPath->size(); i++)
-    {
-        if(i != 0) {
-            errorMessage += ".";
-        }
-        errorMessage += jsonPath->get(i)->toString();
+/**
+ * @brief get the profile of a template within the template-cache
+ *
+ * @param profile reference for the profile-output
+ * @param templateString jinj2-formated string of the template
+ *
+ * @return false, if the template is not within the cache, else true
+ */
+bool
+Jinja2Converter::getProfile(TemplateProfile &profile,
+                            const std::string &templateString)
+{
+    // reading the profile is not a use of the template, so the cache-statistics are unchanged
+    std::shared_ptr<Jinja2Template> compiledTemplate = m_cache->peek(templateString);
+    if(compiledTemplate == nullptr) {
+        return false;
     }
 
-    errorMessage += "\n";
-    errorMessage += "    or maybe the item does not have a valid format";
-    errorMessage +=    " or the place where it should be used \n";
+    profile = compiledTemplate->getProfile();
+
+    return true;
+}
 
-    return errorMessage;
+/**
+ * @brief get the counters of the template-cache
+ *
+ * @return statistics-object with hits, misses, evictions and the current size of the cache
+ */
+TemplateCacheStatistics
+Jinja2Converter::getCacheStatistics()
+{
+    return m_cache->getStatistics();
 }
 
 }  // namespace Jinja2
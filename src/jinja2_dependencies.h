@@ -0,0 +1,212 @@
+/**
+ *  @file    jinja2_dependencies.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_DEPENDENCIES_H
+#define JINJA2_DEPENDENCIES_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include <jinja2_bytecode.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief get the path within the input, which has to change, so the value of a path can change.
+ *        Paths, which start with a loop-variable, depend on the array of the loop.
+ *
+ * @param bytecode bytecode with the path
+ * @param loops key-id of the variable and dependency of the array of each active loop
+ * @param pathId id of the path within the bytecode
+ *
+ * @return id of the path within the input
+ */
+inline uint32_t
+resolveDependency(const Jinja2Bytecode &bytecode,
+                  const std::vector<std::pair<uint32_t, uint32_t>> &loops,
+                  const uint32_t pathId)
+{
+    const Jinja2CompiledPath &path = bytecode.paths[pathId];
+    const uint32_t firstKey = bytecode.pathSegments[path.firstSegment];
+
+    // innermost loop shadows the outer loops and the input, like while rendering
+    for(uint64_t i = loops.size(); i > 0; i--)
+    {
+        if(loops[i - 1].first == firstKey) {
+            return loops[i - 1].second;
+        }
+    }
+
+    return pathId;
+}
+
+/**
+ * @brief add a path to the dependencies of the current segment, if not already added
+ *
+ * @param bytecode bytecode with the segments
+ * @param lastSegment id of the segment, which has added each path at last
+ * @param segmentId id of the current segment
+ * @param pathId id of the path
+ */
+inline void
+addSegmentDependency(Jinja2Bytecode &bytecode,
+                     std::vector<uint32_t> &lastSegment,
+                     const uint32_t segmentId,
+                     const uint32_t pathId)
+{
+    if(lastSegment[pathId] != segmentId)
+    {
+        lastSegment[pathId] = segmentId;
+        bytecode.segmentDependencies.push_back(pathId);
+    }
+}
+
+/**
+ * @brief split the instructions of a bytecode into top-level segments and collect the paths
+ *        within the input, which are read by each segment. A segment ends at the first position,
+ *        where no jump-target and no end of a loop of the segment is behind it, so each segment
+ *        can be rendered on its own. The bytecode must be valid.
+ *
+ * @param bytecode bytecode, which gets the segments
+ */
+inline void
+analyzeDependencies(Jinja2Bytecode &bytecode)
+{
+    bytecode.segments.clear();
+    bytecode.segmentDependencies.clear();
+
+    // segment, which has added the path at last, so each path exist only once per segment
+    std::vector<uint32_t> lastSegment(bytecode.numberOfPaths, UINT32_MAX);
+    std::vector<std::pair<uint32_t, uint32_t>> loops;
+
+    uint32_t pos = 0;
+    while(pos < bytecode.numberOfInstructions)
+    {
+        const uint32_t segmentId = static_cast<uint32_t>(bytecode.segments.size());
+
+        Jinja2Segment segment;
+        segment.firstInstruction = pos;
+        segment.firstDependency = static_cast<uint32_t>(bytecode.segmentDependencies.size());
+
+        uint32_t end = pos + 1;
+        while(pos < end)
+        {
+            const Jinja2Instruction &instruction = bytecode.instructions[pos];
+            uint32_t pathId = UINT32_MAX;
+
+            switch(instruction.opCode)
+            {
+                case EMIT_TEXT:
+                    break;
+                case EMIT_VAR:
+                    pathId = resolveDependency(bytecode, loops, instruction.arg0);
+                    break;
+                case JUMP_IF_FALSE:
+                    pathId = resolveDependency(bytecode,
+                                               loops,
+                                               bytecode.conditions[instruction.arg0].pathId);
+                    end = std::max(end, instruction.arg1);
+                    break;
+                case JUMP:
+                    end = std::max(end, instruction.arg1);
+                    break;
+                case LOOP_BEGIN:
+                    pathId = resolveDependency(bytecode, loops, instruction.arg0);
+                    loops.push_back(std::make_pair(instruction.arg2, pathId));
+                    end = std::max(end, instruction.arg1);
+                    break;
+                case LOOP_NEXT:
+                    if(loops.empty() == false) {
+                        loops.pop_back();
+                    }
+                    break;
+                case INCLUDE:
+                {
+                    // paths of the included template can also start with a loop-variable
+                    const Jinja2Include &include = bytecode.includes[instruction.arg0];
+                    for(const uint32_t includePath : include.dependencies)
+                    {
+                        addSegmentDependency(bytecode,
+                                             lastSegment,
+                                             segmentId,
+                                             resolveDependency(bytecode, loops, includePath));
+                    }
+                    break;
+                }
+            }
+
+            if(pathId != UINT32_MAX) {
+                addSegmentDependency(bytecode, lastSegment, segmentId, pathId);
+            }
+
+            pos++;
+        }
+
+        segment.endInstruction = end;
+        segment.numberOfDependencies = static_cast<uint32_t>(bytecode.segmentDependencies.size())
+                                       - segment.firstDependency;
+        bytecode.segments.push_back(segment);
+    }
+}
+
+/**
+ * @brief check if a path of the bytecode and a changed path of the input overlap, so the value
+ *        of the path is changed, if the changed path is equal to the path, one of its parents
+ *        or one of its children
+ *
+ * @param bytecode bytecode with the path
+ * @param pathId id of the path within the bytecode
+ * @param changedPath changed path as string with dots as separator. An empty string stands
+ *                    for the complete input.
+ *
+ * @return true, if the paths overlap, else false
+ */
+inline bool
+isPathAffected(const Jinja2Bytecode &bytecode,
+               const uint32_t pathId,
+               const std::string &changedPath)
+{
+    const Jinja2CompiledPath &path = bytecode.paths[pathId];
+
+    uint64_t pos = 0;
+    for(uint32_t i = 0; i < path.numberOfSegments; i++)
+    {
+        // changed path is a parent of the path
+        if(pos >= changedPath.size()) {
+            return true;
+        }
+
+        const std::string &name = bytecode.keyNames[bytecode.pathSegments[path.firstSegment + i]];
+        if(changedPath.compare(pos, name.size(), name) != 0) {
+            return false;
+        }
+
+        pos += name.size();
+        if(pos < changedPath.size())
+        {
+            if(changedPath[pos] != '.') {
+                return false;
+            }
+            pos++;
+        }
+    }
+
+    // path is equal to the changed path or one of its parents
+    return true;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_DEPENDENCIES_H
@@ -0,0 +1,303 @@
+/**
+ *  @file    jinja2_generated.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_generated.h>
+
+#include <jinja2_bytecode.h>
+#include <jinja2_output.h>
+#include <jinja2_condition.h>
+#include <jinja2_hash.h>
+
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <thread>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+struct GeneratedTemplateEntry
+{
+    std::string templateString = "";
+    Jinja2GeneratedFunction function = nullptr;
+};
+
+// snapshots are never modified after they were published. The functions are searched by the
+// same hash of the template-string like in the template-cache.
+struct GeneratedTemplateSnapshot
+{
+    std::unordered_multimap<uint64_t, GeneratedTemplateEntry> functions;
+};
+
+// functions are registered while the static initialization, so the registry is read-mostly.
+// Readers don't use a lock and only register themselves in the counter of their epoch, like
+// the readers of the Jinja2TemplateRegistry.
+struct GeneratedTemplateRegistry
+{
+    std::mutex updateLock;
+    std::atomic<GeneratedTemplateSnapshot*> snapshot {new GeneratedTemplateSnapshot()};
+    std::atomic<uint64_t> epoch {0};
+    std::atomic<uint64_t> readers[2];
+
+    // allows to skip the search, if there are no generated templates
+    std::atomic<uint64_t> numberOfFunctions {0};
+
+    GeneratedTemplateRegistry()
+    {
+        readers[0].store(0);
+        readers[1].store(0);
+    }
+
+    ~GeneratedTemplateRegistry()
+    {
+        delete snapshot.load();
+    }
+};
+
+/**
+ * @brief get the registry of the generated templates. It is created with the first call, so it
+ *        can already be used by the static registration of the generated code.
+ *
+ * @return reference to the registry
+ */
+static GeneratedTemplateRegistry&
+getRegistry()
+{
+    static GeneratedTemplateRegistry registry;
+    return registry;
+}
+
+/**
+ * @brief search an entry within a snapshot. The template-string is only compared for entries
+ *        with the same hash.
+ *
+ * @param snapshot snapshot to search in
+ * @param templateString template-string to search
+ * @param hash hash of the template-string
+ *
+ * @return iterator to the entry, if found, else the end of the map
+ */
+static std::unordered_multimap<uint64_t, GeneratedTemplateEntry>::const_iterator
+findEntry(const GeneratedTemplateSnapshot &snapshot,
+          const std::string &templateString,
+          const uint64_t hash)
+{
+    const auto range = snapshot.functions.equal_range(hash);
+    for(auto it = range.first; it != range.second; it++)
+    {
+        if(it->second.templateString == templateString) {
+            return it;
+        }
+    }
+
+    return snapshot.functions.end();
+}
+
+/**
+ * @brief publish a new snapshot and delete the old one, when no reader can use it anymore.
+ *        Must be called with the update-lock.
+ *
+ * @param registry registry of the generated templates
+ * @param newSnapshot new snapshot
+ */
+static void
+replaceSnapshot(GeneratedTemplateRegistry &registry,
+                GeneratedTemplateSnapshot* newSnapshot)
+{
+    GeneratedTemplateSnapshot* oldSnapshot = registry.snapshot.exchange(newSnapshot);
+    registry.numberOfFunctions.store(newSnapshot->functions.size());
+
+    // readers of the new epoch can only see the new snapshot
+    const uint64_t oldEpoch = registry.epoch.fetch_add(1);
+    while(registry.readers[oldEpoch & 1].load() != 0) {
+        std::this_thread::yield();
+    }
+
+    delete oldSnapshot;
+}
+
+/**
+ * @brief register a generated function, which is used by the convert-methods of the converter
+ *        instead of compiling and interpreting the template
+ *
+ * @param templateString template-string, which was used to generate the function
+ * @param templateSize length of the template-string
+ * @param function generated function
+ *
+ * @return false, if there is already a function for the template, else true
+ */
+bool
+registerGeneratedTemplate(const char* templateString,
+                          const uint64_t templateSize,
+                          Jinja2GeneratedFunction function)
+{
+    GeneratedTemplateRegistry &registry = getRegistry();
+    std::lock_guard<std::mutex> guard(registry.updateLock);
+
+    GeneratedTemplateEntry entry;
+    entry.templateString = std::string(templateString, templateSize);
+    entry.function = function;
+    const uint64_t hash = calculateHash(entry.templateString);
+
+    const GeneratedTemplateSnapshot* snapshot = registry.snapshot.load();
+    if(findEntry(*snapshot, entry.templateString, hash) != snapshot->functions.end()) {
+        return false;
+    }
+
+    GeneratedTemplateSnapshot* newSnapshot = new GeneratedTemplateSnapshot(*snapshot);
+    newSnapshot->functions.insert(std::make_pair(hash, entry));
+    replaceSnapshot(registry, newSnapshot);
+
+    return true;
+}
+
+/**
+ * @brief remove a registered generated function
+ *
+ * @param templateString template-string of the function
+ *
+ * @return false, if there is no function for the template, else true
+ */
+bool
+unregisterGeneratedTemplate(const std::string &templateString)
+{
+    GeneratedTemplateRegistry &registry = getRegistry();
+    std::lock_guard<std::mutex> guard(registry.updateLock);
+
+    const uint64_t hash = calculateHash(templateString);
+    const GeneratedTemplateSnapshot* snapshot = registry.snapshot.load();
+    if(findEntry(*snapshot, templateString, hash) == snapshot->functions.end()) {
+        return false;
+    }
+
+    GeneratedTemplateSnapshot* newSnapshot = new GeneratedTemplateSnapshot(*snapshot);
+    newSnapshot->functions.erase(findEntry(*newSnapshot, templateString, hash));
+    replaceSnapshot(registry, newSnapshot);
+
+    return true;
+}
+
+/**
+ * @brief search the generated function of a template
+ *
+ * @param templateString template-string to search
+ *
+ * @return pointer to the function, if registered, else nullptr
+ */
+Jinja2GeneratedFunction
+getGeneratedTemplate(const std::string &templateString)
+{
+    return getGeneratedTemplate(templateString, calculateHash(templateString));
+}
+
+/**
+ * @brief search the generated function of a template without a lock
+ *
+ * @param templateString template-string to search
+ * @param hash hash of the template-string, which was created with calculateHash of
+ *             jinja2_hash.h, so it can be shared with the template-cache
+ *
+ * @return pointer to the function, if registered, else nullptr
+ */
+Jinja2GeneratedFunction
+getGeneratedTemplate(const std::string &templateString,
+                     const uint64_t hash)
+{
+    GeneratedTemplateRegistry &registry = getRegistry();
+    if(registry.numberOfFunctions.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+
+    // register as reader of the current epoch, so the snapshot is not deleted while reading
+    uint64_t epoch = 0;
+    while(true)
+    {
+        epoch = registry.epoch.load();
+        registry.readers[epoch & 1].fetch_add(1);
+        if(registry.epoch.load() == epoch) {
+            break;
+        }
+        registry.readers[epoch & 1].fetch_sub(1);
+    }
+
+    Jinja2GeneratedFunction result = nullptr;
+    const GeneratedTemplateSnapshot* snapshot = registry.snapshot.load();
+    const auto it = findEntry(*snapshot, templateString, hash);
+    if(it != snapshot->functions.end()) {
+        result = it->second.function;
+    }
+
+    registry.readers[epoch & 1].fetch_sub(1);
+
+    return result;
+}
+
+/**
+ * @brief append the value of an item to the output in the same format like the interpreter
+ *
+ * @param output string, where the value should be appended
+ * @param item item to append
+ */
+void
+appendGeneratedValue(std::string &output,
+                     DataItem* item)
+{
+    appendValue(output, item);
+}
+
+/**
+ * @brief evaluate an if-condition of the generated code in the same way like the interpreter
+ *
+ * @param item value of the left side of the condition
+ * @param compareType type of the comparison
+ * @param constantType type of the right side
+ * @param longValue right side as integer, if it is an integer
+ * @param boolValue right side as bool, if it is a bool-identifier
+ * @param text right side as null-terminated string
+ *
+ * @return result of the condition
+ */
+bool
+evaluateGeneratedCondition(DataItem* item,
+                           const uint32_t compareType,
+                           const uint32_t constantType,
+                           const int64_t longValue,
+                           const bool boolValue,
+                           const char* text)
+{
+    Jinja2Condition condition;
+    condition.compareType = compareType;
+    condition.constantType = constantType;
+    condition.longValue = longValue;
+    condition.boolValue = boolValue;
+
+    return evaluateCondition(condition, text, item);
+}
+
+/**
+ * @brief create the error-message for a path, which was not found within the input
+ *
+ * @param errorMessage reference for error-message output
+ * @param path path, which was not found, as string
+ */
+void
+createGeneratedErrorMessage(std::string &errorMessage,
+                            const char* path)
+{
+    errorMessage =  "error while converting jinja2-template \n";
+    errorMessage += "    can not find item in path in json-input: ";
+    errorMessage += path;
+    errorMessage += "\n";
+    errorMessage += "    or maybe the item does not have a valid format";
+    errorMessage +=    " or the place where it should be used \n";
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
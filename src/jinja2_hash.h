@@ -0,0 +1,59 @@
+/**
+ *  @file    jinja2_hash.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_HASH_H
+#define JINJA2_HASH_H
+
+#include <stdint.h>
+#include <string>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief calculate a 64-bit FNV-1a hash. In contrast to std::hash the result is stable over
+ *        different builds and platforms.
+ *
+ * @param data pointer to the data to hash
+ * @param size number of bytes to hash
+ *
+ * @return hash-value
+ */
+inline uint64_t
+calculateHash(const char* data,
+              const uint64_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for(uint64_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief calculate a 64-bit FNV-1a hash of a string
+ *
+ * @param input string to hash
+ *
+ * @return hash-value
+ */
+inline uint64_t
+calculateHash(const std::string &input)
+{
+    return calculateHash(input.c_str(), input.size());
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_HASH_H
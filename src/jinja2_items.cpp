@@ -16,14 +16,11 @@ namespace Jinja2
 //===================================================================
 // Jinja2Item
 //===================================================================
+// all items are created within the arena of the parser-interface, which frees all items
+// at once, so the items don't delete their children
 Jinja2Item::Jinja2Item() {}
 
-Jinja2Item::~Jinja2Item()
-{
-    if(next != nullptr) {
-        delete next;
-    }
-}
+Jinja2Item::~Jinja2Item() {}
 
 Jinja2Item::ItemType Jinja2Item::getType() const
 {
@@ -49,27 +46,21 @@ ReplaceItem::~ReplaceItem() {}
 //===================================================================
 IfItem::IfItem() {type = IF_ITEM;}
 
-IfItem::~IfItem()
-{
-    if(ifChild != nullptr) {
-        delete ifChild;
-    }
-    if(elseChild != nullptr) {
-        delete elseChild;
-    }
-}
+IfItem::~IfItem() {}
 
 //===================================================================
 // ForLoopItem
 //===================================================================
 ForLoopItem::ForLoopItem() {type = FOR_ITEM;}
 
-ForLoopItem::~ForLoopItem()
-{
-    if(forChild != nullptr) {
-        delete forChild;
-    }
-}
+ForLoopItem::~ForLoopItem() {}
+
+//===================================================================
+// IncludeItem
+//===================================================================
+IncludeItem::IncludeItem() {type = INCLUDE_ITEM;}
+
+IncludeItem::~IncludeItem() {}
 
 }  // namespace Jinja2
 }  // namespace Kitsunemimi
@@ -23,6 +23,23 @@ namespace Kitsunemimi
 namespace Jinja2
 {
 
+//===================================================================
+// Jinja2Path
+//===================================================================
+struct Jinja2PathSegment
+{
+    const char* name = nullptr;
+    uint32_t length = 0;
+    Jinja2PathSegment* next = nullptr;
+};
+
+struct Jinja2Path
+{
+    Jinja2PathSegment* first = nullptr;
+    Jinja2PathSegment* last = nullptr;
+    uint32_t numberOfSegments = 0;
+};
+
 //===================================================================
 // SakuraItem
 //===================================================================
@@ -35,7 +52,8 @@ public:
         REPLACE_ITEM = 1,
         IF_ITEM = 2,
         FOR_ITEM = 3,
-        TEXT_ITEM = 4
+        TEXT_ITEM = 4,
+        INCLUDE_ITEM = 5
     };
 
     Jinja2Item();
@@ -44,6 +62,9 @@ public:
     Jinja2Item* next = nullptr;
     Jinja2Item* startPoint = nullptr;
 
+    // byte-offset of the item within the template-string
+    uint32_t position = 0;
+
     ItemType getType() const;
 
 protected:
@@ -71,7 +92,7 @@ public:
     ReplaceItem();
     ~ReplaceItem();
 
-    DataArray iterateArray;
+    Jinja2Path* iterateArray = nullptr;
 };
 
 //===================================================================
@@ -86,18 +107,22 @@ public:
         GREATER = 2,
         SMALLER_EQUAL = 3,
         SMALLER = 4,
-        UNEQUAL = 5
+        UNEQUAL = 5,
+        IS_TRUE = 6
     };
 
     IfItem();
     ~IfItem();
 
-    DataArray leftSide;
+    Jinja2Path* leftSide = nullptr;
     compareTypes ifType = EQUAL;
     DataValue rightSide;
 
     Jinja2Item* ifChild = nullptr;
     Jinja2Item* elseChild = nullptr;
+
+    // byte-offset of the else-tag within the template-string
+    uint32_t elsePosition = 0;
 };
 
 //===================================================================
@@ -110,11 +135,26 @@ public:
     ~ForLoopItem();
 
     std::string tempVarName = "";
-    DataArray iterateArray;
+    Jinja2Path* iterateArray = nullptr;
 
     Jinja2Item* forChild = nullptr;
+
+    // byte-offset of the endfor-tag within the template-string
+    uint32_t endPosition = 0;
 };
 
+//===================================================================
+// IncludeItem
+//===================================================================
+class IncludeItem : public Jinja2Item
+{
+public:
+    IncludeItem();
+    ~IncludeItem();
+
+    // name of the included template, which is resolved by the include-loader of the converter
+    std::string name = "";
+};
 
 }  // namespace Jinja2
 }  // namespace Kitsunemimi
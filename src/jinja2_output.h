@@ -0,0 +1,145 @@
+/**
+ *  @file    jinja2_output.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_OUTPUT_H
+#define JINJA2_OUTPUT_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <libKitsunemimiCommon/common_items/data_items.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief format an integer directly into the output-string without a temporary string
+ *
+ * @param output string, where the number should be appended
+ * @param value number to append
+ */
+inline void
+appendInteger(std::string &output,
+              const long value)
+{
+    // convert into unsigned to handle the minimum value correctly
+    unsigned long absValue = static_cast<unsigned long>(value);
+    if(value < 0) {
+        absValue = 0UL - absValue;
+    }
+
+    // count digits to resize the output only once
+    uint32_t numberOfDigits = 1;
+    unsigned long temp = absValue;
+    while(temp >= 10)
+    {
+        temp /= 10;
+        numberOfDigits++;
+    }
+
+    const uint64_t oldSize = output.size();
+    const uint32_t sign = (value < 0) ? 1 : 0;
+    output.resize(oldSize + sign + numberOfDigits);
+
+    // write digits from the end to the begin
+    char* pos = &output[oldSize + sign + numberOfDigits - 1];
+    do
+    {
+        *pos = static_cast<char>('0' + (absValue % 10));
+        absValue /= 10;
+        pos--;
+    }
+    while(absValue != 0);
+
+    if(sign == 1) {
+        output[oldSize] = '-';
+    }
+}
+
+/**
+ * @brief format a floating-point value directly into the output-string. It uses the same
+ *        format like std::to_string to be compatible with the string-conversion of the DataValue.
+ *
+ * @param output string, where the number should be appended
+ * @param value number to append
+ */
+inline void
+appendFloat(std::string &output,
+            const double value)
+{
+    char buffer[64];
+    const int length = snprintf(buffer, sizeof(buffer), "%f", value);
+    if(length < 0) {
+        return;
+    }
+
+    if(static_cast<uint64_t>(length) < sizeof(buffer))
+    {
+        output.append(buffer, static_cast<uint64_t>(length));
+        return;
+    }
+
+    // very big numbers don't fit into the buffer and are written into the output directly
+    const uint64_t oldSize = output.size();
+    output.resize(oldSize + static_cast<uint64_t>(length) + 1);
+    snprintf(&output[oldSize], static_cast<uint64_t>(length) + 1, "%f", value);
+    output.resize(oldSize + static_cast<uint64_t>(length));
+}
+
+/**
+ * @brief append the content of a data-item to the output-string. Strings are copied directly
+ *        from the storage of the value and numbers are formatted within the output, so no
+ *        temporary strings are necessary.
+ *
+ * @param output string, where the value should be appended
+ * @param item item to append
+ */
+inline void
+appendValue(std::string &output,
+            DataItem* item)
+{
+    // maps and arrays are appended as json-formated strings
+    if(item->getType() != DataItem::VALUE_TYPE)
+    {
+        output.append(item->toString(true));
+        return;
+    }
+
+    DataValue* value = item->toValue();
+    switch(value->getValueType())
+    {
+        case DataItem::STRING_TYPE:
+            output.append(value->content.stringValue);
+            break;
+        case DataItem::INT_TYPE:
+            appendInteger(output, value->getLong());
+            break;
+        case DataItem::FLOAT_TYPE:
+            appendFloat(output, value->getDouble());
+            break;
+        case DataItem::BOOL_TYPE:
+            if(value->getBool()) {
+                output.append("true", 4);
+            } else {
+                output.append("false", 5);
+            }
+            break;
+        default:
+            output.append(item->toString(true));
+            break;
+    }
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_OUTPUT_H
@@ -0,0 +1,137 @@
+/**
+ *  @file    jinja2_parallel.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <jinja2_parallel.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief get the pool, which is shared by all templates. The threads are stopped at the end
+ *        of the program.
+ *
+ * @return pointer to the pool
+ */
+Jinja2WorkerPool*
+Jinja2WorkerPool::getInstance()
+{
+    static Jinja2WorkerPool instance;
+    return &instance;
+}
+
+/**
+ * @brief constructor. Threads are only created, when they are requested by a job.
+ */
+Jinja2WorkerPool::Jinja2WorkerPool() {}
+
+/**
+ * @brief destructor, which stops and joins all threads
+ */
+Jinja2WorkerPool::~Jinja2WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for(std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+/**
+ * @brief offer a job to the threads of the pool. The pool gets new threads, if it has less
+ *        threads than requested, so it has never more threads than the biggest job.
+ *
+ * @param job job, which must stay valid until finish is called
+ * @param numberOfThreads maximum number of threads of the pool, which can join the job
+ */
+void
+Jinja2WorkerPool::start(Jinja2PoolJob &job,
+                        const uint32_t numberOfThreads)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        while(m_threads.size() < numberOfThreads) {
+            m_threads.emplace_back([this]() { run(); });
+        }
+
+        job.openSlots = numberOfThreads;
+        job.activeThreads = 0;
+        m_jobs.push_back(&job);
+    }
+
+    m_jobAvailable.notify_all();
+}
+
+/**
+ * @brief close a job for new threads and wait, until all threads, which have joined it, are
+ *        finished. Must be called, after the work of the calling thread has returned.
+ *
+ * @param job job, which was started before
+ */
+void
+Jinja2WorkerPool::finish(Jinja2PoolJob &job)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    if(job.openSlots > 0)
+    {
+        for(auto it = m_jobs.begin(); it != m_jobs.end(); it++)
+        {
+            if(*it == &job)
+            {
+                m_jobs.erase(it);
+                break;
+            }
+        }
+        job.openSlots = 0;
+    }
+
+    m_jobFinished.wait(guard, [&job]() { return job.activeThreads == 0; });
+}
+
+/**
+ * @brief loop of each thread of the pool, which runs the work of the offered jobs
+ */
+void
+Jinja2WorkerPool::run()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    while(true)
+    {
+        m_jobAvailable.wait(guard, [this]() { return m_stop || m_jobs.empty() == false; });
+        if(m_stop) {
+            return;
+        }
+
+        Jinja2PoolJob* job = m_jobs.front();
+        job->openSlots--;
+        if(job->openSlots == 0) {
+            m_jobs.pop_front();
+        }
+        job->activeThreads++;
+
+        guard.unlock();
+        job->work();
+        guard.lock();
+
+        job->activeThreads--;
+        if(job->activeThreads == 0) {
+            m_jobFinished.notify_all();
+        }
+    }
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
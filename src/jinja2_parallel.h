@@ -0,0 +1,252 @@
+/**
+ *  @file    jinja2_parallel.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_PARALLEL_H
+#define JINJA2_PARALLEL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief get number of threads, which should be used, if the caller doesn't define it
+ *
+ * @param numberOfThreads requested number of threads. 0 means one thread per cpu-core.
+ * @param numberOfItems number of items to process, because more threads than items are useless
+ *
+ * @return number of threads to use, which is at least 1
+ */
+inline uint32_t
+getNumberOfThreads(uint32_t numberOfThreads,
+                   const uint64_t numberOfItems)
+{
+    if(numberOfThreads == 0) {
+        numberOfThreads = std::thread::hardware_concurrency();
+    }
+    if(numberOfThreads > numberOfItems) {
+        numberOfThreads = static_cast<uint32_t>(numberOfItems);
+    }
+    if(numberOfThreads == 0) {
+        numberOfThreads = 1;
+    }
+
+    return numberOfThreads;
+}
+
+//===================================================================
+// Jinja2WorkerPool
+//===================================================================
+// work of one caller, which is shared with the threads of the pool. Each thread, which joins
+// the job, calls the work-function once, and the function returns, when no work is left.
+struct Jinja2PoolJob
+{
+    std::function<void()> work;
+
+    // number of threads of the pool, which can still join the job, and which are running it.
+    // Both are protected by the lock of the pool.
+    uint32_t openSlots = 0;
+    uint32_t activeThreads = 0;
+};
+
+/**
+ * Threads, which are created only once and reused by all parallel loops and batch-renders, so
+ * no thread has to be created while rendering. The calling thread always works on its own job
+ * too, so each job is finished, even if all threads of the pool are busy with other jobs.
+ */
+class Jinja2WorkerPool
+{
+public:
+    static Jinja2WorkerPool* getInstance();
+    ~Jinja2WorkerPool();
+
+    void start(Jinja2PoolJob &job,
+               const uint32_t numberOfThreads);
+    void finish(Jinja2PoolJob &job);
+
+private:
+    Jinja2WorkerPool();
+
+    std::mutex m_lock;
+    std::condition_variable m_jobAvailable;
+    std::condition_variable m_jobFinished;
+    std::deque<Jinja2PoolJob*> m_jobs;
+    std::vector<std::thread> m_threads;
+    bool m_stop = false;
+
+    void run();
+};
+
+/**
+ * @brief process items with multiple threads. The calling thread works together with the
+ *        threads of the worker-pool. Each thread takes the next unprocessed item, when it has
+ *        finished its last one, so items with different processing-time are balanced between
+ *        the threads.
+ *
+ * @param numberOfItems number of items to process
+ * @param numberOfThreads maximum number of threads including the calling thread.
+ *                        0 means one thread per cpu-core.
+ * @param function function, which is called with the index of each item
+ */
+template<typename FUNC>
+void
+parallelFor(const uint64_t numberOfItems,
+            const uint32_t numberOfThreads,
+            const FUNC &function)
+{
+    std::atomic<uint64_t> nextItem(0);
+
+    auto worker = [&]()
+    {
+        uint64_t index = nextItem.fetch_add(1, std::memory_order_relaxed);
+        while(index < numberOfItems)
+        {
+            function(index);
+            index = nextItem.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    const uint32_t threads = getNumberOfThreads(numberOfThreads, numberOfItems);
+    if(threads == 1)
+    {
+        worker();
+        return;
+    }
+
+    Jinja2PoolJob job;
+    job.work = worker;
+
+    Jinja2WorkerPool* pool = Jinja2WorkerPool::getInstance();
+    pool->start(job, threads - 1);
+    worker();
+    pool->finish(job);
+}
+
+/**
+ * @brief process items with multiple threads and consume the results in the order of the
+ *        items on the calling thread, as soon as all items before are consumed. The threads
+ *        only process items within a window behind the last consumed item, so not more than
+ *        this number of results exist at the same time.
+ *
+ * @param numberOfItems number of items to process
+ * @param numberOfThreads maximum number of threads including the calling thread.
+ *                        0 means one thread per cpu-core.
+ * @param window maximum number of processed items, which are not consumed yet
+ * @param function function, which is called with the index of each item
+ * @param consume function, which is called on the calling thread with the index of each
+ *                processed item in order. When it returns false, no new items are processed.
+ *
+ * @return false, if consume has returned false, else true
+ */
+template<typename FUNC, typename CONSUME>
+bool
+parallelForOrdered(const uint64_t numberOfItems,
+                   const uint32_t numberOfThreads,
+                   const uint64_t window,
+                   const FUNC &function,
+                   const CONSUME &consume)
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<uint8_t> done(numberOfItems, 0);
+    uint64_t nextItem = 0;
+    uint64_t consumed = 0;
+    bool stopped = false;
+
+    // process one claimed item while the lock is released
+    auto process = [&](std::unique_lock<std::mutex> &guard)
+    {
+        const uint64_t index = nextItem++;
+        guard.unlock();
+        function(index);
+        guard.lock();
+        done[index] = 1;
+        changed.notify_all();
+    };
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while(true)
+        {
+            changed.wait(guard, [&]()
+            {
+                return stopped
+                       || nextItem >= numberOfItems
+                       || nextItem < consumed + window;
+            });
+            if(stopped
+                    || nextItem >= numberOfItems)
+            {
+                return;
+            }
+            process(guard);
+        }
+    };
+
+    const uint32_t threads = getNumberOfThreads(numberOfThreads, numberOfItems);
+    Jinja2PoolJob job;
+    job.work = worker;
+
+    Jinja2WorkerPool* pool = Jinja2WorkerPool::getInstance();
+    if(threads > 1) {
+        pool->start(job, threads - 1);
+    }
+
+    // the calling thread consumes the results and processes items itself, while the next
+    // result is not ready
+    bool result = true;
+    std::unique_lock<std::mutex> guard(lock);
+    while(consumed < numberOfItems)
+    {
+        if(done[consumed] == 1)
+        {
+            guard.unlock();
+            result = consume(consumed);
+            guard.lock();
+            if(result == false) {
+                break;
+            }
+            consumed++;
+            changed.notify_all();
+        }
+        else if(nextItem < numberOfItems
+                && nextItem < consumed + window)
+        {
+            process(guard);
+        }
+        else
+        {
+            changed.wait(guard);
+        }
+    }
+
+    stopped = true;
+    changed.notify_all();
+    guard.unlock();
+
+    if(threads > 1) {
+        pool->finish(job);
+    }
+
+    return result;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_PARALLEL_H
@@ -7,12 +7,85 @@
 */
 
 #include <jinja2_parsing/jinja2_parser_interface.h>
+#include <jinja2_parsing/jinja2_text_scanner.h>
 #include <jinja2_parser.h>
 
 # define YY_DECL \
-    Kitsunemimi::Jinja2::Jinja2Parser::symbol_type jinja2lex (Kitsunemimi::Jinja2::Jinja2ParserInterface& driver)
+    Kitsunemimi::Jinja2::Jinja2Parser::symbol_type jinja2lex (Kitsunemimi::Jinja2::Jinja2ParserInterface& driver, \
+                                                              void* yyscanner)
 YY_DECL;
 
+// flex-scanner for the content of the expressions, which is defined in the jinja2_lexer.l
+Kitsunemimi::Jinja2::Jinja2Parser::symbol_type
+jinja2lexExpression(Kitsunemimi::Jinja2::Jinja2ParserInterface& driver,
+                    void* yyscanner);
+
+// location of the current token within the extra-data of the flex-scanner
+Kitsunemimi::Jinja2::location* jinja2get_extra(void* yyscanner);
+
+/**
+ * Get the next token for the parser. Text is scanned directly within the input-string up to
+ * the next start of an expression. The content of an expression is given to the flex-scanner
+ * until its end-delimiter is reached.
+ *
+ * @param driver parser-interface with the input-string
+ * @param yyscanner state of the reentrant flex-scanner
+ *
+ * @return next token
+ */
+YY_DECL
+{
+    using Kitsunemimi::Jinja2::Jinja2Parser;
+
+    Kitsunemimi::Jinja2::Jinja2ScanState &state = driver.getScanState();
+    Kitsunemimi::Jinja2::location &location = *jinja2get_extra(yyscanner);
+
+    if(state.inExpression)
+    {
+        Jinja2Parser::symbol_type token = jinja2lexExpression(driver, yyscanner);
+
+        // the location counts the scanned bytes, so the end of the expression is reached, if
+        // the end of the token is at the end of the expression
+        if(static_cast<uint64_t>(location.end.column - 1) >= state.expressionEnd)
+        {
+            driver.endExpression();
+            state.position = state.expressionEnd;
+        }
+
+        return token;
+    }
+
+    location.step();
+    if(state.position >= state.size) {
+        return Jinja2Parser::make_END(location);
+    }
+
+    const char* data = state.input + state.position;
+    const uint64_t remaining = state.size - state.position;
+
+    // whole runs of text are returned at once
+    const uint64_t textLength = Kitsunemimi::Jinja2::findExpressionStart(data, remaining);
+    if(textLength > 0)
+    {
+        location.columns(static_cast<int>(textLength));
+        state.position += textLength;
+        return Jinja2Parser::make_TEXT(std::string(data, textLength), location);
+    }
+
+    // the content of the expression ends behind the first end-delimiter or at the end of the
+    // input, where the flex-scanner returns the end of the file
+    const uint64_t contentBegin = state.position + 2;
+    const uint64_t contentEnd = contentBegin + Kitsunemimi::Jinja2::findExpressionEnd(data + 2,
+                                                                                   remaining - 2);
+    driver.beginExpression(contentBegin, contentEnd);
+    location.columns(2);
+
+    if(data[1] == '%') {
+        return Jinja2Parser::make_EXPRESTART_SP(location);
+    }
+    return Jinja2Parser::make_EXPRESTART(location);
+}
+
 namespace Kitsunemimi
 {
 namespace Jinja2
@@ -43,10 +116,15 @@ Jinja2ParserInterface::parse(const std::string &inputString)
     m_inputString = inputString;
     m_errorMessage = "";
     m_output = nullptr;
+    m_arena.clear();
+
+    m_scanState = Jinja2ScanState();
+    m_scanState.input = m_inputString.c_str();
+    m_scanState.size = m_inputString.size();
 
     // run parser-code
     this->scan_begin(inputString);
-    Kitsunemimi::Jinja2::Jinja2Parser parser(*this);
+    Kitsunemimi::Jinja2::Jinja2Parser parser(*this, m_scanner);
     int res = parser.parse();
     this->scan_end();
 
@@ -56,6 +134,17 @@ Jinja2ParserInterface::parse(const std::string &inputString)
     return true;
 }
 
+/**
+ * Getter for the position of the text-scanner, which is used by the lexer
+ *
+ * @return reference to the scan-state
+ */
+Jinja2ScanState&
+Jinja2ParserInterface::getScanState()
+{
+    return m_scanState;
+}
+
 /**
  * Is called for the parser after successfully parsing the input-string
  *
@@ -68,9 +157,10 @@ Jinja2ParserInterface::setOutput(Jinja2Item *output)
 }
 
 /**
- * getter for the json-output of the parser
+ * getter for the output of the parser. The items belong to the arena of the parser-interface
+ * and are valid until the next parsing-run or until the parser-interface is deleted.
  *
- * @return parser-output as DataArray
+ * @return root-item of the parser-output, nullptr for an empty template
  */
 Jinja2Item*
 Jinja2ParserInterface::getOutput() const
@@ -78,6 +168,61 @@ Jinja2ParserInterface::getOutput() const
     return m_output;
 }
 
+/**
+ * Create a new path with one segment within the arena
+ *
+ * @param name name of the first segment
+ *
+ * @return pointer to the new path
+ */
+Jinja2Path*
+Jinja2ParserInterface::createPath(const std::string &name)
+{
+    Jinja2Path* path = m_arena.create<Jinja2Path>();
+    appendToPath(path, name);
+
+    return path;
+}
+
+/**
+ * Append a new segment to a path
+ *
+ * @param path path, where the segment should be added
+ * @param name name of the new segment
+ */
+void
+Jinja2ParserInterface::appendToPath(Jinja2Path* path,
+                                    const std::string &name)
+{
+    Jinja2PathSegment* segment = m_arena.create<Jinja2PathSegment>();
+    segment->name = m_arena.copyString(name.c_str(), name.size());
+    segment->length = static_cast<uint32_t>(name.size());
+
+    if(path->last == nullptr) {
+        path->first = segment;
+    } else {
+        path->last->next = segment;
+    }
+
+    path->last = segment;
+    path->numberOfSegments++;
+}
+
+/**
+ * Convert the location of a token into its byte-offset within the parsed string
+ *
+ * @param location location-object of the bison-parser
+ *
+ * @return byte-offset of the begin of the token
+ */
+uint32_t
+Jinja2ParserInterface::getPosition(const Kitsunemimi::Jinja2::location &location) const
+{
+    // the scanner counts all characters as columns of the first line, so the column is the
+    // offset within the string, starting with 1
+    return static_cast<uint32_t>(location.begin.column - 1);
+}
+
 /**
  * Is called from the parser in case of an error
  *
@@ -91,15 +236,20 @@ Jinja2ParserInterface::error(const Kitsunemimi::Jinja2::location& location,
                              const std::string& message)
 {
     // get the broken part of the parsed string
-    const uint32_t errorStart = location.begin.column;
+    const uint32_t errorStart = getPosition(location);
     const uint32_t errorLength = location.end.column - location.begin.column;
     const std::string errorStringPart = m_inputString.substr(errorStart, errorLength);
 
+    // the scanner doesn't count newlines, so line and column are calculated only here
+    uint32_t line = 0;
+    uint32_t column = 0;
+    getLineAndColumn(m_inputString.c_str(), errorStart, line, column);
+
     // build error-message
     m_errorMessage =  "error while parsing jinja2-template \n";
     m_errorMessage += "parser-message: " + message + " \n";
-    m_errorMessage += "line-number: " + std::to_string(location.begin.line) + " \n";
-    m_errorMessage += "position in line: " + std::to_string(location.begin.column) + " \n";
+    m_errorMessage += "line-number: " + std::to_string(line) + " \n";
+    m_errorMessage += "position in line: " + std::to_string(column) + " \n";
     m_errorMessage += "broken part in template: \"" + errorStringPart + "\" \n";
 }
 
@@ -13,12 +13,35 @@
 #include <string>
 #include <iostream>
 
+#include <jinja2_arena.h>
+#include <jinja2_items.h>
+
 namespace Kitsunemimi
 {
 namespace Jinja2
 {
 class location;
-class Jinja2Item;
+
+//===================================================================
+// Jinja2ScanState
+//===================================================================
+// The text outside of the expressions is scanned by the parser-interface directly within the
+// input-string and only the content of each expression is given to the flex-scanner.
+struct Jinja2ScanState
+{
+    const char* input = nullptr;
+    uint64_t size = 0;
+
+    // current position of the text-scanner
+    uint64_t position = 0;
+
+    // position behind the end-delimiter of the current expression
+    uint64_t expressionEnd = 0;
+    bool inExpression = false;
+
+    // flex-buffer with the content of the current expression
+    void* expressionBuffer = nullptr;
+};
 
 class Jinja2ParserInterface
 {
@@ -31,20 +54,51 @@ public:
     void scan_end();
     bool parse(const std::string &inputString);
 
+    // scanning of the expressions by the flex-scanner
+    Jinja2ScanState& getScanState();
+    void beginExpression(const uint64_t begin,
+                         const uint64_t end);
+    void endExpression();
+
     // output-handling
     void setOutput(Jinja2Item* output);
     Jinja2Item* getOutput() const;
 
+    // creation of the parsed objects within the arena
+    /**
+     * @brief create a new item within the arena of the parser-interface. It is valid until
+     *        the next parsing-run or until the parser-interface is deleted.
+     *
+     * @return pointer to the new item
+     */
+    template<typename T>
+    T* createItem()
+    {
+        return m_arena.create<T>();
+    }
+    Jinja2Path* createPath(const std::string &name);
+    void appendToPath(Jinja2Path* path,
+                      const std::string &name);
+
+    uint32_t getPosition(const Kitsunemimi::Jinja2::location &location) const;
+
     // Error handling.
     void error(const Kitsunemimi::Jinja2::location &location,
                const std::string& message);
     std::string getErrorMessage() const;
 
 private:
-    Jinja2Item* m_output;
+    Jinja2Item* m_output = nullptr;
     std::string m_errorMessage = "";
     std::string m_inputString = "";
 
+    // state of the reentrant flex-scanner
+    void* m_scanner = nullptr;
+    Jinja2ScanState m_scanState;
+
+    // owner of all items and paths of the last parsing-run
+    Jinja2Arena m_arena;
+
     bool m_traceParsing = false;
 };
 
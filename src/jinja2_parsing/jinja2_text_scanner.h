@@ -0,0 +1,264 @@
+/**
+ *  @file    jinja2_text_scanner.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_TEXT_SCANNER_H
+#define JINJA2_TEXT_SCANNER_H
+
+#include <stdint.h>
+#include <algorithm>
+
+// the AVX2-variant is compiled with a target-attribute, so it exist also without -mavx2 and is
+// selected at runtime, if the cpu supports it
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JINJA2_SCANNER_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// The text outside of the expressions is not scanned by flex, but with the functions here. They
+// compare 32 bytes with AVX2 or 16 bytes with SSE2 at once and fall back to a scalar loop for
+// the tail and for other architectures. AVX2 is used, if the cpu supports it, else SSE2.
+
+/**
+ * @brief check once, if the cpu supports AVX2
+ *
+ * @return true, if the AVX2-variants can be used, else false
+ */
+inline bool
+hasAvx2()
+{
+#if defined(__AVX2__)
+    return true;
+#elif defined(JINJA2_SCANNER_AVX2)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+#if defined(JINJA2_SCANNER_AVX2)
+/**
+ * @brief search the next start-delimiter with 32 bytes at once, as long as 33 bytes are left
+ *
+ * @param data pointer to the text
+ * @param size number of bytes of the text
+ * @param pos reference for the position, where the search starts and where the scalar search
+ *            has to continue, if nothing was found
+ *
+ * @return offset of the first delimiter, or size, if there is no delimiter in the vectors
+ */
+__attribute__((target("avx2"))) inline uint64_t
+findExpressionStartAvx2(const char* data,
+                        const uint64_t size,
+                        uint64_t &pos)
+{
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i percent = _mm256_set1_epi8('%');
+    while(pos + 33 <= size)
+    {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 1));
+        const __m256i match = _mm256_and_si256(_mm256_cmpeq_epi8(first, openBrace),
+                                               _mm256_or_si256(_mm256_cmpeq_epi8(second, openBrace),
+                                                               _mm256_cmpeq_epi8(second, percent)));
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+        if(mask != 0) {
+            return pos + static_cast<uint64_t>(__builtin_ctz(mask));
+        }
+        pos += 32;
+    }
+
+    return size;
+}
+
+/**
+ * @brief search the next end-delimiter with 32 bytes at once, as long as 33 bytes are left
+ *
+ * @param data pointer to the content of the expression behind the start-delimiter
+ * @param size number of bytes until the end of the input
+ * @param pos reference for the position, where the search starts and where the scalar search
+ *            has to continue, if nothing was found
+ *
+ * @return offset behind the first delimiter, or size, if there is no delimiter in the vectors
+ */
+__attribute__((target("avx2"))) inline uint64_t
+findExpressionEndAvx2(const char* data,
+                      const uint64_t size,
+                      uint64_t &pos)
+{
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i percent = _mm256_set1_epi8('%');
+    while(pos + 33 <= size)
+    {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos + 1));
+        const __m256i match = _mm256_and_si256(_mm256_or_si256(_mm256_cmpeq_epi8(first, closeBrace),
+                                                               _mm256_cmpeq_epi8(first, percent)),
+                                               _mm256_cmpeq_epi8(second, closeBrace));
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+        if(mask != 0) {
+            return pos + static_cast<uint64_t>(__builtin_ctz(mask)) + 2;
+        }
+        pos += 32;
+    }
+
+    return size;
+}
+#endif
+
+/**
+ * @brief search the next delimiter "{{" or "{%", where an expression starts
+ *
+ * @param data pointer to the text
+ * @param size number of bytes of the text
+ *
+ * @return offset of the first delimiter, or size, if there is no delimiter
+ */
+inline uint64_t
+findExpressionStart(const char* data,
+                    const uint64_t size)
+{
+    uint64_t pos = 0;
+
+    // each vector compares the bytes at pos and at pos + 1, so a delimiter is only found, if
+    // both characters match and no second check per candidate is necessary
+#if defined(JINJA2_SCANNER_AVX2)
+    if(hasAvx2())
+    {
+        const uint64_t result = findExpressionStartAvx2(data, size, pos);
+        if(result != size) {
+            return result;
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i percent = _mm_set1_epi8('%');
+    while(pos + 17 <= size)
+    {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+        const __m128i match = _mm_and_si128(_mm_cmpeq_epi8(first, openBrace),
+                                            _mm_or_si128(_mm_cmpeq_epi8(second, openBrace),
+                                                         _mm_cmpeq_epi8(second, percent)));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+        if(mask != 0) {
+            return pos + static_cast<uint64_t>(__builtin_ctz(mask));
+        }
+        pos += 16;
+    }
+#endif
+
+    while(pos + 1 < size)
+    {
+        if(data[pos] == '{'
+                && (data[pos + 1] == '{' || data[pos + 1] == '%'))
+        {
+            return pos;
+        }
+        pos++;
+    }
+
+    return size;
+}
+
+/**
+ * @brief search the next delimiter "}}" or "%}", where an expression ends
+ *
+ * @param data pointer to the content of the expression behind the start-delimiter
+ * @param size number of bytes until the end of the input
+ *
+ * @return offset behind the first delimiter, or size, if there is no delimiter
+ */
+inline uint64_t
+findExpressionEnd(const char* data,
+                  const uint64_t size)
+{
+    uint64_t pos = 0;
+
+#if defined(JINJA2_SCANNER_AVX2)
+    if(hasAvx2())
+    {
+        const uint64_t result = findExpressionEndAvx2(data, size, pos);
+        if(result != size) {
+            return result;
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i percent = _mm_set1_epi8('%');
+    while(pos + 17 <= size)
+    {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1));
+        const __m128i match = _mm_and_si128(_mm_or_si128(_mm_cmpeq_epi8(first, closeBrace),
+                                                         _mm_cmpeq_epi8(first, percent)),
+                                            _mm_cmpeq_epi8(second, closeBrace));
+        const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+        if(mask != 0) {
+            return pos + static_cast<uint64_t>(__builtin_ctz(mask)) + 2;
+        }
+        pos += 16;
+    }
+#endif
+
+    while(pos + 1 < size)
+    {
+        if((data[pos] == '}' || data[pos] == '%')
+                && data[pos + 1] == '}')
+        {
+            return pos + 2;
+        }
+        pos++;
+    }
+
+    return size;
+}
+
+/**
+ * @brief convert a byte-offset into line and column. This is only done in case of an error,
+ *        so the newlines are not counted while scanning.
+ *
+ * @param data pointer to the text
+ * @param offset byte-offset within the text
+ * @param line reference for the line, starting with 1
+ * @param column reference for the column, starting with 1
+ */
+inline void
+getLineAndColumn(const char* data,
+                 const uint64_t offset,
+                 uint32_t &line,
+                 uint32_t &column)
+{
+    line = static_cast<uint32_t>(std::count(data, data + offset, '\n')) + 1;
+
+    uint64_t lineStart = offset;
+    while(lineStart > 0
+          && data[lineStart - 1] != '\n')
+    {
+        lineStart--;
+    }
+    column = static_cast<uint32_t>(offset - lineStart) + 1;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_TEXT_SCANNER_H
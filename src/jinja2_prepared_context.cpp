@@ -0,0 +1,78 @@
+/**
+ *  @file    jinja2_prepared_context.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_prepared_context.h>
+
+#include <jinja2_context_index.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief constructor, which resolves all paths of the input into the index
+ *
+ * @param input data-object, which is used for all renders with this context. The context
+ *              doesn't take the ownership of it.
+ */
+Jinja2PreparedContext::Jinja2PreparedContext(DataMap* input)
+{
+    m_input = input;
+    m_index = new Jinja2ContextIndex();
+
+    if(m_input != nullptr) {
+        createContextIndex(*m_index, m_input);
+    }
+}
+
+/**
+ * @brief destructor
+ */
+Jinja2PreparedContext::~Jinja2PreparedContext()
+{
+    delete m_index;
+}
+
+/**
+ * @brief get the input of the context
+ *
+ * @return pointer to the input
+ */
+DataMap*
+Jinja2PreparedContext::getInput() const
+{
+    return m_input;
+}
+
+/**
+ * @brief get number of paths within the index
+ *
+ * @return number of paths
+ */
+uint64_t
+Jinja2PreparedContext::getNumberOfPaths() const
+{
+    return m_index->numberOfPaths;
+}
+
+/**
+ * @brief search an item of the input by its path
+ *
+ * @param path path with dots as separator
+ *
+ * @return pointer to the item, if found, else nullptr
+ */
+DataItem*
+Jinja2PreparedContext::get(const std::string &path) const
+{
+    return m_index->find(calculateHash(path), path);
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
@@ -0,0 +1,96 @@
+/**
+ *  @file    jinja2_profiler.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_PROFILER_H
+#define JINJA2_PROFILER_H
+
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+//===================================================================
+// Jinja2InstructionCounters
+//===================================================================
+struct Jinja2InstructionCounters
+{
+    uint64_t executions = 0;
+    // number of resolved path-segments
+    uint64_t lookups = 0;
+    uint64_t loopIterations = 0;
+    uint64_t emittedBytes = 0;
+    // number of loops, which were rendered in parallel
+    uint64_t parallelLoops = 0;
+};
+
+/**
+ * @brief add the counters of one list to another list
+ *
+ * @param target list, where the counters are added
+ * @param source list with the counters to add
+ * @param begin position of the first counter to add
+ * @param end position behind the last counter to add
+ */
+inline void
+addCounters(Jinja2InstructionCounters* target,
+            const Jinja2InstructionCounters* source,
+            const uint64_t begin,
+            const uint64_t end)
+{
+    for(uint64_t i = begin; i < end; i++)
+    {
+        target[i].executions += source[i].executions;
+        target[i].lookups += source[i].lookups;
+        target[i].loopIterations += source[i].loopIterations;
+        target[i].emittedBytes += source[i].emittedBytes;
+        target[i].parallelLoops += source[i].parallelLoops;
+    }
+}
+
+//===================================================================
+// Jinja2Profiler
+//===================================================================
+// summed counters of all profiled renders of one template. Each render collects its counters
+// locally and adds them at the end, so the lock is used only once per render.
+struct Jinja2Profiler
+{
+    std::mutex lock;
+
+    uint64_t numberOfRenders = 0;
+    uint64_t renderTime = 0;
+    std::vector<Jinja2InstructionCounters> counters;
+
+    /**
+     * @brief add the counters of a finished render
+     *
+     * @param renderCounters counters of all instructions of the render
+     * @param duration duration of the render in nanoseconds
+     */
+    void addRender(const std::vector<Jinja2InstructionCounters> &renderCounters,
+                   const uint64_t duration)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if(counters.size() < renderCounters.size()) {
+            counters.resize(renderCounters.size());
+        }
+        addCounters(counters.data(), renderCounters.data(), 0, renderCounters.size());
+
+        numberOfRenders++;
+        renderTime += duration;
+    }
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_PROFILER_H
@@ -0,0 +1,191 @@
+/**
+ *  @file    jinja2_sink.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_sink.h>
+
+#include <unistd.h>
+#include <errno.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief constructor
+ *
+ * @param chunkSize number of bytes, which are collected before they are forwarded
+ */
+Jinja2Sink::Jinja2Sink(const uint64_t chunkSize)
+{
+    m_chunkSize = chunkSize;
+    if(m_chunkSize == 0) {
+        m_chunkSize = 1;
+    }
+
+    m_buffer.reserve(m_chunkSize);
+}
+
+/**
+ * @brief destructor
+ */
+Jinja2Sink::~Jinja2Sink() {}
+
+/**
+ * @brief forward all buffered bytes
+ *
+ * @return false, if writing the chunk failed, else true
+ */
+bool
+Jinja2Sink::flush()
+{
+    if(m_buffer.size() == 0) {
+        return true;
+    }
+
+    const bool success = writeChunk(m_buffer.c_str(), m_buffer.size());
+    m_numberOfWrittenBytes += m_buffer.size();
+    m_buffer.clear();
+
+    return success;
+}
+
+/**
+ * @brief get number of bytes, which were already forwarded
+ *
+ * @return number of written bytes
+ */
+uint64_t
+Jinja2Sink::getNumberOfWrittenBytes() const
+{
+    return m_numberOfWrittenBytes;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param stream stream, where the output should be written into
+ * @param chunkSize number of bytes, which are collected before they are written
+ */
+Jinja2StreamSink::Jinja2StreamSink(std::ostream &stream,
+                                   const uint64_t chunkSize)
+    : Jinja2Sink(chunkSize)
+{
+    m_stream = &stream;
+}
+
+/**
+ * @brief destructor
+ */
+Jinja2StreamSink::~Jinja2StreamSink() {}
+
+/**
+ * @brief write a chunk into the stream
+ *
+ * @param data pointer to the bytes
+ * @param size number of bytes
+ *
+ * @return false, if the stream is in a failed state, else true
+ */
+bool
+Jinja2StreamSink::writeChunk(const char* data,
+                             const uint64_t size)
+{
+    m_stream->write(data, static_cast<std::streamsize>(size));
+    return m_stream->good();
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param fileDescriptor file-descriptor of an open file or socket. It is not closed by the sink.
+ * @param chunkSize number of bytes, which are collected before they are written
+ */
+Jinja2FileDescriptorSink::Jinja2FileDescriptorSink(const int fileDescriptor,
+                                                   const uint64_t chunkSize)
+    : Jinja2Sink(chunkSize)
+{
+    m_fileDescriptor = fileDescriptor;
+}
+
+/**
+ * @brief destructor
+ */
+Jinja2FileDescriptorSink::~Jinja2FileDescriptorSink() {}
+
+/**
+ * @brief write a chunk into the file-descriptor
+ *
+ * @param data pointer to the bytes
+ * @param size number of bytes
+ *
+ * @return false, if writing failed, else true
+ */
+bool
+Jinja2FileDescriptorSink::writeChunk(const char* data,
+                                     const uint64_t size)
+{
+    uint64_t writtenBytes = 0;
+    while(writtenBytes < size)
+    {
+        const ssize_t ret = write(m_fileDescriptor, &data[writtenBytes], size - writtenBytes);
+        if(ret < 0)
+        {
+            if(errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        writtenBytes += static_cast<uint64_t>(ret);
+    }
+
+    return true;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ *
+ * @param callback function, which is called for each chunk and returns false to abort the render
+ * @param chunkSize number of bytes, which are collected before the callback is called
+ */
+Jinja2CallbackSink::Jinja2CallbackSink(std::function<bool(const char*, const uint64_t)> callback,
+                                       const uint64_t chunkSize)
+    : Jinja2Sink(chunkSize)
+{
+    m_callback = callback;
+}
+
+/**
+ * @brief destructor
+ */
+Jinja2CallbackSink::~Jinja2CallbackSink() {}
+
+/**
+ * @brief forward a chunk to the callback
+ *
+ * @param data pointer to the bytes
+ * @param size number of bytes
+ *
+ * @return result of the callback
+ */
+bool
+Jinja2CallbackSink::writeChunk(const char* data,
+                               const uint64_t size)
+{
+    return m_callback(data, size);
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
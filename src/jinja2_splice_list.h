@@ -0,0 +1,119 @@
+/**
+ *  @file    jinja2_splice_list.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_SPLICE_LIST_H
+#define JINJA2_SPLICE_LIST_H
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <jinja2_bytecode.h>
+#include <jinja2_output.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// value of a path of the splice-list, which is resolved only once for each render, even if
+// the path is used by multiple splices
+struct Jinja2SpliceValue
+{
+    bool resolved = false;
+
+    // strings are copied directly from the input. All other values are formatted once into
+    // a buffer and have an offset within the buffer.
+    const char* text = nullptr;
+    uint64_t formattedOffset = UINT64_MAX;
+    uint64_t length = 0;
+};
+
+/**
+ * @brief resolve the text and the exact size of the output of an item of the input
+ *
+ * @param value reference for the resolved value
+ * @param item item of the input
+ * @param formatted buffer for all values, which are not strings
+ */
+inline void
+resolveSpliceValue(Jinja2SpliceValue &value,
+                   DataItem* item,
+                   std::string &formatted)
+{
+    value.resolved = true;
+
+    if(item->getType() == DataItem::VALUE_TYPE
+            && item->toValue()->getValueType() == DataItem::STRING_TYPE)
+    {
+        value.text = item->toValue()->content.stringValue;
+        value.length = strlen(value.text);
+        return;
+    }
+
+    value.formattedOffset = formatted.size();
+    appendValue(formatted, item);
+    value.length = formatted.size() - value.formattedOffset;
+}
+
+/**
+ * @brief convert the instructions of a bytecode into a list of splices, if the template
+ *        contains only text and replacements. For all other templates the list stays empty.
+ *
+ * @param bytecode bytecode, which gets the splice-list
+ */
+inline void
+createSpliceList(Jinja2Bytecode &bytecode)
+{
+    bytecode.splices.clear();
+
+    std::vector<Jinja2Splice> splices;
+    splices.reserve(bytecode.numberOfInstructions / 2 + 1);
+
+    Jinja2Splice current;
+    for(uint32_t pos = 0; pos < bytecode.numberOfInstructions; pos++)
+    {
+        const Jinja2Instruction &instruction = bytecode.instructions[pos];
+        switch(instruction.opCode)
+        {
+            case EMIT_TEXT:
+            {
+                // two texts behind each other are stored as splices without path
+                if(current.textLength != 0)
+                {
+                    splices.push_back(current);
+                    current = Jinja2Splice();
+                }
+                current.textOffset = instruction.arg0;
+                current.textLength = instruction.arg1;
+                break;
+            }
+            case EMIT_VAR:
+            {
+                current.pathId = instruction.arg0;
+                splices.push_back(current);
+                current = Jinja2Splice();
+                break;
+            }
+            default:
+                return;
+        }
+    }
+
+    if(current.textLength != 0) {
+        splices.push_back(current);
+    }
+
+    bytecode.splices.swap(splices);
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_SPLICE_LIST_H
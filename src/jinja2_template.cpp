@@ -0,0 +1,2260 @@
+/**
+ *  @file    jinja2_template.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_sink.h>
+#include <libKitsunemimiJinja2/jinja2_prepared_context.h>
+
+#include <jinja2_bytecode.h>
+#include <jinja2_output.h>
+#include <jinja2_parallel.h>
+#include <jinja2_condition.h>
+#include <jinja2_profiler.h>
+#include <jinja2_dependencies.h>
+#include <jinja2_splice_list.h>
+#include <jinja2_context_index.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using Kitsunemimi::DataItem;
+using Kitsunemimi::DataArray;
+using Kitsunemimi::DataValue;
+using Kitsunemimi::DataMap;
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// source of the ids of all templates, starting with 1, so 0 is never a valid id
+static std::atomic<uint64_t> g_nextTemplateId(1);
+
+/**
+ * @brief constructor, which is only called by the converter after a successful compiling
+ *
+ * @param bytecode compiled bytecode of the template. The template takes the ownership of it.
+ */
+Jinja2Template::Jinja2Template(Jinja2Bytecode* bytecode)
+    : m_averageDynamicSize(0)
+{
+    m_bytecode = bytecode;
+    m_id = g_nextTemplateId.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief destructor to delete the bytecode
+ */
+Jinja2Template::~Jinja2Template()
+{
+    delete m_profiler;
+    delete m_bytecode;
+}
+
+/**
+ * @brief fill the compiled template with the content of the input
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param result reference for the output-string
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::render(DataMap* input,
+                       std::string &result,
+                       std::string &errorMessage) const
+{
+    return renderResult(input, nullptr, true, result, errorMessage);
+}
+
+/**
+ * @brief fill the compiled template with the content of a prepared context
+ *
+ * @param context prepared context with the input of the render
+ * @param result reference for the output-string
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::render(const Jinja2PreparedContext &context,
+                       std::string &result,
+                       std::string &errorMessage) const
+{
+    return renderResult(context.m_input, context.m_index, true, result, errorMessage);
+}
+
+/**
+ * @brief fill the compiled template with the content of the input and forward the output
+ *        in chunks to a sink, while rendering
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param sink target for the output. All remaining bytes are flushed at the end.
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::render(DataMap* input,
+                       Jinja2Sink &sink,
+                       std::string &errorMessage) const
+{
+    return renderSink(input, nullptr, sink, errorMessage);
+}
+
+/**
+ * @brief fill the compiled template with the content of a prepared context and forward the
+ *        output in chunks to a sink, while rendering
+ *
+ * @param context prepared context with the input of the render
+ * @param sink target for the output. All remaining bytes are flushed at the end.
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::render(const Jinja2PreparedContext &context,
+                       Jinja2Sink &sink,
+                       std::string &errorMessage) const
+{
+    return renderSink(context.m_input, context.m_index, sink, errorMessage);
+}
+
+/**
+ * @brief fill the compiled template and append the output to a string
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param allowParallel true to allow rendering big loops in parallel
+ * @param result reference for the output-string
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::renderResult(DataMap* input,
+                             const Jinja2ContextIndex* contextIndex,
+                             const bool allowParallel,
+                             std::string &result,
+                             std::string &errorMessage) const
+{
+    // allocate the output only once, if the estimation of the earlier renders is correct
+    const uint64_t startSize = result.size();
+    result.reserve(startSize + estimateOutputSize());
+
+    Jinja2RenderBudget budget;
+    if(createBudget(startSize, budget, errorMessage) == false) {
+        return false;
+    }
+
+    if(execute(input,
+               contextIndex,
+               result,
+               nullptr,
+               budget,
+               0,
+               m_bytecode->numberOfInstructions,
+               allowParallel,
+               errorMessage) == false)
+    {
+        return false;
+    }
+
+    updateSizeEstimation(result.size() - startSize);
+
+    return true;
+}
+
+/**
+ * @brief fill the compiled template and forward the output in chunks to a sink
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param sink target for the output. All remaining bytes are flushed at the end.
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::renderSink(DataMap* input,
+                           const Jinja2ContextIndex* contextIndex,
+                           Jinja2Sink &sink,
+                           std::string &errorMessage) const
+{
+    const uint64_t startSize = sink.m_numberOfWrittenBytes + sink.m_buffer.size();
+
+    Jinja2RenderBudget budget;
+    if(createBudget(sink.m_buffer.size(), budget, errorMessage) == false) {
+        return false;
+    }
+
+    if(execute(input,
+               contextIndex,
+               sink.m_buffer,
+               &sink,
+               budget,
+               0,
+               m_bytecode->numberOfInstructions,
+               true,
+               errorMessage) == false)
+    {
+        return false;
+    }
+
+    if(flushSink(sink, errorMessage) == false) {
+        return false;
+    }
+
+    updateSizeEstimation(sink.m_numberOfWrittenBytes - startSize);
+
+    return true;
+}
+
+/**
+ * @brief fill the compiled template with multiple inputs in parallel
+ *
+ * @param inputs list of data-objects, which should be filled in the jinja2-template
+ * @param results reference for the output-strings. It is resized to the number of inputs and
+ *                the output for each input is written at the same position.
+ * @param errorMessages reference for the error-messages. It is resized to the number of inputs
+ *                      and the error-message for each failed input is written at the same
+ *                      position. Successful inputs have an empty error-message.
+ * @param numberOfThreads maximum number of threads including the calling thread.
+ *                        0 means one thread per cpu-core.
+ *
+ * @return true, if all inputs were successful, else false
+ */
+bool
+Jinja2Template::renderBatch(const std::vector<DataMap*> &inputs,
+                            std::vector<std::string> &results,
+                            std::vector<std::string> &errorMessages,
+                            const uint32_t numberOfThreads) const
+{
+    // each thread writes only into its own slots, so no synchronization is necessary
+    results.resize(inputs.size());
+    errorMessages.resize(inputs.size());
+
+    std::atomic<bool> success(true);
+
+    parallelFor(inputs.size(), numberOfThreads, [&](const uint64_t index)
+    {
+        results[index].clear();
+        errorMessages[index].clear();
+
+        // the inputs are already rendered in parallel, so their loops are not split again
+        if(renderResult(inputs[index],
+                        nullptr,
+                        false,
+                        results[index],
+                        errorMessages[index]) == false)
+        {
+            success.store(false, std::memory_order_relaxed);
+        }
+    });
+
+    return success.load();
+}
+
+/**
+ * @brief run the instructions of the bytecode one after another
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param output reference for the output-string
+ * @param sink if not nullptr, the output is flushed into the sink, when the chunk-size is reached
+ * @param budget limits of the render, which are shared by all parts of the same render
+ * @param startPos position of the first instruction
+ * @param endPos position behind the last instruction. Jumps must not leave the range.
+ * @param allowParallel true to allow rendering big loops in parallel
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::execute(DataMap* input,
+                        const Jinja2ContextIndex* contextIndex,
+                        std::string &output,
+                        Jinja2Sink* sink,
+                        Jinja2RenderBudget &budget,
+                        const uint32_t startPos,
+                        const uint32_t endPos,
+                        const bool allowParallel,
+                        std::string &errorMessage) const
+{
+    // templates with only text and replacements don't need the interpreter
+    if(m_profiler == nullptr
+            && startPos == 0
+            && endPos == m_bytecode->numberOfInstructions
+            && m_bytecode->splices.size() > 0)
+    {
+        return executeSpliceList(input, contextIndex, output, sink, budget, errorMessage);
+    }
+
+    std::vector<Jinja2LoopFrame> loops;
+    loops.reserve(m_bytecode->maxNestingDepth);
+
+    // without profiling the variant of the interpreter without any counters is used
+    if(m_profiler == nullptr)
+    {
+        return executeRange<false>(input,
+                                   contextIndex,
+                                   output,
+                                   sink,
+                                   budget,
+                                   loops,
+                                   startPos,
+                                   endPos,
+                                   allowParallel,
+                                   nullptr,
+                                   nullptr,
+                                   errorMessage);
+    }
+
+    std::vector<Jinja2InstructionCounters> counters(m_bytecode->numberOfInstructions);
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool success = executeRange<true>(input,
+                                            contextIndex,
+                                            output,
+                                            sink,
+                                            budget,
+                                            loops,
+                                            startPos,
+                                            endPos,
+                                            allowParallel,
+                                            nullptr,
+                                            counters.data(),
+                                            errorMessage);
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    m_profiler->addRender(counters, static_cast<uint64_t>(duration.count()));
+
+    return success;
+}
+
+/**
+ * @brief render a template, which contains only text and replacements, with its splice-list.
+ *        Each path is resolved and formatted only once, so the output can be reserved with
+ *        its exact size and all splices are only copies of memory in a flat loop.
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param output reference for the output-string
+ * @param sink if not nullptr, the output is flushed into the sink, when the chunk-size is reached
+ * @param budget limits of the render
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::executeSpliceList(DataMap* input,
+                                  const Jinja2ContextIndex* contextIndex,
+                                  std::string &output,
+                                  Jinja2Sink* sink,
+                                  const Jinja2RenderBudget &budget,
+                                  std::string &errorMessage) const
+{
+    const Jinja2Bytecode &bytecode = *m_bytecode;
+    const Jinja2Splice* splices = bytecode.splices.data();
+    const uint64_t numberOfSplices = bytecode.splices.size();
+    const char* stringPool = bytecode.stringPool;
+
+    // values of the paths of the most templates fit on the stack
+    Jinja2SpliceValue localValues[32];
+    std::vector<Jinja2SpliceValue> heapValues;
+    Jinja2SpliceValue* values = localValues;
+    if(bytecode.numberOfPaths > 32)
+    {
+        heapValues.resize(bytecode.numberOfPaths);
+        values = heapValues.data();
+    }
+
+    // the input is not modified while rendering, so each path has always the same value
+    std::string formatted = "";
+    uint64_t outputSize = 0;
+    for(uint64_t i = 0; i < numberOfSplices; i++)
+    {
+        const uint32_t pathId = splices[i].pathId;
+        outputSize += splices[i].textLength;
+        if(pathId == NO_SPLICE_PATH) {
+            continue;
+        }
+
+        Jinja2SpliceValue &value = values[pathId];
+        if(value.resolved == false)
+        {
+            DataItem* item = getItem(input, contextIndex, nullptr, 0, pathId);
+            if(item == nullptr)
+            {
+                errorMessage = createErrorMessage(pathId);
+                return false;
+            }
+            resolveSpliceValue(value, item, formatted);
+        }
+
+        outputSize += value.length;
+    }
+
+    // formatted values get their pointer, when the buffer is complete
+    for(uint32_t i = 0; i < bytecode.numberOfPaths; i++)
+    {
+        if(values[i].formattedOffset != UINT64_MAX) {
+            values[i].text = &formatted[values[i].formattedOffset];
+        }
+    }
+
+    // the size of the output is already known, so a too big output is rejected before
+    if(output.size() + outputSize >= budget.outputLimit)
+    {
+        errorMessage = createOutputLimitError(budget);
+        return false;
+    }
+
+    uint64_t flushLimit = UINT64_MAX;
+    if(sink != nullptr) {
+        flushLimit = sink->m_chunkSize;
+    } else {
+        output.reserve(output.size() + outputSize);
+    }
+
+    for(uint64_t i = 0; i < numberOfSplices; i++)
+    {
+        const Jinja2Splice &splice = splices[i];
+        output.append(&stringPool[splice.textOffset], splice.textLength);
+        if(splice.pathId != NO_SPLICE_PATH)
+        {
+            const Jinja2SpliceValue &value = values[splice.pathId];
+            output.append(value.text, value.length);
+        }
+
+        if(output.size() >= flushLimit
+                && flushSink(*sink, errorMessage) == false)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief run a range of instructions of the bytecode one after another
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param output reference for the output-string
+ * @param sink if not nullptr, the output is flushed into the sink, when the chunk-size is reached
+ * @param budget remaining limits of the render
+ * @param loops frames of the active loops
+ * @param startPos position of the first instruction
+ * @param endPos position behind the last instruction. Jumps never leave the range.
+ * @param allowParallel true to allow rendering big loops in parallel. Must be false, if the
+ *                      range can be paused.
+ * @param pause if not nullptr, the range is paused behind the instruction, which has reached
+ *              the pause-size, or at the next include, and the pause-point gets the position,
+ *              where the render can be continued
+ * @param counters counters of all instructions of the bytecode, if PROFILE is true
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+template<bool PROFILE>
+bool
+Jinja2Template::executeRange(DataMap* input,
+                             const Jinja2ContextIndex* contextIndex,
+                             std::string &output,
+                             Jinja2Sink* sink,
+                             Jinja2RenderBudget &budget,
+                             std::vector<Jinja2LoopFrame> &loops,
+                             const uint32_t startPos,
+                             const uint32_t endPos,
+                             const bool allowParallel,
+                             Jinja2PausePoint* pause,
+                             Jinja2InstructionCounters* counters,
+                             std::string &errorMessage) const
+{
+    const Jinja2Bytecode &bytecode = *m_bytecode;
+    const Jinja2Instruction* instructions = bytecode.instructions;
+    const char* stringPool = bytecode.stringPool;
+
+    // flushing the sink, the output-limit and the pause are handled, when this size is
+    // reached, so only one comparison is necessary for each emitted text or value
+    uint64_t checkSize = getCheckSize(sink, budget);
+    if(pause != nullptr)
+    {
+        pause->includeId = UINT32_MAX;
+        checkSize = std::min(checkSize, pause->pauseSize);
+    }
+
+    uint32_t pos = startPos;
+    while(pos < endPos)
+    {
+        const Jinja2Instruction &instruction = instructions[pos];
+        if(PROFILE) {
+            counters[pos].executions++;
+        }
+
+        switch(instruction.opCode)
+        {
+            //------------------------------------------------------
+            case EMIT_TEXT:
+            {
+                output.append(&stringPool[instruction.arg0], instruction.arg1);
+                if(PROFILE) {
+                    counters[pos].emittedBytes += instruction.arg1;
+                }
+
+                if(output.size() >= checkSize)
+                {
+                    if(checkOutput(output, sink, budget, checkSize, errorMessage) == false) {
+                        return false;
+                    }
+                    if(reachedPause(pause, output, pos + 1, checkSize)) {
+                        return true;
+                    }
+                }
+
+                pos++;
+                break;
+            }
+            //------------------------------------------------------
+            case EMIT_VAR:
+            {
+                DataItem* item = getItem(input,
+                                         contextIndex,
+                                         loops.data(),
+                                         loops.size(),
+                                         instruction.arg0);
+                if(item == nullptr)
+                {
+                    errorMessage = createErrorMessage(instruction.arg0);
+                    return false;
+                }
+
+                const uint64_t sizeBefore = output.size();
+                appendValue(output, item);
+                if(PROFILE)
+                {
+                    counters[pos].lookups += bytecode.paths[instruction.arg0].numberOfSegments;
+                    counters[pos].emittedBytes += output.size() - sizeBefore;
+                }
+
+                if(output.size() >= checkSize)
+                {
+                    if(checkOutput(output, sink, budget, checkSize, errorMessage) == false) {
+                        return false;
+                    }
+                    if(reachedPause(pause, output, pos + 1, checkSize)) {
+                        return true;
+                    }
+                }
+
+                pos++;
+                break;
+            }
+            //------------------------------------------------------
+            case JUMP_IF_FALSE:
+            {
+                const Jinja2Condition &condition = bytecode.conditions[instruction.arg0];
+                DataItem* item = getItem(input,
+                                         contextIndex,
+                                         loops.data(),
+                                         loops.size(),
+                                         condition.pathId);
+                if(item == nullptr)
+                {
+                    errorMessage = createErrorMessage(condition.pathId);
+                    return false;
+                }
+
+                if(PROFILE) {
+                    counters[pos].lookups += bytecode.paths[condition.pathId].numberOfSegments;
+                }
+
+                if(evaluateCondition(condition, &stringPool[condition.textOffset], item))
+                {
+                    pos++;
+                }
+                else
+                {
+                    pos = instruction.arg1;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            case JUMP:
+            {
+                pos = instruction.arg1;
+                break;
+            }
+            //------------------------------------------------------
+            case LOOP_BEGIN:
+            {
+                // loop can only work on json-arrays
+                DataItem* item = getItem(input,
+                                         contextIndex,
+                                         loops.data(),
+                                         loops.size(),
+                                         instruction.arg0);
+                if(item == nullptr
+                        || item->getType() != DataItem::ARRAY_TYPE)
+                {
+                    errorMessage = createErrorMessage(instruction.arg0);
+                    return false;
+                }
+
+                DataArray* array = item->toArray();
+                if(PROFILE)
+                {
+                    counters[pos].lookups += bytecode.paths[instruction.arg0].numberOfSegments;
+                    counters[pos].loopIterations += array->size();
+                }
+
+                // all iterations are charged at once, before any output is rendered
+                if(chargeIterations(budget,
+                                    array->size(),
+                                    instruction.arg0,
+                                    errorMessage) == false)
+                {
+                    return false;
+                }
+
+                if(array->size() == 0)
+                {
+                    pos = instruction.arg1;
+                    break;
+                }
+
+                Jinja2LoopFrame frame;
+                frame.array = array;
+                frame.value = array->get(0);
+                frame.index = 0;
+                frame.keyId = instruction.arg2;
+
+                // big loops can be split between multiple threads. This is not done within
+                // an already parallel loop, because all threads are already in use.
+                if(allowParallel
+                        && m_parallelLoopThreshold != 0
+                        && array->size() >= m_parallelLoopThreshold)
+                {
+                    // the LOOP_NEXT-instruction is the last one before the jump-target
+                    if(executeParallelLoop<PROFILE>(input,
+                                                    contextIndex,
+                                                    output,
+                                                    sink,
+                                                    budget,
+                                                    loops,
+                                                    frame,
+                                                    pos + 1,
+                                                    instruction.arg1 - 1,
+                                                    counters,
+                                                    errorMessage) == false)
+                    {
+                        return false;
+                    }
+
+                    if(PROFILE) {
+                        counters[pos].parallelLoops++;
+                    }
+
+                    checkSize = getCheckSize(sink, budget);
+                    pos = instruction.arg1;
+                    break;
+                }
+
+                loops.push_back(frame);
+                pos++;
+                break;
+            }
+            //------------------------------------------------------
+            case LOOP_NEXT:
+            {
+                Jinja2LoopFrame &frame = loops.back();
+                frame.index++;
+
+                if(frame.index < frame.array->size())
+                {
+                    frame.value = frame.array->get(frame.index);
+                    pos = instruction.arg1;
+                }
+                else
+                {
+                    loops.pop_back();
+                    pos++;
+                }
+                break;
+            }
+            //------------------------------------------------------
+            case INCLUDE:
+            {
+                // paused ranges continue with the included template in its own frame
+                if(pause != nullptr)
+                {
+                    pause->includeId = instruction.arg0;
+                    pause->pos = pos + 1;
+                    return true;
+                }
+
+                if(executeInclude<PROFILE>(input,
+                                           contextIndex,
+                                           output,
+                                           sink,
+                                           budget,
+                                           loops,
+                                           instruction.arg0,
+                                           allowParallel,
+                                           errorMessage) == false)
+                {
+                    return false;
+                }
+
+                // the included template can have flushed the sink
+                checkSize = getCheckSize(sink, budget);
+                pos++;
+                break;
+            }
+            //------------------------------------------------------
+        }
+    }
+
+    if(pause != nullptr) {
+        pause->pos = pos;
+    }
+
+    return true;
+}
+
+/**
+ * @brief render the body of a loop in parallel. The elements of the array are split into
+ *        chunks, which are rendered by multiple threads into separate buffers. Each buffer is
+ *        appended to the output in the order of the elements, as soon as all chunks before are
+ *        appended, so a sink already gets the first chunks, while the others are rendered.
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param output reference for the output-string
+ * @param sink if not nullptr, the output is flushed into the sink, when the chunk-size is reached
+ * @param budget remaining limits of the render. The chunks share one budget with the
+ *               remaining output and iterations, which stops all chunks, if one has failed.
+ * @param loops frames of the active outer loops
+ * @param frame frame of the loop, which should be rendered
+ * @param bodyBegin position of the first instruction of the loop-body
+ * @param bodyEnd position of the LOOP_NEXT-instruction of the loop
+ * @param counters counters of all instructions of the bytecode, if PROFILE is true
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+template<bool PROFILE>
+bool
+Jinja2Template::executeParallelLoop(DataMap* input,
+                                    const Jinja2ContextIndex* contextIndex,
+                                    std::string &output,
+                                    Jinja2Sink* sink,
+                                    Jinja2RenderBudget &budget,
+                                    const std::vector<Jinja2LoopFrame> &loops,
+                                    const Jinja2LoopFrame &frame,
+                                    const uint32_t bodyBegin,
+                                    const uint32_t bodyEnd,
+                                    Jinja2InstructionCounters* counters,
+                                    std::string &errorMessage) const
+{
+    const uint64_t numberOfElements = frame.array->size();
+    const uint32_t numberOfThreads = getNumberOfThreads(m_parallelLoopThreads, numberOfElements);
+
+    // more chunks than threads to balance elements with different sizes. With a sink only a
+    // window of small chunks is rendered ahead, so not the whole loop is buffered in memory.
+    uint64_t numberOfChunks = static_cast<uint64_t>(numberOfThreads) * 4;
+    uint64_t window = numberOfChunks;
+    if(sink != nullptr)
+    {
+        numberOfChunks = static_cast<uint64_t>(numberOfThreads) * 16;
+        window = static_cast<uint64_t>(numberOfThreads) * 2;
+    }
+    if(numberOfChunks > numberOfElements) {
+        numberOfChunks = numberOfElements;
+    }
+
+    std::vector<std::string> outputs(numberOfChunks);
+    std::vector<std::string> errorMessages(numberOfChunks);
+    std::vector<uint8_t> results(numberOfChunks, 0);
+
+    // the output of all chunks together is limited to the remaining output of the render
+    Jinja2SharedBudget shared;
+    if(budget.outputLimit != UINT64_MAX) {
+        shared.outputLimit = budget.outputLimit - std::min(budget.outputLimit, output.size());
+    }
+    shared.remainingIterations = budget.remainingIterations;
+
+    // each chunk has its own counters, which are added after all chunks are finished
+    std::vector<std::vector<Jinja2InstructionCounters>> chunkCounters;
+    if(PROFILE) {
+        chunkCounters.resize(numberOfChunks);
+    }
+
+    // finished chunks are appended to the output on the calling thread, so the sink is only
+    // used by this thread
+    uint64_t checkSize = getCheckSize(sink, budget);
+    bool consumeFailed = false;
+    auto renderChunk = [&](const uint64_t chunk)
+    {
+        const uint64_t begin = (numberOfElements * chunk) / numberOfChunks;
+        const uint64_t end = (numberOfElements * (chunk + 1)) / numberOfChunks;
+
+        Jinja2RenderBudget chunkBudget = budget;
+        chunkBudget.shared = &shared;
+        chunkBudget.outputLimit = std::min(Jinja2SharedBudget::CHECK_STEP, shared.outputLimit);
+        chunkBudget.remainingIterations = UINT64_MAX;
+
+        // each chunk has its own copy of the loop-frames
+        std::vector<Jinja2LoopFrame> chunkLoops;
+        chunkLoops.reserve(m_bytecode->maxNestingDepth + 1);
+        chunkLoops = loops;
+        chunkLoops.push_back(frame);
+
+        Jinja2InstructionCounters* localCounters = nullptr;
+        if(PROFILE)
+        {
+            chunkCounters[chunk].resize(m_bytecode->numberOfInstructions);
+            localCounters = chunkCounters[chunk].data();
+        }
+
+        // chunks, which are stopped by the failure of another chunk, have no error-message
+        for(uint64_t i = begin; i < end; i++)
+        {
+            if(shared.cancelled.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            chunkLoops.back().index = i;
+            chunkLoops.back().value = frame.array->get(i);
+
+            if(executeRange<PROFILE>(input,
+                                     contextIndex,
+                                     outputs[chunk],
+                                     nullptr,
+                                     chunkBudget,
+                                     chunkLoops,
+                                     bodyBegin,
+                                     bodyEnd,
+                                     false,
+                                     nullptr,
+                                     localCounters,
+                                     errorMessages[chunk]) == false)
+            {
+                shared.cancelled.store(true, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        // the rest of the output behind the last update of the shared budget
+        uint64_t checkSize = 0;
+        if(checkOutput(outputs[chunk],
+                       nullptr,
+                       chunkBudget,
+                       checkSize,
+                       errorMessages[chunk]) == false)
+        {
+            return;
+        }
+
+        results[chunk] = 1;
+    };
+
+    auto appendChunk = [&](const uint64_t chunk)
+    {
+        if(results[chunk] == 0) {
+            return false;
+        }
+
+        output.append(outputs[chunk]);
+        std::string().swap(outputs[chunk]);
+
+        if(output.size() >= checkSize
+                && checkOutput(output, sink, budget, checkSize, errorMessage) == false)
+        {
+            consumeFailed = true;
+            shared.cancelled.store(true, std::memory_order_relaxed);
+            return false;
+        }
+
+        return true;
+    };
+
+    const bool result = parallelForOrdered(numberOfChunks,
+                                           numberOfThreads,
+                                           window,
+                                           renderChunk,
+                                           appendChunk);
+
+    if(PROFILE)
+    {
+        for(uint64_t i = 0; i < numberOfChunks; i++)
+        {
+            if(chunkCounters[i].size() != 0) {
+                addCounters(counters, chunkCounters[i].data(), bodyBegin, bodyEnd);
+            }
+        }
+
+        // the LOOP_NEXT-instruction is not executed by the chunks
+        counters[bodyEnd].executions += numberOfElements;
+    }
+
+    if(consumeFailed) {
+        return false;
+    }
+
+    // the first chunk with an error-message has stopped the other chunks
+    if(result == false)
+    {
+        for(uint64_t i = 0; i < numberOfChunks; i++)
+        {
+            if(results[i] == 0
+                    && errorMessages[i].empty() == false)
+            {
+                errorMessage = errorMessages[i];
+                return false;
+            }
+        }
+        return false;
+    }
+
+    if(budget.remainingIterations != UINT64_MAX) {
+        budget.remainingIterations -= shared.iterations.load();
+    }
+
+    return true;
+}
+
+/**
+ * @brief render a shared included template into the output. The active loop-variables are
+ *        forwarded into the included template, if it uses the same names.
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param output reference for the output-string
+ * @param sink if not nullptr, the output is flushed into the sink, when the chunk-size is reached
+ * @param budget remaining limits of the render, which are shared with the included template
+ * @param loops frames of the active loops
+ * @param includeId id of the include within the bytecode
+ * @param allowParallel true to allow rendering big loops in parallel
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+template<bool PROFILE>
+bool
+Jinja2Template::executeInclude(DataMap* input,
+                               const Jinja2ContextIndex* contextIndex,
+                               std::string &output,
+                               Jinja2Sink* sink,
+                               Jinja2RenderBudget &budget,
+                               const std::vector<Jinja2LoopFrame> &loops,
+                               const uint32_t includeId,
+                               const bool allowParallel,
+                               std::string &errorMessage) const
+{
+    const Jinja2Template &includedTemplate = *m_bytecode->includes[includeId].includedTemplate;
+
+    std::vector<Jinja2LoopFrame> includeLoops;
+    createIncludeLoops(includeId, loops, includeLoops);
+
+    // the counters of the profiling belong to the instructions of this template, so the
+    // included template is always rendered without counters
+    return includedTemplate.executeRange<false>(input,
+                                                contextIndex,
+                                                output,
+                                                sink,
+                                                budget,
+                                                includeLoops,
+                                                0,
+                                                includedTemplate.m_bytecode->numberOfInstructions,
+                                                allowParallel,
+                                                nullptr,
+                                                nullptr,
+                                                errorMessage);
+}
+
+/**
+ * @brief create the loop-frames for an included template, where the key-ids of the
+ *        loop-variables are replaced by the key-ids of the included template
+ *
+ * @param includeId id of the include within the bytecode
+ * @param loops frames of the active loops of this template
+ * @param includeLoops reference for the frames of the included template
+ */
+void
+Jinja2Template::createIncludeLoops(const uint32_t includeId,
+                                   const std::vector<Jinja2LoopFrame> &loops,
+                                   std::vector<Jinja2LoopFrame> &includeLoops) const
+{
+    const Jinja2Include &include = m_bytecode->includes[includeId];
+    const Jinja2Template &includedTemplate = *include.includedTemplate;
+
+    includeLoops.clear();
+    includeLoops.reserve(loops.size() + includedTemplate.m_bytecode->maxNestingDepth);
+    for(const Jinja2LoopFrame &frame : loops)
+    {
+        if(frame.keyId < include.keyMapping.size()
+                && include.keyMapping[frame.keyId] != UINT32_MAX)
+        {
+            includeLoops.push_back(frame);
+            includeLoops.back().keyId = include.keyMapping[frame.keyId];
+        }
+    }
+}
+
+/**
+ * @brief start a resumable render, which is driven step by step with continueRender. The
+ *        input and the template must stay valid and unchanged until the render is finished.
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param continuation continuation, which is reset and stores the position of the render
+ */
+void
+Jinja2Template::beginRender(DataMap* input,
+                            Jinja2RenderContinuation &continuation) const
+{
+    continuation.clear();
+    continuation.m_template = this;
+    continuation.m_input = input;
+
+    if(continuation.m_state == nullptr) {
+        continuation.m_state = new Jinja2ResumeState();
+    }
+
+    Jinja2ResumeFrame frame;
+    frame.compiledTemplate = this;
+    frame.loops.reserve(m_bytecode->maxNestingDepth);
+    continuation.m_state->frames.push_back(std::move(frame));
+
+    // a too deep nested template is rejected by the first continueRender
+    std::string errorMessage = "";
+    createBudget(0, continuation.m_state->budget, errorMessage);
+}
+
+/**
+ * @brief start a resumable render with a prepared context, which is driven step by step with
+ *        continueRender. The context and the template must stay valid and unchanged until the
+ *        render is finished.
+ *
+ * @param context prepared context with the input and the index of its paths
+ * @param continuation continuation, which is reset and stores the position of the render
+ */
+void
+Jinja2Template::beginRender(const Jinja2PreparedContext &context,
+                            Jinja2RenderContinuation &continuation) const
+{
+    beginRender(context.m_input, continuation);
+    continuation.m_state->contextIndex = context.m_index;
+}
+
+/**
+ * @brief continue a resumable render, until the output, which was not consumed, has reached
+ *        the given size or the render is finished. The render never blocks, so it can be
+ *        driven by an event-loop, which calls it again, when the output was consumed.
+ *        Loops of resumable renders are not rendered in parallel.
+ *
+ * @param continuation continuation, which was started with beginRender of this template
+ * @param maxPendingSize number of bytes of not consumed output, where the render pauses.
+ *                       A single text or value can exceed the size. If no output is
+ *                       pending, at least the next text or value is rendered.
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the continuation was not started by this template or the render failed,
+ *         else true. After a failed render the continuation is finished.
+ */
+bool
+Jinja2Template::continueRender(Jinja2RenderContinuation &continuation,
+                               const uint64_t maxPendingSize,
+                               std::string &errorMessage) const
+{
+    if(continuation.m_template != this)
+    {
+        errorMessage =  "error while converting jinja2-template \n";
+        errorMessage += "    render-continuation was not started by this template \n";
+        return false;
+    }
+
+    Jinja2ResumeState &state = *continuation.m_state;
+    std::vector<Jinja2ResumeFrame> &frames = state.frames;
+    Jinja2RenderBudget &budget = state.budget;
+    if(frames.empty() == false
+            && checkNestingDepth(errorMessage) == false)
+    {
+        frames.clear();
+        return false;
+    }
+
+    // the consumed output is removed only here, so consuming is cheap
+    std::string &output = continuation.m_output;
+    if(continuation.m_outputOffset > 0)
+    {
+        output.erase(0, continuation.m_outputOffset);
+        if(budget.outputLimit != UINT64_MAX) {
+            budget.outputLimit -= continuation.m_outputOffset;
+        }
+        continuation.m_outputOffset = 0;
+    }
+
+    // without pending output the render always continues, so it also makes progress with a
+    // pending-size of 0
+    while(frames.empty() == false
+          && (output.size() < maxPendingSize || output.empty()))
+    {
+        Jinja2ResumeFrame &frame = frames.back();
+        const Jinja2Template &frameTemplate = *frame.compiledTemplate;
+
+        // only the started template is profiled, like in normal renders
+        Jinja2InstructionCounters* counters = nullptr;
+        if(frames.size() == 1
+                && m_profiler != nullptr)
+        {
+            state.counters.resize(m_bytecode->numberOfInstructions);
+            counters = state.counters.data();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        uint32_t includeId = UINT32_MAX;
+        const bool success = frameTemplate.resumeFrame(continuation.m_input,
+                                                       state.contextIndex,
+                                                       frame,
+                                                       budget,
+                                                       output,
+                                                       maxPendingSize,
+                                                       counters,
+                                                       includeId,
+                                                       errorMessage);
+        if(counters != nullptr)
+        {
+            const auto end = std::chrono::steady_clock::now();
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+            state.renderTime += static_cast<uint64_t>(duration.count());
+        }
+
+        if(success == false)
+        {
+            frames.clear();
+            return false;
+        }
+
+        // included templates are rendered with their own frame, so they can also be paused
+        if(includeId != UINT32_MAX)
+        {
+            Jinja2ResumeFrame includeFrame;
+            includeFrame.compiledTemplate =
+                    frameTemplate.m_bytecode->includes[includeId].includedTemplate.get();
+            frameTemplate.createIncludeLoops(includeId, frame.loops, includeFrame.loops);
+            frames.push_back(std::move(includeFrame));
+            continue;
+        }
+
+        if(frame.pos >= frameTemplate.m_bytecode->numberOfInstructions) {
+            frames.pop_back();
+        }
+    }
+
+    // the whole render is added to the profile as one render
+    if(frames.empty()
+            && m_profiler != nullptr
+            && state.counters.size() > 0)
+    {
+        m_profiler->addRender(state.counters, state.renderTime);
+        state.counters.clear();
+        state.renderTime = 0;
+    }
+
+    return true;
+}
+
+/**
+ * @brief run the instructions of a frame of a resumable render, until the output has reached
+ *        the pause-size, the end of the template or an include is reached
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param frame frame with the position and the active loops within this template
+ * @param budget remaining limits of the render
+ * @param output reference for the output-string
+ * @param pauseSize size of the output, where the render pauses
+ * @param counters counters of all instructions of the bytecode, or nullptr without profiling
+ * @param includeId reference for the id of a reached include, else UINT32_MAX. The position
+ *                  of the frame is already behind the include.
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2Template::resumeFrame(DataMap* input,
+                            const Jinja2ContextIndex* contextIndex,
+                            Jinja2ResumeFrame &frame,
+                            Jinja2RenderBudget &budget,
+                            std::string &output,
+                            const uint64_t pauseSize,
+                            Jinja2InstructionCounters* counters,
+                            uint32_t &includeId,
+                            std::string &errorMessage) const
+{
+    Jinja2PausePoint pause;
+    pause.pauseSize = pauseSize;
+
+    // resumable renders never use threads, so the loops are not rendered in parallel
+    bool success = false;
+    if(counters == nullptr)
+    {
+        success = executeRange<false>(input,
+                                      contextIndex,
+                                      output,
+                                      nullptr,
+                                      budget,
+                                      frame.loops,
+                                      frame.pos,
+                                      m_bytecode->numberOfInstructions,
+                                      false,
+                                      &pause,
+                                      nullptr,
+                                      errorMessage);
+    }
+    else
+    {
+        success = executeRange<true>(input,
+                                     contextIndex,
+                                     output,
+                                     nullptr,
+                                     budget,
+                                     frame.loops,
+                                     frame.pos,
+                                     m_bytecode->numberOfInstructions,
+                                     false,
+                                     &pause,
+                                     counters,
+                                     errorMessage);
+    }
+
+    frame.pos = pause.pos;
+    includeId = pause.includeId;
+
+    return success;
+}
+
+/**
+ * @brief check, if a paused range has reached its pause-size
+ *
+ * @param pause pause-point of the range, or nullptr, if the range can not be paused
+ * @param output output of the range
+ * @param nextPos position of the next instruction, where the render would be continued
+ * @param checkSize reference for the next size, where the output is checked, which is
+ *                  limited to the pause-size
+ *
+ * @return true, if the range must be paused, else false
+ */
+bool
+Jinja2Template::reachedPause(Jinja2PausePoint* pause,
+                             const std::string &output,
+                             const uint32_t nextPos,
+                             uint64_t &checkSize) const
+{
+    if(pause == nullptr) {
+        return false;
+    }
+
+    if(output.size() >= pause->pauseSize)
+    {
+        pause->pos = nextPos;
+        return true;
+    }
+
+    checkSize = std::min(checkSize, pause->pauseSize);
+
+    return false;
+}
+
+/**
+ * @brief enable rendering of big loops with multiple threads. The template must not be
+ *        rendered, while the settings are changed.
+ *
+ * @param minNumberOfElements minimum number of elements of an array, so the loop over it is
+ *                            rendered in parallel. 0 disables parallel loops.
+ * @param numberOfThreads maximum number of threads for one loop including the rendering thread.
+ *                        0 means one thread per cpu-core.
+ */
+void
+Jinja2Template::setParallelLoops(const uint64_t minNumberOfElements,
+                                 const uint32_t numberOfThreads)
+{
+    m_parallelLoopThreshold = minNumberOfElements;
+    m_parallelLoopThreads = numberOfThreads;
+}
+
+/**
+ * @brief set the limits, which are checked while rendering, so a render with an unexpected big
+ *        input is aborted early with an error instead of using too much memory. The template
+ *        must not be rendered, while the limits are changed.
+ *
+ * @param limits new limits. Values of 0 disable the single limits.
+ */
+void
+Jinja2Template::setRenderLimits(const RenderLimits &limits)
+{
+    m_renderLimits = limits;
+}
+
+/**
+ * @brief get the limits, which are checked while rendering
+ *
+ * @return limits of the template
+ */
+RenderLimits
+Jinja2Template::getRenderLimits() const
+{
+    return m_renderLimits;
+}
+
+/**
+ * @brief get all paths within the input, which are read by the template. Paths, which start
+ *        with a loop-variable, are replaced by the path of the array of the loop.
+ *
+ * @return list of paths with dots as separator, without duplicates
+ */
+const std::vector<std::string>
+Jinja2Template::getDependencies() const
+{
+    const Jinja2Bytecode &bytecode = *m_bytecode;
+
+    std::vector<uint8_t> added(bytecode.numberOfPaths, 0);
+    std::vector<std::string> result;
+
+    for(const uint32_t pathId : bytecode.segmentDependencies)
+    {
+        if(added[pathId] == 0)
+        {
+            added[pathId] = 1;
+            result.push_back(getPathString(pathId));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief get the number of top-level segments of the template. Each text, replacement,
+ *        if-condition and for-loop on the top-level of the template is a separate segment,
+ *        except of text, which is merged with its neighbors.
+ *
+ * @return number of segments
+ */
+uint64_t
+Jinja2Template::getNumberOfSegments() const
+{
+    return m_bytecode->segments.size();
+}
+
+/**
+ * @brief get the paths within the input, which are read by a top-level segment
+ *
+ * @param segmentId id of the segment
+ *
+ * @return list of paths with dots as separator, or empty list, if the id is invalid
+ */
+const std::vector<std::string>
+Jinja2Template::getSegmentDependencies(const uint64_t segmentId) const
+{
+    std::vector<std::string> result;
+    if(segmentId >= m_bytecode->segments.size()) {
+        return result;
+    }
+
+    const Jinja2Segment &segment = m_bytecode->segments[segmentId];
+    for(uint32_t i = 0; i < segment.numberOfDependencies; i++)
+    {
+        const uint32_t pathId = m_bytecode->segmentDependencies[segment.firstDependency + i];
+        result.push_back(getPathString(pathId));
+    }
+
+    return result;
+}
+
+/**
+ * @brief check if the output of the template can change, when some paths of the input change
+ *
+ * @param changedPaths paths with dots as separator, which were added, removed or modified
+ *                     within the input. A change of a path also changes all its children.
+ *
+ * @return false, if the output is unchanged, else true
+ */
+bool
+Jinja2Template::isAffected(const std::vector<std::string> &changedPaths) const
+{
+    for(uint64_t i = 0; i < m_bytecode->segments.size(); i++)
+    {
+        if(isSegmentAffected(i, changedPaths)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief render the template again, after some paths of the input were changed. Only the
+ *        top-level segments, which read one of the changed paths, are rendered and the
+ *        output of all other segments is taken from the state of the last render. If the state
+ *        is empty or was filled by another template, the complete template is rendered.
+ *
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param changedPaths paths with dots as separator, which were added, removed or modified
+ *                     within the input since the last render with the state
+ * @param state output of the last render, which is updated with the new output
+ * @param outputChanged reference, which is set to false, if the new output is identical to
+ *                      the output of the last render
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false. The state is cleared in case of an error.
+ */
+bool
+Jinja2Template::renderIncremental(DataMap* input,
+                                  const std::vector<std::string> &changedPaths,
+                                  Jinja2RenderState &state,
+                                  bool &outputChanged,
+                                  std::string &errorMessage) const
+{
+    const std::vector<Jinja2Segment> &segments = m_bytecode->segments;
+
+    const bool fullRender = state.m_template != this
+                            || state.m_templateId != m_id
+                            || state.m_segmentOutputs.size() != segments.size();
+    if(fullRender)
+    {
+        state.clear();
+        state.m_template = this;
+        state.m_templateId = m_id;
+        state.m_segmentOutputs.resize(segments.size());
+    }
+
+    state.m_numberOfRenderedSegments = 0;
+    outputChanged = fullRender;
+
+    // all segments share the limits of one render, so the output of the segments before, also
+    // the reused ones, is charged against the output-limit of each segment
+    Jinja2RenderBudget budget;
+    if(createBudget(0, budget, errorMessage) == false)
+    {
+        state.clear();
+        return false;
+    }
+    const uint64_t outputLimit = budget.outputLimit;
+    uint64_t outputSize = 0;
+
+    for(uint64_t i = 0; i < segments.size(); i++)
+    {
+        if(fullRender
+                || isSegmentAffected(i, changedPaths))
+        {
+            if(outputLimit != UINT64_MAX) {
+                budget.outputLimit = outputLimit - outputSize;
+            }
+
+            state.m_buffer.clear();
+            if(execute(input,
+                       nullptr,
+                       state.m_buffer,
+                       nullptr,
+                       budget,
+                       segments[i].firstInstruction,
+                       segments[i].endInstruction,
+                       true,
+                       errorMessage) == false)
+            {
+                state.clear();
+                return false;
+            }
+            state.m_numberOfRenderedSegments++;
+
+            if(state.m_buffer != state.m_segmentOutputs[i])
+            {
+                state.m_segmentOutputs[i].swap(state.m_buffer);
+                outputChanged = true;
+            }
+        }
+
+        outputSize += state.m_segmentOutputs[i].size();
+        if(outputSize >= outputLimit)
+        {
+            errorMessage = createOutputLimitError(budget);
+            state.clear();
+            return false;
+        }
+    }
+
+    if(outputChanged == false) {
+        return true;
+    }
+
+    state.m_output.clear();
+    state.m_output.reserve(outputSize);
+    for(const std::string &segmentOutput : state.m_segmentOutputs) {
+        state.m_output.append(segmentOutput);
+    }
+
+    return true;
+}
+
+/**
+ * @brief enable or disable the collection of counters for each instruction while rendering.
+ *        Without profiling the renders have no additional costs. The template must not be
+ *        rendered, while the setting is changed.
+ *
+ * @param enabled true to enable profiling. Disabling removes all collected counters.
+ */
+void
+Jinja2Template::setProfiling(const bool enabled)
+{
+    if(enabled && m_profiler == nullptr) {
+        m_profiler = new Jinja2Profiler();
+    }
+
+    if(enabled == false)
+    {
+        delete m_profiler;
+        m_profiler = nullptr;
+    }
+}
+
+/**
+ * @brief check if profiling is enabled
+ *
+ * @return true, if enabled, else false
+ */
+bool
+Jinja2Template::isProfiling() const
+{
+    return m_profiler != nullptr;
+}
+
+/**
+ * @brief get the summed counters of all profiled renders
+ *
+ * @return profile of the template. Only the parse-time is set, if profiling is disabled.
+ */
+TemplateProfile
+Jinja2Template::getProfile() const
+{
+    const Jinja2Bytecode &bytecode = *m_bytecode;
+
+    TemplateProfile profile;
+    profile.parseTime = m_parseTime;
+    if(m_profiler == nullptr) {
+        return profile;
+    }
+
+    std::lock_guard<std::mutex> guard(m_profiler->lock);
+
+    profile.numberOfRenders = m_profiler->numberOfRenders;
+    profile.renderTime = m_profiler->renderTime;
+
+    const std::vector<Jinja2InstructionCounters> &counters = m_profiler->counters;
+    const std::vector<Jinja2SourceLocation> &locations = bytecode.storage.sourceLocations;
+
+    profile.instructions.resize(bytecode.numberOfInstructions);
+    for(uint32_t i = 0; i < bytecode.numberOfInstructions; i++)
+    {
+        InstructionProfile &instructionProfile = profile.instructions[i];
+
+        // templates of bundle-files have no source-locations
+        if(i < locations.size())
+        {
+            instructionProfile.line = locations[i].line;
+            instructionProfile.column = locations[i].column;
+        }
+
+        if(i < counters.size())
+        {
+            instructionProfile.executions = counters[i].executions;
+            instructionProfile.lookups = counters[i].lookups;
+            instructionProfile.loopIterations = counters[i].loopIterations;
+            instructionProfile.emittedBytes = counters[i].emittedBytes;
+            instructionProfile.parallelLoops = counters[i].parallelLoops;
+        }
+
+        profile.visitedInstructions += instructionProfile.executions;
+        profile.loopIterations += instructionProfile.loopIterations;
+        profile.emittedBytes += instructionProfile.emittedBytes;
+        profile.parallelLoops += instructionProfile.parallelLoops;
+
+        switch(bytecode.instructions[i].opCode)
+        {
+            case EMIT_TEXT:
+                instructionProfile.type = "text";
+                break;
+            case EMIT_VAR:
+                instructionProfile.type = "replace";
+                profile.replaceLookups += instructionProfile.lookups;
+                break;
+            case JUMP_IF_FALSE:
+                instructionProfile.type = "if";
+                profile.ifLookups += instructionProfile.lookups;
+                break;
+            case JUMP:
+                instructionProfile.type = "else";
+                break;
+            case LOOP_BEGIN:
+                instructionProfile.type = "for";
+                profile.forLookups += instructionProfile.lookups;
+                break;
+            case LOOP_NEXT:
+                instructionProfile.type = "endfor";
+                break;
+            case INCLUDE:
+                instructionProfile.type = "include";
+                break;
+        }
+    }
+
+    return profile;
+}
+
+/**
+ * @brief remove the counters of all profiled renders, without disabling the profiling
+ */
+void
+Jinja2Template::resetProfile()
+{
+    if(m_profiler == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_profiler->lock);
+
+    m_profiler->numberOfRenders = 0;
+    m_profiler->renderTime = 0;
+    m_profiler->counters.clear();
+}
+
+/**
+ * @brief convert the profile of the template into a human-readable table with one line for
+ *        each instruction and its location within the template-string
+ *
+ * @return profile as string
+ */
+const std::string
+Jinja2Template::dumpProfile() const
+{
+    const TemplateProfile profile = getProfile();
+
+    std::string result = "";
+    result += "parse-time: " + std::to_string(profile.parseTime) + " ns\n";
+    result += "renders: " + std::to_string(profile.numberOfRenders) + "\n";
+    result += "render-time: " + std::to_string(profile.renderTime) + " ns\n";
+    result += "visited instructions: " + std::to_string(profile.visitedInstructions) + "\n";
+    result += "lookups: replace " + std::to_string(profile.replaceLookups)
+              + ", if " + std::to_string(profile.ifLookups)
+              + ", for " + std::to_string(profile.forLookups) + "\n";
+    result += "loop-iterations: " + std::to_string(profile.loopIterations) + "\n";
+    result += "parallel loops: " + std::to_string(profile.parallelLoops) + "\n";
+    result += "emitted bytes: " + std::to_string(profile.emittedBytes) + "\n";
+
+    if(profile.instructions.size() == 0) {
+        return result;
+    }
+
+    char line[128];
+    snprintf(line, sizeof(line), "%-12s %-8s %12s %12s %12s %12s\n",
+             "location", "type", "executions", "lookups", "iterations", "bytes");
+    result += line;
+
+    for(const InstructionProfile &instruction : profile.instructions)
+    {
+        std::string location = "-";
+        if(instruction.line != 0) {
+            location = std::to_string(instruction.line) + ":" + std::to_string(instruction.column);
+        }
+
+        snprintf(line, sizeof(line), "%-12s %-8s %12llu %12llu %12llu %12llu\n",
+                 location.c_str(),
+                 instruction.type.c_str(),
+                 static_cast<unsigned long long>(instruction.executions),
+                 static_cast<unsigned long long>(instruction.lookups),
+                 static_cast<unsigned long long>(instruction.loopIterations),
+                 static_cast<unsigned long long>(instruction.emittedBytes));
+        result += line;
+    }
+
+    return result;
+}
+
+/**
+ * @brief forward the buffered output to the sink
+ *
+ * @param sink sink to flush
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the sink failed to write the output, else true
+ */
+bool
+Jinja2Template::flushSink(Jinja2Sink &sink,
+                          std::string &errorMessage) const
+{
+    if(sink.flush() == false)
+    {
+        errorMessage =  "error while converting jinja2-template \n";
+        errorMessage += "    failed to write the output into the sink \n";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief check the nesting-depth of the template against the render-limits. The depth is
+ *        already known after compiling, so it has not to be checked while rendering.
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the template is nested too deep, else true
+ */
+bool
+Jinja2Template::checkNestingDepth(std::string &errorMessage) const
+{
+    if(m_renderLimits.maxNestingDepth != 0
+            && m_bytecode->maxNestingDepth > m_renderLimits.maxNestingDepth)
+    {
+        errorMessage =  "error while converting jinja2-template \n";
+        errorMessage += "    nesting-depth of " + std::to_string(m_bytecode->maxNestingDepth)
+                        + " exceeds the limit of "
+                        + std::to_string(m_renderLimits.maxNestingDepth) + " \n";
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief create the budget for a new render based on the render-limits
+ *
+ * @param outputSize size of the output-buffer before the render
+ * @param budget reference for the budget
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the template is nested too deep, else true
+ */
+bool
+Jinja2Template::createBudget(const uint64_t outputSize,
+                             Jinja2RenderBudget &budget,
+                             std::string &errorMessage) const
+{
+    budget = Jinja2RenderBudget();
+    budget.maxOutputSize = m_renderLimits.maxOutputSize;
+    budget.maxLoopIterations = m_renderLimits.maxLoopIterations;
+
+    if(m_renderLimits.maxOutputSize != 0
+            && m_renderLimits.maxOutputSize < UINT64_MAX - outputSize - 1)
+    {
+        budget.outputLimit = outputSize + m_renderLimits.maxOutputSize + 1;
+    }
+
+    if(m_renderLimits.maxLoopIterations != 0) {
+        budget.remainingIterations = m_renderLimits.maxLoopIterations;
+    }
+
+    return checkNestingDepth(errorMessage);
+}
+
+/**
+ * @brief get the size of the output-buffer, where the sink has to be flushed or the
+ *        output-limit is reached
+ *
+ * @param sink sink of the render, can be nullptr
+ * @param budget remaining limits of the render
+ *
+ * @return size of the output-buffer
+ */
+uint64_t
+Jinja2Template::getCheckSize(const Jinja2Sink* sink,
+                             const Jinja2RenderBudget &budget) const
+{
+    if(sink != nullptr) {
+        return std::min(sink->m_chunkSize, budget.outputLimit);
+    }
+
+    return budget.outputLimit;
+}
+
+/**
+ * @brief handle an output, which has reached the check-size, by checking the output-limit
+ *        and flushing the sink
+ *
+ * @param output reference for the output-string
+ * @param sink sink of the render, can be nullptr
+ * @param budget remaining limits of the render
+ * @param checkSize reference for the next check-size
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the limit is exceeded or the sink failed, else true
+ */
+bool
+Jinja2Template::checkOutput(std::string &output,
+                            Jinja2Sink* sink,
+                            Jinja2RenderBudget &budget,
+                            uint64_t &checkSize,
+                            std::string &errorMessage) const
+{
+    // chunks of a parallel loop add their new output to the shared budget at each check
+    if(budget.shared != nullptr)
+    {
+        Jinja2SharedBudget &shared = *budget.shared;
+        const uint64_t newBytes = output.size() - budget.reportedSize;
+        const uint64_t outputSize = shared.outputSize.fetch_add(newBytes) + newBytes;
+        budget.reportedSize = output.size();
+
+        if(outputSize >= shared.outputLimit)
+        {
+            shared.cancelled.store(true);
+            errorMessage = createOutputLimitError(budget);
+            return false;
+        }
+        if(shared.cancelled.load(std::memory_order_relaxed)) {
+            return false;
+        }
+
+        // the next update is at the latest, when the limit would be reached by this chunk alone
+        budget.outputLimit = output.size() + std::min(Jinja2SharedBudget::CHECK_STEP,
+                                                      shared.outputLimit - outputSize);
+        checkSize = budget.outputLimit;
+        return true;
+    }
+
+    if(output.size() >= budget.outputLimit)
+    {
+        errorMessage = createOutputLimitError(budget);
+        return false;
+    }
+
+    if(sink != nullptr
+            && output.size() >= sink->m_chunkSize)
+    {
+        const uint64_t flushedSize = output.size();
+        if(flushSink(*sink, errorMessage) == false) {
+            return false;
+        }
+
+        if(budget.outputLimit != UINT64_MAX) {
+            budget.outputLimit -= flushedSize;
+        }
+    }
+
+    checkSize = getCheckSize(sink, budget);
+
+    return true;
+}
+
+/**
+ * @brief charge the iterations of a loop against the budget of the render
+ *
+ * @param budget remaining limits of the render
+ * @param numberOfIterations number of elements of the array of the loop
+ * @param pathId id of the path of the array for the error-message
+ * @param errorMessage reference for error-message output
+ *
+ * @return false, if the limit is exceeded, else true
+ */
+bool
+Jinja2Template::chargeIterations(Jinja2RenderBudget &budget,
+                                 const uint64_t numberOfIterations,
+                                 const uint32_t pathId,
+                                 std::string &errorMessage) const
+{
+    // chunks of a parallel loop use the counter of the shared budget, if there is a limit
+    Jinja2SharedBudget* shared = budget.shared;
+    if(shared != nullptr
+            && shared->remainingIterations != UINT64_MAX)
+    {
+        const uint64_t iterations = shared->iterations.fetch_add(numberOfIterations)
+                                    + numberOfIterations;
+        if(iterations > shared->remainingIterations)
+        {
+            shared->cancelled.store(true);
+            errorMessage = createLoopLimitError(budget, pathId);
+            return false;
+        }
+        return true;
+    }
+
+    if(numberOfIterations > budget.remainingIterations)
+    {
+        errorMessage = createLoopLimitError(budget, pathId);
+        return false;
+    }
+    budget.remainingIterations -= numberOfIterations;
+
+    return true;
+}
+
+/**
+ * @brief estimate the size of the output of a render, based on the size of the literal text
+ *        of the template and the output of earlier renders. Can be used to reserve the
+ *        output-buffer.
+ *
+ * @return estimated number of bytes of the output
+ */
+uint64_t
+Jinja2Template::estimateOutputSize() const
+{
+    return m_bytecode->literalSize + m_averageDynamicSize.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief get information about the size and complexity of the compiled template
+ *
+ * @return statistics of the template
+ */
+TemplateStatistics
+Jinja2Template::getStatistics() const
+{
+    const Jinja2Bytecode &bytecode = *m_bytecode;
+
+    TemplateStatistics statistics;
+    statistics.numberOfInstructions = bytecode.numberOfInstructions;
+    statistics.literalSize = bytecode.literalSize;
+    statistics.numberOfPaths = bytecode.numberOfPaths;
+    statistics.numberOfKeys = bytecode.numberOfKeys;
+    statistics.numberOfConditions = bytecode.numberOfConditions;
+    statistics.maxNestingDepth = bytecode.maxNestingDepth;
+    statistics.bytecodeSize = bytecode.numberOfInstructions * sizeof(Jinja2Instruction)
+                              + bytecode.stringPoolSize
+                              + bytecode.numberOfKeys * sizeof(Jinja2Key)
+                              + bytecode.numberOfPathSegments * sizeof(uint32_t)
+                              + bytecode.numberOfPaths * sizeof(Jinja2CompiledPath)
+                              + bytecode.numberOfConditions * sizeof(Jinja2Condition);
+    statistics.isSpliceList = bytecode.splices.size() > 0;
+
+    return statistics;
+}
+
+/**
+ * @brief update the running average of the dynamic part of the output
+ *
+ * @param outputSize number of bytes of the output of the last render
+ */
+void
+Jinja2Template::updateSizeEstimation(const uint64_t outputSize) const
+{
+    uint64_t dynamicSize = 0;
+    if(outputSize > m_bytecode->literalSize) {
+        dynamicSize = outputSize - m_bytecode->literalSize;
+    }
+
+    // new renders have a weight of 1/8 and concurrent updates are allowed to overwrite each
+    // other, because it is only an estimation
+    uint64_t average = m_averageDynamicSize.load(std::memory_order_relaxed);
+    if(average == 0) {
+        average = dynamicSize;
+    } else {
+        average = average - (average / 8) + (dynamicSize / 8);
+    }
+
+    m_averageDynamicSize.store(average, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Search a specific item in the loop-variables or the json-input
+ *
+ * @param input The json-object in which the item sould be searched
+ * @param contextIndex index of a prepared context, or nullptr to search in the input
+ * @param loops frames of the active loops
+ * @param numberOfLoops number of active loops
+ * @param pathId id of the path within the bytecode
+ *
+ * @return pointer to the item, if found, else nullptr
+ */
+DataItem*
+Jinja2Template::getItem(DataMap* input,
+                        const Jinja2ContextIndex* contextIndex,
+                        const Jinja2LoopFrame* loops,
+                        const uint64_t numberOfLoops,
+                        const uint32_t pathId) const
+{
+    const Jinja2CompiledPath &path = m_bytecode->paths[pathId];
+    const uint32_t* segments = &m_bytecode->pathSegments[path.firstSegment];
+    const std::string* keyNames = m_bytecode->keyNames.data();
+
+    DataItem* tempJson = input;
+    uint32_t firstSegment = 0;
+
+    // the first segment can be the variable of a loop. Names are interned as keys, so only the
+    // key-ids have to be compared and the innermost loop shadows the outer loops and the input.
+    for(uint64_t i = numberOfLoops; i > 0; i--)
+    {
+        if(loops[i - 1].keyId == segments[0])
+        {
+            tempJson = loops[i - 1].value;
+            firstSegment = 1;
+            break;
+        }
+    }
+
+    // all paths within the input are already resolved by the prepared context
+    if(firstSegment == 0
+            && contextIndex != nullptr)
+    {
+        return contextIndex->find(m_bytecode->pathHashes[pathId], m_bytecode->pathNames[pathId]);
+    }
+
+    // search for the item with the already existing key-strings, so no temporary strings
+    // have to be created
+    for(uint32_t i = firstSegment; i < path.numberOfSegments; i++)
+    {
+        tempJson = tempJson->get(keyNames[segments[i]]);
+        if(tempJson == nullptr) {
+            return nullptr;
+        }
+    }
+
+    return tempJson;
+}
+
+/**
+ * @brief check if a top-level segment reads one of the changed paths
+ *
+ * @param segmentId id of the segment
+ * @param changedPaths paths with dots as separator, which were changed within the input
+ *
+ * @return true, if the output of the segment can change, else false
+ */
+bool
+Jinja2Template::isSegmentAffected(const uint64_t segmentId,
+                                  const std::vector<std::string> &changedPaths) const
+{
+    const Jinja2Segment &segment = m_bytecode->segments[segmentId];
+
+    for(uint32_t i = 0; i < segment.numberOfDependencies; i++)
+    {
+        const uint32_t pathId = m_bytecode->segmentDependencies[segment.firstDependency + i];
+        for(const std::string &changedPath : changedPaths)
+        {
+            if(isPathAffected(*m_bytecode, pathId, changedPath)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief convert a path of the bytecode into a string
+ *
+ * @param pathId id of the path within the bytecode
+ *
+ * @return path with dots as separator
+ */
+const std::string
+Jinja2Template::getPathString(const uint32_t pathId) const
+{
+    return m_bytecode->pathNames[pathId];
+}
+
+/**
+ * @brief Is called, when an error occurs while compiling and generates an error-message for output
+ *
+ * @param pathId id of the path within the json-object to the item which was not found
+ *
+ * @return error-messaage for the user
+ */
+const std::string
+Jinja2Template::createErrorMessage(const uint32_t pathId) const
+{
+    std::string errorMessage = "";
+    errorMessage =  "error while converting jinja2-template \n";
+    errorMessage += "    can not find item in path in json-input: ";
+    errorMessage += getPathString(pathId);
+    errorMessage += "\n";
+    errorMessage += "    or maybe the item does not have a valid format";
+    errorMessage +=    " or the place where it should be used \n";
+
+    return errorMessage;
+}
+
+/**
+ * @brief create the error-message for an output, which exceeds the render-limit
+ *
+ * @param budget limits of the render
+ *
+ * @return error-messaage for the user
+ */
+const std::string
+Jinja2Template::createOutputLimitError(const Jinja2RenderBudget &budget) const
+{
+    std::string errorMessage = "";
+    errorMessage =  "error while converting jinja2-template \n";
+    errorMessage += "    output exceeds the limit of ";
+    errorMessage += std::to_string(budget.maxOutputSize);
+    errorMessage += " bytes \n";
+
+    return errorMessage;
+}
+
+/**
+ * @brief create the error-message for loops, which exceed the render-limit of iterations
+ *
+ * @param budget limits of the render
+ * @param pathId id of the path of the array of the loop, or UINT32_MAX, if the loop is not known
+ *
+ * @return error-messaage for the user
+ */
+const std::string
+Jinja2Template::createLoopLimitError(const Jinja2RenderBudget &budget,
+                                     const uint32_t pathId) const
+{
+    std::string errorMessage = "";
+    errorMessage =  "error while converting jinja2-template \n";
+    errorMessage += "    loop-iterations exceed the limit of ";
+    errorMessage += std::to_string(budget.maxLoopIterations);
+    errorMessage += " in loop over: ";
+    errorMessage += getPathString(pathId);
+    errorMessage += " \n";
+
+    return errorMessage;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+Jinja2RenderState::Jinja2RenderState() {}
+
+/**
+ * @brief destructor
+ */
+Jinja2RenderState::~Jinja2RenderState() {}
+
+/**
+ * @brief get the output of the last successful incremental render
+ *
+ * @return output of the template, or empty string, if the state was not filled
+ */
+const std::string&
+Jinja2RenderState::getOutput() const
+{
+    return m_output;
+}
+
+/**
+ * @brief get the number of top-level segments, which were rendered by the last incremental
+ *        render. All other segments were taken from the earlier output.
+ *
+ * @return number of rendered segments
+ */
+uint64_t
+Jinja2RenderState::getNumberOfRenderedSegments() const
+{
+    return m_numberOfRenderedSegments;
+}
+
+/**
+ * @brief remove the output of the last render, so the next incremental render renders the
+ *        complete template
+ */
+void
+Jinja2RenderState::clear()
+{
+    m_template = nullptr;
+    m_templateId = 0;
+    m_segmentOutputs.clear();
+    m_output.clear();
+    m_buffer.clear();
+    m_numberOfRenderedSegments = 0;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+Jinja2RenderContinuation::Jinja2RenderContinuation() {}
+
+/**
+ * @brief destructor
+ */
+Jinja2RenderContinuation::~Jinja2RenderContinuation()
+{
+    delete m_state;
+}
+
+/**
+ * @brief check if all instructions of the render are processed. The output can still contain
+ *        bytes, which were not consumed.
+ *
+ * @return true, if the render is finished or was never started, else false
+ */
+bool
+Jinja2RenderContinuation::isFinished() const
+{
+    return m_state == nullptr
+           || m_state->frames.empty();
+}
+
+/**
+ * @brief get the rendered output, which was not consumed until now
+ *
+ * @return pointer to the first not consumed byte
+ */
+const char*
+Jinja2RenderContinuation::getData() const
+{
+    return m_output.c_str() + m_outputOffset;
+}
+
+/**
+ * @brief get the number of rendered bytes, which were not consumed until now
+ *
+ * @return number of bytes
+ */
+uint64_t
+Jinja2RenderContinuation::getSize() const
+{
+    return m_output.size() - m_outputOffset;
+}
+
+/**
+ * @brief mark bytes at the begin of the output as consumed, for example after they were
+ *        written into a socket
+ *
+ * @param numberOfBytes number of bytes. It is limited to the size of the output.
+ */
+void
+Jinja2RenderContinuation::consume(const uint64_t numberOfBytes)
+{
+    m_outputOffset += std::min(numberOfBytes, getSize());
+}
+
+/**
+ * @brief stop the render and remove all output
+ */
+void
+Jinja2RenderContinuation::clear()
+{
+    m_template = nullptr;
+    m_input = nullptr;
+    if(m_state != nullptr)
+    {
+        m_state->frames.clear();
+        m_state->budget = Jinja2RenderBudget();
+        m_state->contextIndex = nullptr;
+        m_state->counters.clear();
+        m_state->renderTime = 0;
+    }
+    m_output.clear();
+    m_outputOffset = 0;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
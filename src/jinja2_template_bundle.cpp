@@ -0,0 +1,642 @@
+/**
+ *  @file    jinja2_template_bundle.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_template_bundle.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+
+#include <jinja2_bytecode.h>
+#include <jinja2_dependencies.h>
+#include <jinja2_splice_list.h>
+#include <jinja2_context_index.h>
+
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+//===================================================================
+// file-format
+//===================================================================
+// The file starts with the header, followed by one entry for each template and the sections
+// with the content of the entries. All sections are aligned to 8 bytes and the arrays of the
+// sections are used directly as views of the bytecode.
+
+const char BUNDLE_MAGIC[8] = {'K', 'J', '2', 'B', 'N', 'D', 'L', '\0'};
+const uint32_t BUNDLE_VERSION = 1;
+// is written in the byte-order of the writer, to detect files of other architectures
+const uint32_t BUNDLE_BYTE_ORDER = 0x01020304;
+
+struct Jinja2BundleHeader
+{
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t byteOrder = 0;
+    uint64_t fileSize = 0;
+    uint64_t numberOfTemplates = 0;
+};
+
+struct Jinja2BundleSection
+{
+    // offset and size in bytes within the file
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+struct Jinja2BundleEntry
+{
+    Jinja2BundleSection name;
+    Jinja2BundleSection instructions;
+    Jinja2BundleSection stringPool;
+    Jinja2BundleSection keys;
+    Jinja2BundleSection pathSegments;
+    Jinja2BundleSection paths;
+    Jinja2BundleSection conditions;
+    uint32_t maxNestingDepth = 0;
+    uint32_t padding = 0;
+    uint64_t literalSize = 0;
+};
+
+static_assert(sizeof(Jinja2BundleHeader) == 32, "unexpected layout of bundle-header");
+static_assert(sizeof(Jinja2BundleEntry) == 128, "unexpected layout of bundle-entry");
+static_assert(sizeof(Jinja2Instruction) == 16, "unexpected layout of instructions");
+static_assert(sizeof(Jinja2Key) == 16, "unexpected layout of keys");
+static_assert(sizeof(Jinja2CompiledPath) == 8, "unexpected layout of paths");
+static_assert(sizeof(Jinja2Condition) == 32, "unexpected layout of conditions");
+static_assert(std::is_trivially_copyable<Jinja2Instruction>::value
+              && std::is_trivially_copyable<Jinja2Key>::value
+              && std::is_trivially_copyable<Jinja2CompiledPath>::value
+              && std::is_trivially_copyable<Jinja2Condition>::value,
+              "content of the bytecode must be trivially copyable");
+
+/**
+ * @brief append a section to the content of a bundle-file
+ *
+ * @param buffer content of the file
+ * @param data pointer to the data of the section
+ * @param size number of bytes of the section
+ *
+ * @return position and size of the new section
+ */
+Jinja2BundleSection
+appendSection(std::string &buffer,
+              const void* data,
+              const uint64_t size)
+{
+    // align the begin of the section to 8 bytes
+    while(buffer.size() % 8 != 0) {
+        buffer.push_back('\0');
+    }
+
+    Jinja2BundleSection section;
+    section.offset = buffer.size();
+    section.size = size;
+
+    if(size > 0) {
+        buffer.append(static_cast<const char*>(data), size);
+    }
+
+    return section;
+}
+
+/**
+ * @brief check if a section is inside of the file and has the correct size and alignment for
+ *        an array of the given type
+ *
+ * @param section section to check
+ * @param fileSize number of bytes of the file
+ * @param elementSize size of the elements of the array
+ *
+ * @return true, if valid, else false
+ */
+bool
+isValidSection(const Jinja2BundleSection &section,
+               const uint64_t fileSize,
+               const uint64_t elementSize)
+{
+    return section.offset <= fileSize
+           && section.size <= fileSize - section.offset
+           && section.offset % 8 == 0
+           && section.size % elementSize == 0
+           && section.size / elementSize < UINT32_MAX;
+}
+
+//==================================================================================================
+
+/**
+ * @brief constructor
+ */
+Jinja2TemplateBundle::Jinja2TemplateBundle() {}
+
+/**
+ * @brief destructor. Templates, which were created by the bundle, are still valid, because
+ *        they hold their own reference to the mapped file.
+ */
+Jinja2TemplateBundle::~Jinja2TemplateBundle() {}
+
+/**
+ * @brief write compiled templates into a bundle-file
+ *
+ * @param filePath path of the new file. An existing file is overwritten.
+ * @param names names of the templates, to identify them within the bundle
+ * @param templates compiled templates, in the same order like the names
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2TemplateBundle::writeFile(const std::string &filePath,
+                                const std::vector<std::string> &names,
+                                const std::vector<Jinja2Template*> &templates,
+                                std::string &errorMessage)
+{
+    if(names.size() != templates.size())
+    {
+        errorMessage = "number of names and templates doesn't match";
+        return false;
+    }
+
+    // header and entries are written at the end, when all offsets are known
+    const uint64_t headerSize = sizeof(Jinja2BundleHeader)
+                                + templates.size() * sizeof(Jinja2BundleEntry);
+    std::string buffer(headerSize, '\0');
+    std::vector<Jinja2BundleEntry> entries(templates.size());
+
+    for(uint64_t i = 0; i < templates.size(); i++)
+    {
+        const Jinja2Bytecode &bytecode = *templates[i]->m_bytecode;
+        Jinja2BundleEntry &entry = entries.at(i);
+
+        // included templates are shared in memory and can not be stored within the file
+        if(bytecode.includes.size() > 0)
+        {
+            errorMessage = "template '" + names.at(i) + "' contains includes";
+            return false;
+        }
+
+        entry.name = appendSection(buffer, names.at(i).c_str(), names.at(i).size());
+        entry.instructions = appendSection(buffer,
+                                           bytecode.instructions,
+                                           bytecode.numberOfInstructions
+                                           * sizeof(Jinja2Instruction));
+        entry.stringPool = appendSection(buffer,
+                                         bytecode.stringPool,
+                                         bytecode.stringPoolSize);
+        entry.keys = appendSection(buffer,
+                                   bytecode.keys,
+                                   bytecode.numberOfKeys * sizeof(Jinja2Key));
+        entry.pathSegments = appendSection(buffer,
+                                           bytecode.pathSegments,
+                                           bytecode.numberOfPathSegments * sizeof(uint32_t));
+        entry.paths = appendSection(buffer,
+                                    bytecode.paths,
+                                    bytecode.numberOfPaths * sizeof(Jinja2CompiledPath));
+        entry.conditions = appendSection(buffer,
+                                         bytecode.conditions,
+                                         bytecode.numberOfConditions * sizeof(Jinja2Condition));
+        entry.maxNestingDepth = bytecode.maxNestingDepth;
+        entry.literalSize = bytecode.literalSize;
+    }
+
+    Jinja2BundleHeader header;
+    memcpy(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+    header.version = BUNDLE_VERSION;
+    header.byteOrder = BUNDLE_BYTE_ORDER;
+    header.fileSize = buffer.size();
+    header.numberOfTemplates = templates.size();
+
+    memcpy(&buffer[0], &header, sizeof(Jinja2BundleHeader));
+    if(entries.size() > 0)
+    {
+        memcpy(&buffer[sizeof(Jinja2BundleHeader)],
+               entries.data(),
+               entries.size() * sizeof(Jinja2BundleEntry));
+    }
+
+    std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(file.is_open() == false)
+    {
+        errorMessage = "can not open file for writing: " + filePath;
+        return false;
+    }
+
+    file.write(buffer.c_str(), static_cast<std::streamsize>(buffer.size()));
+    file.close();
+    if(file.fail())
+    {
+        errorMessage = "failed to write file: " + filePath;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief map a bundle-file into the memory and validate its content
+ *
+ * @param filePath path of the bundle-file
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2TemplateBundle::loadFile(const std::string &filePath,
+                               std::string &errorMessage)
+{
+    m_mappedFile.reset();
+    m_fileSize = 0;
+    m_entries.clear();
+
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        errorMessage = "can not open bundle-file: " + filePath;
+        return false;
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0
+            || fileStat.st_size < static_cast<off_t>(sizeof(Jinja2BundleHeader)))
+    {
+        close(fd);
+        errorMessage = "invalid bundle-file: " + filePath;
+        return false;
+    }
+
+    const uint64_t fileSize = static_cast<uint64_t>(fileStat.st_size);
+    void* data = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED)
+    {
+        errorMessage = "can not map bundle-file: " + filePath;
+        return false;
+    }
+
+    // the file is unmapped, when the bundle and all templates of the bundle are deleted
+    m_mappedFile = std::shared_ptr<const void>(data, [fileSize](const void* ptr)
+    {
+        munmap(const_cast<void*>(ptr), fileSize);
+    });
+    m_fileSize = fileSize;
+
+    if(validateFile(errorMessage) == false)
+    {
+        errorMessage = "invalid bundle-file: " + filePath + "\n    " + errorMessage;
+        m_mappedFile.reset();
+        m_fileSize = 0;
+        m_entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief get number of templates of the loaded bundle
+ *
+ * @return number of templates
+ */
+uint64_t
+Jinja2TemplateBundle::getNumberOfTemplates() const
+{
+    return m_entries.size();
+}
+
+/**
+ * @brief get names of all templates of the loaded bundle
+ *
+ * @return list of names
+ */
+const std::vector<std::string>
+Jinja2TemplateBundle::getNames() const
+{
+    std::vector<std::string> result;
+    for(auto it = m_entries.begin(); it != m_entries.end(); it++) {
+        result.push_back(it->first);
+    }
+
+    return result;
+}
+
+/**
+ * @brief create a template, which is rendered directly from the mapped file
+ *
+ * @param name name of the template
+ *
+ * @return pointer to the template, if found, else nullptr. The caller takes the ownership of
+ *         the template and has to delete it.
+ */
+Jinja2Template*
+Jinja2TemplateBundle::getTemplate(const std::string &name) const
+{
+    auto it = m_entries.find(name);
+    if(it == m_entries.end()) {
+        return nullptr;
+    }
+
+    Jinja2Bytecode* bytecode = new Jinja2Bytecode();
+    fillBytecode(it->second, *bytecode);
+    bytecode->mappedFile = m_mappedFile;
+
+    // names of the keys are the only data, which have to be copied out of the file
+    bytecode->keyNames.reserve(bytecode->numberOfKeys);
+    for(uint32_t i = 0; i < bytecode->numberOfKeys; i++)
+    {
+        const Jinja2Key &key = bytecode->keys[i];
+        bytecode->keyNames.push_back(std::string(&bytecode->stringPool[key.nameOffset],
+                                                 key.length));
+    }
+
+    // bytecode of the file was already validated, so it can be split into segments
+    analyzeDependencies(*bytecode);
+    createSpliceList(*bytecode);
+    createPathNames(*bytecode);
+
+    return new Jinja2Template(bytecode);
+}
+
+/**
+ * @brief let the views of a bytecode point into the mapped file. The content is not validated
+ *        here.
+ *
+ * @param entryId id of the entry within the file
+ * @param bytecode reference to the bytecode, which should be filled
+ */
+void
+Jinja2TemplateBundle::fillBytecode(const uint64_t entryId,
+                                   Jinja2Bytecode &bytecode) const
+{
+    const uint8_t* data = static_cast<const uint8_t*>(m_mappedFile.get());
+    const Jinja2BundleEntry* entries =
+            reinterpret_cast<const Jinja2BundleEntry*>(&data[sizeof(Jinja2BundleHeader)]);
+    const Jinja2BundleEntry &entry = entries[entryId];
+
+    bytecode.instructions =
+            reinterpret_cast<const Jinja2Instruction*>(&data[entry.instructions.offset]);
+    bytecode.stringPool = reinterpret_cast<const char*>(&data[entry.stringPool.offset]);
+    bytecode.keys = reinterpret_cast<const Jinja2Key*>(&data[entry.keys.offset]);
+    bytecode.pathSegments = reinterpret_cast<const uint32_t*>(&data[entry.pathSegments.offset]);
+    bytecode.paths = reinterpret_cast<const Jinja2CompiledPath*>(&data[entry.paths.offset]);
+    bytecode.conditions =
+            reinterpret_cast<const Jinja2Condition*>(&data[entry.conditions.offset]);
+
+    bytecode.numberOfInstructions =
+            static_cast<uint32_t>(entry.instructions.size / sizeof(Jinja2Instruction));
+    bytecode.stringPoolSize = static_cast<uint32_t>(entry.stringPool.size);
+    bytecode.numberOfKeys = static_cast<uint32_t>(entry.keys.size / sizeof(Jinja2Key));
+    bytecode.numberOfPathSegments =
+            static_cast<uint32_t>(entry.pathSegments.size / sizeof(uint32_t));
+    bytecode.numberOfPaths =
+            static_cast<uint32_t>(entry.paths.size / sizeof(Jinja2CompiledPath));
+    bytecode.numberOfConditions =
+            static_cast<uint32_t>(entry.conditions.size / sizeof(Jinja2Condition));
+
+    bytecode.maxNestingDepth = entry.maxNestingDepth;
+    bytecode.literalSize = entry.literalSize;
+}
+
+/**
+ * @brief validate header and entries of the mapped file, so broken files can not crash the
+ *        render of the templates
+ *
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if valid, else false
+ */
+bool
+Jinja2TemplateBundle::validateFile(std::string &errorMessage)
+{
+    const uint8_t* data = static_cast<const uint8_t*>(m_mappedFile.get());
+
+    Jinja2BundleHeader header;
+    memcpy(&header, data, sizeof(Jinja2BundleHeader));
+
+    if(memcmp(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0)
+    {
+        errorMessage = "file is not a jinja2-bundle";
+        return false;
+    }
+    if(header.version != BUNDLE_VERSION
+            || header.byteOrder != BUNDLE_BYTE_ORDER)
+    {
+        errorMessage = "unsupported version or byte-order of the bundle";
+        return false;
+    }
+    if(header.fileSize != m_fileSize
+            || header.numberOfTemplates > (m_fileSize - sizeof(Jinja2BundleHeader))
+                                          / sizeof(Jinja2BundleEntry))
+    {
+        errorMessage = "bundle-file is incomplete";
+        return false;
+    }
+
+    const Jinja2BundleEntry* entries =
+            reinterpret_cast<const Jinja2BundleEntry*>(&data[sizeof(Jinja2BundleHeader)]);
+
+    for(uint64_t i = 0; i < header.numberOfTemplates; i++)
+    {
+        const Jinja2BundleEntry &entry = entries[i];
+        if(isValidSection(entry.name, m_fileSize, 1) == false
+                || isValidSection(entry.instructions, m_fileSize, sizeof(Jinja2Instruction)) == false
+                || isValidSection(entry.stringPool, m_fileSize, 1) == false
+                || isValidSection(entry.keys, m_fileSize, sizeof(Jinja2Key)) == false
+                || isValidSection(entry.pathSegments, m_fileSize, sizeof(uint32_t)) == false
+                || isValidSection(entry.paths, m_fileSize, sizeof(Jinja2CompiledPath)) == false
+                || isValidSection(entry.conditions, m_fileSize, sizeof(Jinja2Condition)) == false)
+        {
+            errorMessage = "section of template " + std::to_string(i) + " is outside of the file";
+            return false;
+        }
+
+        const std::string name(reinterpret_cast<const char*>(&data[entry.name.offset]),
+                               entry.name.size);
+
+        Jinja2Bytecode bytecode;
+        fillBytecode(i, bytecode);
+        if(validateBytecode(bytecode, errorMessage) == false)
+        {
+            errorMessage = "template '" + name + "' is broken: " + errorMessage;
+            return false;
+        }
+
+        m_entries[name] = i;
+    }
+
+    return true;
+}
+
+/**
+ * @brief check that all ids, offsets and jump-targets of a bytecode are valid
+ *
+ * @param bytecode bytecode to check
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if valid, else false
+ */
+bool
+Jinja2TemplateBundle::validateBytecode(const Jinja2Bytecode &bytecode,
+                                       std::string &errorMessage)
+{
+    const uint64_t poolSize = bytecode.stringPoolSize;
+    const uint32_t numberOfInstructions = bytecode.numberOfInstructions;
+
+    if(bytecode.maxNestingDepth > Jinja2Template::MAX_NESTING_DEPTH)
+    {
+        errorMessage = "nesting-depth is too big";
+        return false;
+    }
+
+    // strings of keys and conditions have to be null-terminated within the string-pool
+    for(uint32_t i = 0; i < bytecode.numberOfKeys; i++)
+    {
+        const Jinja2Key &key = bytecode.keys[i];
+        if(static_cast<uint64_t>(key.nameOffset) + key.length >= poolSize
+                || bytecode.stringPool[key.nameOffset + key.length] != '\0')
+        {
+            errorMessage = "invalid key";
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < bytecode.numberOfPathSegments; i++)
+    {
+        if(bytecode.pathSegments[i] >= bytecode.numberOfKeys)
+        {
+            errorMessage = "invalid path-segment";
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < bytecode.numberOfPaths; i++)
+    {
+        const Jinja2CompiledPath &path = bytecode.paths[i];
+        if(path.numberOfSegments == 0
+                || static_cast<uint64_t>(path.firstSegment) + path.numberOfSegments
+                   > bytecode.numberOfPathSegments)
+        {
+            errorMessage = "invalid path";
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < bytecode.numberOfConditions; i++)
+    {
+        const Jinja2Condition &condition = bytecode.conditions[i];
+        if(condition.pathId >= bytecode.numberOfPaths
+                || condition.compareType > IfItem::IS_TRUE
+                || condition.constantType > BOOL_CONSTANT
+                || static_cast<uint64_t>(condition.textOffset) + condition.textLength >= poolSize
+                || bytecode.stringPool[condition.textOffset + condition.textLength] != '\0')
+        {
+            errorMessage = "invalid condition";
+            return false;
+        }
+    }
+
+    // loops have to be nested correctly and each jump must stay within its loop. The region of
+    // an instruction is the position behind the LOOP_BEGIN of its innermost loop, or 0.
+    std::vector<uint32_t> regions(numberOfInstructions + 1, 0);
+    std::vector<uint32_t> openLoops;
+    uint64_t literalSize = 0;
+
+    for(uint32_t pos = 0; pos < numberOfInstructions; pos++)
+    {
+        const Jinja2Instruction &instruction = bytecode.instructions[pos];
+        regions[pos] = openLoops.empty() ? 0 : openLoops.back() + 1;
+
+        bool valid = true;
+        switch(instruction.opCode)
+        {
+            case EMIT_TEXT:
+                valid = static_cast<uint64_t>(instruction.arg0) + instruction.arg1 <= poolSize;
+                literalSize += instruction.arg1;
+                break;
+            case EMIT_VAR:
+                valid = instruction.arg0 < bytecode.numberOfPaths;
+                break;
+            case JUMP_IF_FALSE:
+                valid = instruction.arg0 < bytecode.numberOfConditions;
+                break;
+            case JUMP:
+                break;
+            case LOOP_BEGIN:
+            {
+                const uint32_t end = instruction.arg1;
+                valid = instruction.arg0 < bytecode.numberOfPaths
+                        && instruction.arg2 < bytecode.numberOfKeys
+                        && end >= pos + 2
+                        && end <= numberOfInstructions
+                        && bytecode.instructions[end - 1].opCode == LOOP_NEXT
+                        && bytecode.instructions[end - 1].arg1 == pos + 1;
+
+                // inner loop must end before the LOOP_NEXT of the outer loop
+                if(valid && openLoops.empty() == false) {
+                    valid = end < bytecode.instructions[openLoops.back()].arg1;
+                }
+                openLoops.push_back(pos);
+                break;
+            }
+            case LOOP_NEXT:
+                valid = openLoops.empty() == false
+                        && bytecode.instructions[openLoops.back()].arg1 == pos + 1;
+                if(valid) {
+                    openLoops.pop_back();
+                }
+                break;
+            default:
+                valid = false;
+                break;
+        }
+
+        if(valid == false)
+        {
+            errorMessage = "invalid instruction at position " + std::to_string(pos);
+            return false;
+        }
+    }
+
+    if(openLoops.empty() == false
+            || literalSize != bytecode.literalSize)
+    {
+        errorMessage = "invalid loops or size of the text";
+        return false;
+    }
+
+    // jumps only go forward, so the render always ends
+    for(uint32_t pos = 0; pos < numberOfInstructions; pos++)
+    {
+        const Jinja2Instruction &instruction = bytecode.instructions[pos];
+        if(instruction.opCode != JUMP
+                && instruction.opCode != JUMP_IF_FALSE)
+        {
+            continue;
+        }
+
+        if(instruction.arg1 <= pos
+                || instruction.arg1 > numberOfInstructions
+                || regions[instruction.arg1] != regions[pos])
+        {
+            errorMessage = "invalid jump at position " + std::to_string(pos);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
@@ -0,0 +1,269 @@
+/**
+ *  @file    jinja2_template_cache.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <jinja2_template_cache.h>
+
+#include <iterator>
+
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <jinja2_hash.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief constructor
+ *
+ * @param maxEntries maximum number of cached templates
+ * @param maxBytes maximum summed size of the template-strings of all cached templates
+ */
+Jinja2TemplateCache::Jinja2TemplateCache(const uint64_t maxEntries,
+                                         const uint64_t maxBytes)
+    : m_maxEntriesPerShard(0),
+      m_maxBytesPerShard(0),
+      m_hits(0),
+      m_misses(0),
+      m_evictions(0)
+{
+    setLimits(maxEntries, maxBytes);
+}
+
+/**
+ * @brief destructor
+ */
+Jinja2TemplateCache::~Jinja2TemplateCache()
+{
+    clear();
+}
+
+/**
+ * @brief get a compiled template from the cache
+ *
+ * @param templateString jinja2-formated string, which was used to compile the template
+ *
+ * @return pointer to the compiled template, if found, else nullptr
+ */
+std::shared_ptr<Jinja2Template>
+Jinja2TemplateCache::get(const std::string &templateString)
+{
+    return get(templateString, calculateHash(templateString));
+}
+
+/**
+ * @brief get a compiled template from the cache with an already calculated hash
+ *
+ * @param templateString jinja2-formated string, which was used to compile the template
+ * @param hash hash of the template-string, which was created with calculateHash
+ *
+ * @return pointer to the compiled template, if found, else nullptr
+ */
+std::shared_ptr<Jinja2Template>
+Jinja2TemplateCache::get(const std::string &templateString,
+                         const uint64_t hash)
+{
+    CacheShard &shard = m_shards[hash % NUMBER_OF_SHARDS];
+    std::shared_ptr<Jinja2Template> result;
+
+    shard.lock.lock();
+
+    auto it = shard.index.find(hash);
+    // compare the complete string to be save in case of a hash-collision
+    if(it != shard.index.end()
+            && it->second->templateString == templateString)
+    {
+        // move found entry to the front of the list to mark it as most recently used
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        result = it->second->compiledTemplate;
+    }
+
+    shard.lock.unlock();
+
+    if(result == nullptr) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+/**
+ * @brief get a compiled template from the cache without counting a hit or miss and without
+ *        changing the order of the least recently used entries
+ *
+ * @param templateString jinja2-formated string, which was used to compile the template
+ *
+ * @return pointer to the compiled template, if found, else nullptr
+ */
+std::shared_ptr<Jinja2Template>
+Jinja2TemplateCache::peek(const std::string &templateString)
+{
+    const uint64_t hash = calculateHash(templateString);
+    CacheShard &shard = m_shards[hash % NUMBER_OF_SHARDS];
+    std::shared_ptr<Jinja2Template> result;
+
+    shard.lock.lock();
+
+    auto it = shard.index.find(hash);
+    if(it != shard.index.end()
+            && it->second->templateString == templateString)
+    {
+        result = it->second->compiledTemplate;
+    }
+
+    shard.lock.unlock();
+
+    return result;
+}
+
+/**
+ * @brief add a new compiled template to the cache and evict the least recently used entries,
+ *        if the limits of the cache are reached
+ *
+ * @param templateString jinja2-formated string, which was used to compile the template
+ * @param compiledTemplate compiled template
+ */
+void
+Jinja2TemplateCache::insert(const std::string &templateString,
+                            const std::shared_ptr<Jinja2Template> &compiledTemplate)
+{
+    const uint64_t hash = calculateHash(templateString);
+    CacheShard &shard = m_shards[hash % NUMBER_OF_SHARDS];
+
+    // templates, which are bigger than the complete shard, are not cached at all
+    if(templateString.size() > m_maxBytesPerShard.load(std::memory_order_relaxed)
+            || m_maxEntriesPerShard.load(std::memory_order_relaxed) == 0)
+    {
+        return;
+    }
+
+    shard.lock.lock();
+
+    // replace old entry with the same hash, which can happen, when another thread has compiled
+    // the same template at the same time or in case of a hash-collision
+    auto it = shard.index.find(hash);
+    if(it != shard.index.end()) {
+        removeEntry(shard, it->second);
+    }
+
+    CacheEntry newEntry;
+    newEntry.hash = hash;
+    newEntry.templateString = templateString;
+    newEntry.compiledTemplate = compiledTemplate;
+
+    shard.entries.push_front(newEntry);
+    shard.index[hash] = shard.entries.begin();
+    shard.numberOfBytes += templateString.size();
+
+    evictEntries(shard);
+
+    shard.lock.unlock();
+}
+
+/**
+ * @brief set new limits for the cache. The limits are splitted equally over all shards.
+ *
+ * @param maxEntries maximum number of cached templates
+ * @param maxBytes maximum summed size of the template-strings of all cached templates
+ */
+void
+Jinja2TemplateCache::setLimits(const uint64_t maxEntries,
+                               const uint64_t maxBytes)
+{
+    m_maxEntriesPerShard = (maxEntries + NUMBER_OF_SHARDS - 1) / NUMBER_OF_SHARDS;
+    m_maxBytesPerShard = (maxBytes + NUMBER_OF_SHARDS - 1) / NUMBER_OF_SHARDS;
+
+    for(uint32_t i = 0; i < NUMBER_OF_SHARDS; i++)
+    {
+        m_shards[i].lock.lock();
+        evictEntries(m_shards[i]);
+        m_shards[i].lock.unlock();
+    }
+}
+
+/**
+ * @brief remove all entries from the cache. Templates, which are still in use by a render-call,
+ *        are deleted after this call is finished.
+ */
+void
+Jinja2TemplateCache::clear()
+{
+    for(uint32_t i = 0; i < NUMBER_OF_SHARDS; i++)
+    {
+        m_shards[i].lock.lock();
+        m_shards[i].index.clear();
+        m_shards[i].entries.clear();
+        m_shards[i].numberOfBytes = 0;
+        m_shards[i].lock.unlock();
+    }
+}
+
+/**
+ * @brief get the current counters of the cache
+ *
+ * @return statistics-object
+ */
+TemplateCacheStatistics
+Jinja2TemplateCache::getStatistics()
+{
+    TemplateCacheStatistics statistics;
+    statistics.hits = m_hits.load(std::memory_order_relaxed);
+    statistics.misses = m_misses.load(std::memory_order_relaxed);
+    statistics.evictions = m_evictions.load(std::memory_order_relaxed);
+
+    for(uint32_t i = 0; i < NUMBER_OF_SHARDS; i++)
+    {
+        m_shards[i].lock.lock();
+        statistics.numberOfEntries += m_shards[i].entries.size();
+        statistics.numberOfBytes += m_shards[i].numberOfBytes;
+        m_shards[i].lock.unlock();
+    }
+
+    return statistics;
+}
+
+/**
+ * @brief remove an entry from a shard. The lock of the shard must be held by the caller.
+ *
+ * @param shard shard, which contains the entry
+ * @param entry iterator to the entry within the shard
+ */
+void
+Jinja2TemplateCache::removeEntry(CacheShard &shard,
+                                 std::list<CacheEntry>::iterator entry)
+{
+    shard.numberOfBytes -= entry->templateString.size();
+    shard.index.erase(entry->hash);
+    shard.entries.erase(entry);
+}
+
+/**
+ * @brief remove the least recently used entries of a shard until the limits are fulfilled.
+ *        The lock of the shard must be held by the caller.
+ *
+ * @param shard shard to check
+ */
+void
+Jinja2TemplateCache::evictEntries(CacheShard &shard)
+{
+    const uint64_t maxEntries = m_maxEntriesPerShard.load(std::memory_order_relaxed);
+    const uint64_t maxBytes = m_maxBytesPerShard.load(std::memory_order_relaxed);
+
+    while(shard.entries.size() > 0
+          && (shard.entries.size() > maxEntries
+              || shard.numberOfBytes > maxBytes))
+    {
+        removeEntry(shard, std::prev(shard.entries.end()));
+        m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
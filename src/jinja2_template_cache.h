@@ -0,0 +1,88 @@
+/**
+ *  @file    jinja2_template_cache.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+ */
+
+#ifndef JINJA2_TEMPLATE_CACHE_H
+#define JINJA2_TEMPLATE_CACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include <libKitsunemimiJinja2/jinja2_converter.h>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Template;
+
+class Jinja2TemplateCache
+{
+public:
+    static const uint64_t DEFAULT_MAX_ENTRIES = 1024;
+    static const uint64_t DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    Jinja2TemplateCache(const uint64_t maxEntries,
+                        const uint64_t maxBytes);
+    ~Jinja2TemplateCache();
+
+    std::shared_ptr<Jinja2Template> get(const std::string &templateString);
+    std::shared_ptr<Jinja2Template> get(const std::string &templateString,
+                                        const uint64_t hash);
+    std::shared_ptr<Jinja2Template> peek(const std::string &templateString);
+    void insert(const std::string &templateString,
+                const std::shared_ptr<Jinja2Template> &compiledTemplate);
+
+    void setLimits(const uint64_t maxEntries,
+                   const uint64_t maxBytes);
+    void clear();
+
+    TemplateCacheStatistics getStatistics();
+
+private:
+    // the cache is split into multiple independent shards, which have their own locks, so
+    // lookups of different templates from different threads don't block each other
+    static const uint32_t NUMBER_OF_SHARDS = 16;
+
+    struct CacheEntry
+    {
+        uint64_t hash = 0;
+        std::string templateString = "";
+        std::shared_ptr<Jinja2Template> compiledTemplate;
+    };
+
+    struct CacheShard
+    {
+        std::mutex lock;
+        // list of entries, ordered from the most recently used to the least recently used
+        std::list<CacheEntry> entries;
+        std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> index;
+        uint64_t numberOfBytes = 0;
+    };
+
+    CacheShard m_shards[NUMBER_OF_SHARDS];
+
+    std::atomic<uint64_t> m_maxEntriesPerShard;
+    std::atomic<uint64_t> m_maxBytesPerShard;
+
+    std::atomic<uint64_t> m_hits;
+    std::atomic<uint64_t> m_misses;
+    std::atomic<uint64_t> m_evictions;
+
+    void removeEntry(CacheShard &shard,
+                     std::list<CacheEntry>::iterator entry);
+    void evictEntries(CacheShard &shard);
+};
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
+
+#endif // JINJA2_TEMPLATE_CACHE_H
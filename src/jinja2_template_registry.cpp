@@ -0,0 +1,312 @@
+/**
+ *  @file    jinja2_template_registry.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_template_registry.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_converter.h>
+
+#include <thread>
+#include <unordered_map>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+struct Jinja2RegistryEntry
+{
+    std::shared_ptr<Jinja2Template> compiledTemplate;
+    uint64_t version = 0;
+};
+
+// snapshots are never modified after they were published
+struct Jinja2RegistrySnapshot
+{
+    std::unordered_map<std::string, Jinja2RegistryEntry> entries;
+};
+
+/**
+ * @brief constructor
+ */
+Jinja2TemplateRegistry::Jinja2TemplateRegistry()
+    : m_snapshot(new Jinja2RegistrySnapshot()),
+      m_epoch(0)
+{
+    m_readers[0].store(0);
+    m_readers[1].store(0);
+}
+
+/**
+ * @brief destructor, all reads have to be finished before
+ */
+Jinja2TemplateRegistry::~Jinja2TemplateRegistry()
+{
+    delete m_snapshot.load();
+}
+
+/**
+ * @brief compile a template and publish it as new version of a name. The old version stays
+ *        active, while the new version is compiled, and also if the compiling failed.
+ *
+ * @param name name of the template
+ * @param templateString jinja2-formated string
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2TemplateRegistry::update(const std::string &name,
+                               const std::string &templateString,
+                               std::string &errorMessage)
+{
+    return update(name, templateString, nullptr, errorMessage);
+}
+
+/**
+ * @brief compile a template with a static context and publish it as new version of a name.
+ *        The old version stays active, while the new version is compiled, and also if the
+ *        compiling failed.
+ *
+ * @param name name of the template
+ * @param templateString jinja2-formated string
+ * @param staticContext data-map with constant values, can be nullptr
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2TemplateRegistry::update(const std::string &name,
+                               const std::string &templateString,
+                               DataMap* staticContext,
+                               std::string &errorMessage)
+{
+    Jinja2Template* compiledTemplate = Jinja2Converter::getInstance()->compile(templateString,
+                                                                            staticContext,
+                                                                            errorMessage);
+    if(compiledTemplate == nullptr) {
+        return false;
+    }
+
+    publish(name, std::shared_ptr<Jinja2Template>(compiledTemplate));
+    return true;
+}
+
+/**
+ * @brief publish an already compiled template as new version of a name
+ *
+ * @param name name of the template
+ * @param compiledTemplate compiled template, which is shared with all renders of this version
+ */
+void
+Jinja2TemplateRegistry::publish(const std::string &name,
+                                const std::shared_ptr<Jinja2Template> &compiledTemplate)
+{
+    std::lock_guard<std::mutex> guard(m_updateLock);
+
+    // only updates replace the snapshot, so it can be read without registration here
+    Jinja2RegistrySnapshot* newSnapshot = new Jinja2RegistrySnapshot(*m_snapshot.load());
+    Jinja2RegistryEntry &entry = newSnapshot->entries[name];
+    entry.compiledTemplate = compiledTemplate;
+    entry.version = m_nextVersion;
+    m_nextVersion++;
+
+    replaceSnapshot(newSnapshot);
+}
+
+/**
+ * @brief remove a template from the registry. Running renders of the template are not affected.
+ *
+ * @param name name of the template
+ *
+ * @return false, if name not found, else true
+ */
+bool
+Jinja2TemplateRegistry::remove(const std::string &name)
+{
+    std::lock_guard<std::mutex> guard(m_updateLock);
+
+    Jinja2RegistrySnapshot* oldSnapshot = m_snapshot.load();
+    if(oldSnapshot->entries.find(name) == oldSnapshot->entries.end()) {
+        return false;
+    }
+
+    Jinja2RegistrySnapshot* newSnapshot = new Jinja2RegistrySnapshot(*oldSnapshot);
+    newSnapshot->entries.erase(name);
+    replaceSnapshot(newSnapshot);
+
+    return true;
+}
+
+/**
+ * @brief get the current version of a template. The template stays valid, as long as the
+ *        returned pointer exist, even if it is replaced or removed in the meantime.
+ *
+ * @param name name of the template
+ *
+ * @return pointer to the compiled template, if found, else nullptr
+ */
+std::shared_ptr<Jinja2Template>
+Jinja2TemplateRegistry::get(const std::string &name) const
+{
+    std::shared_ptr<Jinja2Template> result;
+
+    const uint64_t epoch = beginRead();
+    const Jinja2RegistrySnapshot* snapshot = m_snapshot.load();
+    const auto it = snapshot->entries.find(name);
+    if(it != snapshot->entries.end()) {
+        result = it->second.compiledTemplate;
+    }
+    endRead(epoch);
+
+    return result;
+}
+
+/**
+ * @brief get the version of the current template of a name. Each update and publish gets a new
+ *        version, which is greater than all versions before.
+ *
+ * @param name name of the template
+ *
+ * @return version of the template, or 0, if name not found
+ */
+uint64_t
+Jinja2TemplateRegistry::getVersion(const std::string &name) const
+{
+    uint64_t result = 0;
+
+    const uint64_t epoch = beginRead();
+    const Jinja2RegistrySnapshot* snapshot = m_snapshot.load();
+    const auto it = snapshot->entries.find(name);
+    if(it != snapshot->entries.end()) {
+        result = it->second.version;
+    }
+    endRead(epoch);
+
+    return result;
+}
+
+/**
+ * @brief get number of templates within the registry
+ *
+ * @return number of templates
+ */
+uint64_t
+Jinja2TemplateRegistry::getNumberOfTemplates() const
+{
+    const uint64_t epoch = beginRead();
+    const uint64_t result = m_snapshot.load()->entries.size();
+    endRead(epoch);
+
+    return result;
+}
+
+/**
+ * @brief get names of all templates within the registry
+ *
+ * @return list of names
+ */
+const std::vector<std::string>
+Jinja2TemplateRegistry::getNames() const
+{
+    std::vector<std::string> result;
+
+    const uint64_t epoch = beginRead();
+    const Jinja2RegistrySnapshot* snapshot = m_snapshot.load();
+    result.reserve(snapshot->entries.size());
+    for(const auto &entry : snapshot->entries) {
+        result.push_back(entry.first);
+    }
+    endRead(epoch);
+
+    return result;
+}
+
+/**
+ * @brief render the current version of a template
+ *
+ * @param name name of the template
+ * @param input data-object with the information, which should be filled in the jinja2-template
+ * @param result reference for the output-string
+ * @param errorMessage reference for error-message output
+ *
+ * @return true, if successful, else false
+ */
+bool
+Jinja2TemplateRegistry::render(const std::string &name,
+                               DataMap* input,
+                               std::string &result,
+                               std::string &errorMessage) const
+{
+    // the version is kept by the pointer, so the render doesn't delay updates
+    const std::shared_ptr<Jinja2Template> compiledTemplate = get(name);
+    if(compiledTemplate == nullptr)
+    {
+        errorMessage = "template '" + name + "' not found in registry";
+        return false;
+    }
+
+    return compiledTemplate->render(input, result, errorMessage);
+}
+
+/**
+ * @brief register a reader at the counter of the current epoch. Never blocks, it only retries,
+ *        if an update has started a new epoch in the meantime.
+ *
+ * @return epoch, where the reader is registered
+ */
+uint64_t
+Jinja2TemplateRegistry::beginRead() const
+{
+    while(true)
+    {
+        const uint64_t epoch = m_epoch.load();
+        m_readers[epoch & 1].fetch_add(1);
+
+        // an update, which has not seen the registration, has not seen the snapshot either
+        if(m_epoch.load() == epoch) {
+            return epoch;
+        }
+
+        m_readers[epoch & 1].fetch_sub(1);
+    }
+}
+
+/**
+ * @brief unregister a reader
+ *
+ * @param epoch epoch, which was returned by beginRead
+ */
+void
+Jinja2TemplateRegistry::endRead(const uint64_t epoch) const
+{
+    m_readers[epoch & 1].fetch_sub(1);
+}
+
+/**
+ * @brief publish a new snapshot and delete the old one, when no reader can use it anymore.
+ *        Must be called with the update-lock.
+ *
+ * @param newSnapshot new snapshot
+ */
+void
+Jinja2TemplateRegistry::replaceSnapshot(Jinja2RegistrySnapshot* newSnapshot)
+{
+    Jinja2RegistrySnapshot* oldSnapshot = m_snapshot.exchange(newSnapshot);
+
+    // readers of the new epoch can only see the new snapshot, so only the readers of the old
+    // epoch have to be finished. They only look up a name, so this takes not long.
+    const uint64_t oldEpoch = m_epoch.fetch_add(1);
+    while(m_readers[oldEpoch & 1].load() != 0) {
+        std::this_thread::yield();
+    }
+
+    delete oldSnapshot;
+}
+
+}  // namespace Jinja2
+}  // namespace Kitsunemimi
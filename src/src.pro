@@ -22,12 +22,42 @@ INCLUDEPATH += $$PWD \
 SOURCES += \
     jinja2_parsing/jinja2_parser_interface.cpp \
     jinja2_converter.cpp \
-    jinja2_items.cpp
+    jinja2_items.cpp \
+    jinja2_template.cpp \
+    jinja2_template_cache.cpp \
+    jinja2_compiler.cpp \
+    jinja2_sink.cpp \
+    jinja2_template_bundle.cpp \
+    jinja2_template_registry.cpp \
+    jinja2_prepared_context.cpp \
+    jinja2_parallel.cpp \
+    jinja2_generated.cpp \
+    jinja2_code_generator.cpp
 
 HEADERS += \
     ../include/libKitsunemimiJinja2/jinja2_converter.h \
+    ../include/libKitsunemimiJinja2/jinja2_template.h \
+    ../include/libKitsunemimiJinja2/jinja2_sink.h \
+    ../include/libKitsunemimiJinja2/jinja2_template_bundle.h \
+    ../include/libKitsunemimiJinja2/jinja2_template_registry.h \
+    ../include/libKitsunemimiJinja2/jinja2_prepared_context.h \
+    ../include/libKitsunemimiJinja2/jinja2_generated.h \
     jinja2_parsing/jinja2_parser_interface.h \
-    jinja2_items.h
+    jinja2_parsing/jinja2_text_scanner.h \
+    jinja2_items.h \
+    jinja2_hash.h \
+    jinja2_template_cache.h \
+    jinja2_bytecode.h \
+    jinja2_compiler.h \
+    jinja2_arena.h \
+    jinja2_output.h \
+    jinja2_parallel.h \
+    jinja2_condition.h \
+    jinja2_profiler.h \
+    jinja2_dependencies.h \
+    jinja2_splice_list.h \
+    jinja2_context_index.h \
+    jinja2_code_generator.h
 
 FLEXSOURCES = grammar/jinja2_lexer.l
 BISONSOURCES = grammar/jinja2_parser.y
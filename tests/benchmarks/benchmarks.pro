@@ -0,0 +1,29 @@
+include(../../defaults.pri)
+
+QT -= qt core gui
+
+CONFIG   -= app_bundle
+CONFIG += c++14 console
+
+LIBS += -L../../src -lKitsunemimiJinja2
+INCLUDEPATH += $$PWD
+
+LIBS += -L../../../libKitsunemimiJson/src -lKitsunemimiJson
+LIBS += -L../../../libKitsunemimiJson/src/debug -lKitsunemimiJson
+LIBS += -L../../../libKitsunemimiJson/src/release -lKitsunemimiJson
+INCLUDEPATH += ../../../libKitsunemimiJson/include
+
+LIBS += -L../../../libKitsunemimiCommon/src -lKitsunemimiCommon
+LIBS += -L../../../libKitsunemimiCommon/src/debug -lKitsunemimiCommon
+LIBS += -L../../../libKitsunemimiCommon/src/release -lKitsunemimiCommon
+INCLUDEPATH += ../../../libKitsunemimiCommon/include
+
+LIBS += -lpthread
+
+SOURCES += \
+        main.cpp \
+    libKitsunemimiJinja2/jinja2_converter_benchmark.cpp
+
+HEADERS += \
+    libKitsunemimiJinja2/allocation_counter.h \
+    libKitsunemimiJinja2/jinja2_converter_benchmark.h
@@ -0,0 +1,26 @@
+/**
+ *  @file    allocation_counter.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <stdint.h>
+#include <atomic>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// number of calls of the global operator new of the benchmark-binary, which is counted in main.cpp
+extern std::atomic<uint64_t> g_numberOfAllocations;
+
+}
+}
+
+#endif // ALLOCATION_COUNTER_H
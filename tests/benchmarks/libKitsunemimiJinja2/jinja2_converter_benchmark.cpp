@@ -0,0 +1,378 @@
+/**
+ *  @file    jinja2_converter_benchmark.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include "jinja2_converter_benchmark.h"
+#include "allocation_counter.h"
+
+#include <libKitsunemimiJinja2/jinja2_converter.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_prepared_context.h>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+#include <libKitsunemimiJson/json_item.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+// each benchmark runs at least this time
+const double MIN_DURATION_NS = 500.0 * 1000.0 * 1000.0;
+
+/**
+ * @brief Jinja2Converter_Benchmark::Jinja2Converter_Benchmark
+ */
+Jinja2Converter_Benchmark::Jinja2Converter_Benchmark()
+{
+    initBenchmark();
+
+    parse_Benchmark();
+    textHeavy_Benchmark();
+    substitutionHeavy_Benchmark();
+    deepNesting_Benchmark();
+    bigLoop_Benchmark();
+    concurrentConvert_Benchmark();
+    sharedContext_Benchmark();
+
+    cleanupBenchmark();
+}
+
+/**
+ * @brief initBenchmark
+ */
+void
+Jinja2Converter_Benchmark::initBenchmark()
+{
+    m_converter = Kitsunemimi::Jinja2::Jinja2Converter::getInstance();
+
+    printf("%-28s %10s %14s %12s %14s\n",
+           "benchmark", "ops", "ns/op", "MB/s", "allocs/op");
+}
+
+/**
+ * @brief parse and compile a template with text, replacements, conditions and loops
+ */
+void
+Jinja2Converter_Benchmark::parse_Benchmark()
+{
+    std::string templateString = "";
+    for(uint32_t i = 0; i < 1000; i++)
+    {
+        templateString += "some text {{ item.sub_item }} "
+                          "{% if item2 > 40 %}yes{% else %}no{% endif %}"
+                          "{% for x in loop %}{{ x.x }}{% endfor %}\n";
+    }
+
+    measure("parse", [&]()
+    {
+        std::string errorMessage = "";
+        Jinja2Template* compiledTemplate = m_converter->compile(templateString, errorMessage);
+        delete compiledTemplate;
+        return templateString.size();
+    });
+}
+
+/**
+ * @brief render a template with much literal text and only a few replacements
+ */
+void
+Jinja2Converter_Benchmark::textHeavy_Benchmark()
+{
+    std::string templateString = "";
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        templateString += std::string(1000, 'a');
+        templateString += "{{ value }}";
+    }
+
+    runRenderBenchmark("render text-heavy", templateString, "{\"value\": \"test\"}");
+}
+
+/**
+ * @brief render a template, which consists only of replacements
+ */
+void
+Jinja2Converter_Benchmark::substitutionHeavy_Benchmark()
+{
+    std::string templateString = "";
+    for(uint32_t i = 0; i < 10000; i++) {
+        templateString += "{{ item.sub_item }}{{ number }} ";
+    }
+
+    runRenderBenchmark("render substitution-heavy",
+                       templateString,
+                       "{\"item\": {\"sub_item\": \"test_value\"}, \"number\": 42}");
+}
+
+/**
+ * @brief render a template with the maximum nesting-depth
+ */
+void
+Jinja2Converter_Benchmark::deepNesting_Benchmark()
+{
+    const uint32_t depth = Jinja2Template::MAX_NESTING_DEPTH;
+
+    std::string templateString = "";
+    for(uint32_t i = 0; i < depth; i++) {
+        templateString += "{% if flag %}x";
+    }
+    for(uint32_t i = 0; i < depth; i++) {
+        templateString += "{% endif %}";
+    }
+
+    runRenderBenchmark("render deep nesting", templateString, "{\"flag\": true}");
+}
+
+/**
+ * @brief render a loop with 100000 iterations
+ */
+void
+Jinja2Converter_Benchmark::bigLoop_Benchmark()
+{
+    std::string jsonInput = "{\"loop\": [";
+    for(uint32_t i = 0; i < 100000; i++)
+    {
+        if(i != 0) {
+            jsonInput += ",";
+        }
+        jsonInput += "{\"name\": \"element\", \"id\": " + std::to_string(i) + "}";
+    }
+    jsonInput += "]}";
+
+    runRenderBenchmark("render 100k loop",
+                       "{% for x in loop %}"
+                       "{% if x.id > 10 %}{{ x.name }}-{{ x.id }}\n{% endif %}"
+                       "{% endfor %}",
+                       jsonInput);
+}
+
+/**
+ * @brief convert from multiple threads at the same time over the template-cache
+ */
+void
+Jinja2Converter_Benchmark::concurrentConvert_Benchmark()
+{
+    const std::string templateString = "this is {% for x in loop %} a {{ x.x }}{% endfor %}";
+    const std::string jsonInput = "{\"loop\": [{\"x\": \"test1\"},"
+                                  " {\"x\": \"test2\"},"
+                                  " {\"x\": \"test3\"}]}";
+
+    uint64_t numberOfThreads = std::thread::hardware_concurrency();
+    if(numberOfThreads == 0) {
+        numberOfThreads = 1;
+    }
+
+    Json::JsonItem input;
+    std::string errorMessage = "";
+    input.parse(jsonInput, errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    measure("concurrent convert x" + std::to_string(numberOfThreads), [&]()
+    {
+        std::string output = "";
+        m_converter->convert(output, templateString, inputMap, errorMessage);
+        return output.size();
+    },
+    numberOfThreads);
+}
+
+/**
+ * @brief render 200 different templates against the same big input, once with a search
+ *        within the input and once with a prepared context, which is created for each run
+ */
+void
+Jinja2Converter_Benchmark::sharedContext_Benchmark()
+{
+    // input with 20 sections, 20 groups and 5 values each
+    std::string jsonInput = "{";
+    for(uint32_t s = 0; s < 20; s++)
+    {
+        jsonInput += std::string(s == 0 ? "" : ",") + "\"section" + std::to_string(s) + "\": {";
+        for(uint32_t g = 0; g < 20; g++)
+        {
+            jsonInput += std::string(g == 0 ? "" : ",") + "\"group" + std::to_string(g) + "\": {";
+            for(uint32_t v = 0; v < 5; v++)
+            {
+                jsonInput += std::string(v == 0 ? "" : ",")
+                             + "\"value" + std::to_string(v) + "\": \"text\"";
+            }
+            jsonInput += "}";
+        }
+        jsonInput += "}";
+    }
+    jsonInput += "}";
+
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse(jsonInput, errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    std::vector<Jinja2Template*> templates;
+    for(uint32_t t = 0; t < 200; t++)
+    {
+        std::string templateString = "";
+        for(uint32_t i = 0; i < 50; i++)
+        {
+            const uint32_t n = t * 50 + i;
+            templateString += "{{ section" + std::to_string(n % 20)
+                              + ".group" + std::to_string((n / 20) % 20)
+                              + ".value" + std::to_string(n % 5) + " }} ";
+        }
+
+        Jinja2Template* compiledTemplate = m_converter->compile(templateString, errorMessage);
+        if(compiledTemplate == nullptr)
+        {
+            printf("%-28s failed: %s\n", "render 200 templates", errorMessage.c_str());
+            return;
+        }
+        templates.push_back(compiledTemplate);
+    }
+
+    measure("render 200 templates", [&]()
+    {
+        uint64_t size = 0;
+        for(Jinja2Template* compiledTemplate : templates)
+        {
+            std::string output = "";
+            compiledTemplate->render(inputMap, output, errorMessage);
+            size += output.size();
+        }
+        return size;
+    });
+
+    measure("render 200 prepared", [&]()
+    {
+        const Jinja2PreparedContext context(inputMap);
+        uint64_t size = 0;
+        for(Jinja2Template* compiledTemplate : templates)
+        {
+            std::string output = "";
+            compiledTemplate->render(context, output, errorMessage);
+            size += output.size();
+        }
+        return size;
+    });
+
+    for(Jinja2Template* compiledTemplate : templates) {
+        delete compiledTemplate;
+    }
+}
+
+/**
+ * @brief cleanupBenchmark
+ */
+void
+Jinja2Converter_Benchmark::cleanupBenchmark()
+{
+    delete m_converter;
+}
+
+/**
+ * @brief measure the render of a compiled template
+ *
+ * @param name name of the benchmark
+ * @param templateString template to render
+ * @param jsonInput input for the template
+ */
+void
+Jinja2Converter_Benchmark::runRenderBenchmark(const std::string &name,
+                                              const std::string &templateString,
+                                              const std::string &jsonInput)
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile(templateString, errorMessage);
+    if(compiledTemplate == nullptr)
+    {
+        printf("%-28s failed: %s\n", name.c_str(), errorMessage.c_str());
+        return;
+    }
+
+    Json::JsonItem input;
+    input.parse(jsonInput, errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    measure(name, [&]()
+    {
+        std::string output = "";
+        compiledTemplate->render(inputMap, output, errorMessage);
+        return output.size();
+    });
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief run an operation until the minimum duration is reached and print the results
+ *
+ * @param name name of the benchmark
+ * @param operation operation to measure, which returns the number of processed bytes
+ * @param numberOfThreads number of threads, which run the operation at the same time
+ */
+void
+Jinja2Converter_Benchmark::measure(const std::string &name,
+                                   const std::function<uint64_t()> &operation,
+                                   const uint64_t numberOfThreads)
+{
+    // warm up the caches
+    operation();
+
+    std::vector<uint64_t> numberOfOps(numberOfThreads, 0);
+    std::vector<uint64_t> numberOfBytes(numberOfThreads, 0);
+
+    const uint64_t startAllocations = g_numberOfAllocations.load();
+    const auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&](const uint64_t threadId)
+    {
+        double duration = 0.0;
+        while(duration < MIN_DURATION_NS)
+        {
+            numberOfBytes[threadId] += operation();
+            numberOfOps[threadId]++;
+
+            const auto now = std::chrono::steady_clock::now();
+            duration = std::chrono::duration<double, std::nano>(now - start).count();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(uint64_t i = 1; i < numberOfThreads; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const double duration = std::chrono::duration<double, std::nano>(end - start).count();
+    const uint64_t allocations = g_numberOfAllocations.load() - startAllocations;
+
+    uint64_t totalOps = 0;
+    uint64_t totalBytes = 0;
+    for(uint64_t i = 0; i < numberOfThreads; i++)
+    {
+        totalOps += numberOfOps[i];
+        totalBytes += numberOfBytes[i];
+    }
+
+    // ns/op is the wall-clock time divided by all operations of all threads
+    printf("%-28s %10lu %14.1f %12.1f %14.1f\n",
+           name.c_str(),
+           static_cast<unsigned long>(totalOps),
+           duration / static_cast<double>(totalOps),
+           (static_cast<double>(totalBytes) / (1024.0 * 1024.0)) / (duration / 1.0e9),
+           static_cast<double>(allocations) / static_cast<double>(totalOps));
+}
+
+}
+}
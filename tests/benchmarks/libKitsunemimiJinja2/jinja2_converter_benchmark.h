@@ -0,0 +1,59 @@
+/**
+ *  @file    jinja2_converter_benchmark.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#ifndef JINJA2CONVERTER_BENCHMARK_H
+#define JINJA2CONVERTER_BENCHMARK_H
+
+#include <stdint.h>
+#include <string>
+#include <functional>
+
+namespace Kitsunemimi
+{
+namespace Json
+{
+class JsonItem;
+}
+
+namespace Jinja2
+{
+class Jinja2Converter;
+class Jinja2Template;
+
+class Jinja2Converter_Benchmark
+{
+public:
+    Jinja2Converter_Benchmark();
+
+private:
+    Kitsunemimi::Jinja2::Jinja2Converter* m_converter = nullptr;
+
+    void initBenchmark();
+
+    void parse_Benchmark();
+    void textHeavy_Benchmark();
+    void substitutionHeavy_Benchmark();
+    void deepNesting_Benchmark();
+    void bigLoop_Benchmark();
+    void concurrentConvert_Benchmark();
+    void sharedContext_Benchmark();
+
+    void cleanupBenchmark();
+
+    void runRenderBenchmark(const std::string &name,
+                            const std::string &templateString,
+                            const std::string &jsonInput);
+    void measure(const std::string &name,
+                 const std::function<uint64_t()> &operation,
+                 const uint64_t numberOfThreads = 1);
+};
+
+}
+}
+
+#endif // JINJA2CONVERTER_BENCHMARK_H
@@ -0,0 +1,46 @@
+/**
+ *  @file    main.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_converter_benchmark.h>
+#include <libKitsunemimiJinja2/allocation_counter.h>
+
+#include <cstdlib>
+#include <new>
+
+std::atomic<uint64_t> Kitsunemimi::Jinja2::g_numberOfAllocations(0);
+
+// count all allocations of the library and the benchmarks
+void*
+operator new(size_t size)
+{
+    Kitsunemimi::Jinja2::g_numberOfAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if(ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+int main()
+{
+    Kitsunemimi::Jinja2::Jinja2Converter_Benchmark converterBenchmark;
+}
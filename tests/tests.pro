@@ -4,6 +4,7 @@ QT -= qt core gui
 CONFIG += c++14
 
 SUBDIRS = \
-    unit_tests
+    unit_tests \
+    benchmarks
 
 tests.depends = src
@@ -8,9 +8,15 @@
 
 #include "jinja2_converter_test.h"
 #include <libKitsunemimiJinja2/jinja2_converter.h>
+#include <libKitsunemimiJinja2/jinja2_generated.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
 #include <libKitsunemimiCommon/common_items/data_items.h>
 #include <libKitsunemimiJson/json_item.h>
 
+#include <thread>
+#include <atomic>
+#include <map>
+
 namespace Kitsunemimi
 {
 namespace Jinja2
@@ -25,13 +31,24 @@ Jinja2Converter_Test::Jinja2Converter_Test()
     initTestCase();
 
     plainText_Test();
+    emptyTemplate_Test();
     replace_Test();
+    replaceValueTypes_Test();
     ifCondition_Test();
+    compareTypes_Test();
     forLoop_Test();
+    nestedControlFlow_Test();
+    parsedJsonInput_Test();
+    textScanning_Test();
 
     parserFail_Test();
     converterFail_Test();
 
+    parallelConvert_Test();
+    templateCache_Test();
+    generatedTemplate_Test();
+    include_Test();
+
     cleanupTestCase();
 }
 
@@ -68,6 +85,46 @@ Jinja2Converter_Test::plainText_Test()
 
     TEST_EQUAL(result, true);
     TEST_EQUAL(output, testString);
+
+    // keywords, numbers and single brackets outside of expressions are normal text
+    std::string testString2("for x in {y} if is [ 42 ]\n  else  endif endfor . }}");
+    output.clear();
+    result = m_converter->convert(output,
+                                  testString2,
+                                  m_testJsonString,
+                                  errorMessage);
+
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, testString2);
+}
+
+/**
+ * @brief emptyTemplate_Test
+ */
+void
+Jinja2Converter_Test::emptyTemplate_Test()
+{
+    std::string errorMessage = "";
+    std::string output = "";
+    TEST_EQUAL(m_converter->convert(output, "", m_testJsonString, errorMessage), true);
+    TEST_EQUAL(output, std::string(""));
+
+    Jinja2Template* compiledTemplate = m_converter->compile("", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        Json::JsonItem input;
+        input.parse("{}", errorMessage);
+        output = "prefix";
+        TEST_EQUAL(compiledTemplate->render(input.getItemContent()->toMap(),
+                                            output,
+                                            errorMessage), true);
+        TEST_EQUAL(output, std::string("prefix"));
+        delete compiledTemplate;
+    }
+
+    std::string code = "";
+    TEST_EQUAL(m_converter->generateCode({""}, {"renderEmpty"}, code, errorMessage), true);
 }
 
 /**
@@ -88,6 +145,30 @@ Jinja2Converter_Test::replace_Test()
     TEST_EQUAL(output, std::string("this is \n a test_value"));
 }
 
+/**
+ * @brief replaceValueTypes_Test
+ */
+void
+Jinja2Converter_Test::replaceValueTypes_Test()
+{
+    std::string testString("{{ int }}|{{ negative }}|{{ zero }}|{{ float }}|{{ bool }}|{{ str }}");
+    std::string jsonString("{\"int\": 1234567890,"
+                           " \"negative\": -42,"
+                           " \"zero\": 0,"
+                           " \"float\": 1.5,"
+                           " \"bool\": true,"
+                           " \"str\": \"text\"}");
+    std::string errorMessage = "";
+    std::string output = "";
+    bool result = m_converter->convert(output,
+                                       testString,
+                                       jsonString,
+                                       errorMessage);
+
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, std::string("1234567890|-42|0|1.500000|true|text"));
+}
+
 /**
  * @brief ifCondition_Test
  */
@@ -126,6 +207,59 @@ Jinja2Converter_Test::ifCondition_Test()
     TEST_EQUAL(output, std::string("this is "));
 }
 
+/**
+ * @brief compareTypes_Test
+ */
+void
+Jinja2Converter_Test::compareTypes_Test()
+{
+    std::string jsonString("{\"int\": 42,"
+                           " \"float\": 1.5,"
+                           " \"bool\": true,"
+                           " \"str\": \"abc\","
+                           " \"num_str\": \"42\"}");
+
+    // pairs of template and expected output
+    const std::vector<std::pair<std::string, std::string>> testCases = {
+        {"{% if int is 42 %}x{% endif %}", "x"},
+        {"{% if int == 42 %}x{% endif %}", "x"},
+        {"{% if int != 42 %}x{% else %}y{% endif %}", "y"},
+        {"{% if int > 41 %}x{% endif %}", "x"},
+        {"{% if int > 42 %}x{% else %}y{% endif %}", "y"},
+        {"{% if int >= 42 %}x{% endif %}", "x"},
+        {"{% if int < 100 %}x{% endif %}", "x"},
+        {"{% if int <= 41 %}x{% else %}y{% endif %}", "y"},
+        {"{% if int < -1 %}x{% else %}y{% endif %}", "y"},
+        {"{% if float > 1 %}x{% endif %}", "x"},
+        {"{% if float < 2 %}x{% endif %}", "x"},
+        {"{% if bool is true %}x{% endif %}", "x"},
+        {"{% if bool is false %}x{% else %}y{% endif %}", "y"},
+        {"{% if bool %}x{% endif %}", "x"},
+        {"{% if str is abc %}x{% endif %}", "x"},
+        {"{% if str != abd %}x{% endif %}", "x"},
+        {"{% if str < abd %}x{% endif %}", "x"},
+        {"{% if num_str is 42 %}x{% endif %}", "x"},
+        {"{% if str %}x{% else %}y{% endif %}", "y"},
+        // values with different types are not equal and can not be ordered
+        {"{% if int is abc %}x{% else %}y{% endif %}", "y"},
+        {"{% if int != abc %}x{% endif %}", "x"},
+        {"{% if str > 1 %}x{% else %}y{% endif %}", "y"},
+    };
+
+    for(const std::pair<std::string, std::string> &testCase : testCases)
+    {
+        std::string errorMessage = "";
+        std::string output = "";
+        bool result = m_converter->convert(output,
+                                           testCase.first,
+                                           jsonString,
+                                           errorMessage);
+
+        TEST_EQUAL(result, true);
+        TEST_EQUAL(output, testCase.second);
+    }
+}
+
 /**
  * @brief forLoop_Test
  */
@@ -149,6 +283,111 @@ Jinja2Converter_Test::forLoop_Test()
     TEST_EQUAL(output, std::string("this is a test1 a test2 a test3"));
 }
 
+/**
+ * @brief nestedControlFlow_Test
+ */
+void
+Jinja2Converter_Test::nestedControlFlow_Test()
+{
+    const std::string jsonString("{\"flag\": \"x\","
+                                 " \"empty\": [],"
+                                 " \"rows\": [ {\"name\": \"a\", \"cols\": [1, 2], \"on\": true},"
+                                 "           {\"name\": \"b\", \"cols\": [3], \"on\": false} ]}");
+    const std::string testString("{% for row in rows %}"
+                                 "[{{ row.name }}:"
+                                 "{% for col in row.cols %}<{{ col }}>{% endfor %}"
+                                 "{% if row.on %}on{% else %}off{% endif %}]"
+                                 "{% endfor %}"
+                                 "{% for e in empty %}never{% endfor %}"
+                                 "{% if flag is y %}y{% else %}{% if flag is x %}x{% endif %}{% endif %}"
+                                 "!");
+    std::string errorMessage = "";
+    std::string output = "";
+    bool result = m_converter->convert(output,
+                                       testString,
+                                       jsonString,
+                                       errorMessage);
+
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, std::string("[a:<1><2>on][b:<3>off]x!"));
+}
+
+/**
+ * @brief parsedJsonInput_Test
+ */
+void
+Jinja2Converter_Test::parsedJsonInput_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    TEST_EQUAL(input.parse(m_testJsonString, errorMessage), true);
+
+    // one parsed input for multiple templates
+    std::string output = "";
+    TEST_EQUAL(m_converter->convert(output, "{{ item.sub_item }}", input, errorMessage), true);
+    TEST_EQUAL(output, std::string("test_value"));
+
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output,
+                                    "{% for x in loop %}{{ x.x }}{% endfor %}",
+                                    input,
+                                    errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("test1test2test3"));
+
+    // input must be a json-object
+    Json::JsonItem arrayInput;
+    TEST_EQUAL(arrayInput.parse("[1, 2]", errorMessage), true);
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output, "{{ item }}", arrayInput, errorMessage), false);
+}
+
+/**
+ * @brief textScanning_Test
+ */
+void
+Jinja2Converter_Test::textScanning_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse(m_testJsonString, errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    // delimiters at all positions of the vectors of the text-scanner and single brackets, which
+    // are not a delimiter, directly in front of them
+    bool success = true;
+    for(uint32_t i = 0; i < 100; i++)
+    {
+        const std::string text(i, 'a');
+        std::string output = "";
+
+        const bool result = m_converter->convert(output,
+                                                 text + "{a{{ item2 }}{b" + text + "{% if item2 is 42 %}x{% endif %}{",
+                                                 inputMap,
+                                                 errorMessage);
+        if(result == false
+                || output != text + "{a42{b" + text + "x{")
+        {
+            success = false;
+        }
+    }
+    TEST_EQUAL(success, true);
+
+    // end-delimiters after long expressions
+    std::string output = "";
+    std::string spaces(70, ' ');
+    TEST_EQUAL(m_converter->convert(output,
+                                    "{{" + spaces + "item2" + spaces + "}}%}",
+                                    inputMap,
+                                    errorMessage), true);
+    TEST_EQUAL(output, std::string("42%}"));
+
+    // unterminated expressions
+    output = "";
+    TEST_EQUAL(m_converter->convert(output, "text {{ item2 ", inputMap, errorMessage), false);
+    TEST_EQUAL(m_converter->convert(output, "text {%", inputMap, errorMessage), false);
+}
+
 /**
  * @brief parserFail_Test
  */
@@ -168,6 +407,20 @@ Jinja2Converter_Test::parserFail_Test()
                                        errorMessage);
 
     TEST_EQUAL(result, false);
+
+    // line and column of the error are calculated from the position within the template
+    std::string testString2("line 1\n"
+                            "line 2 {{ item.sub_item }}\n"
+                            "line 3 {% if item2 ist something %}a{% endif %}");
+    result = m_converter->convert(output,
+                                  testString2,
+                                  m_testJsonString,
+                                  errorMessage);
+
+    TEST_EQUAL(result, false);
+    TEST_NOT_EQUAL(errorMessage.find("line-number: 3 \n"), std::string::npos);
+    TEST_NOT_EQUAL(errorMessage.find("position in line: 20 \n"), std::string::npos);
+    TEST_NOT_EQUAL(errorMessage.find("broken part in template: \"ist\""), std::string::npos);
 }
 
 /**
@@ -187,6 +440,330 @@ Jinja2Converter_Test::converterFail_Test()
     TEST_EQUAL(result, false);
 }
 
+/**
+ * @brief parallelConvert_Test
+ */
+void
+Jinja2Converter_Test::parallelConvert_Test()
+{
+    const uint32_t numberOfThreads = 8;
+    std::vector<std::thread*> threads;
+    std::vector<std::string> outputs(numberOfThreads);
+    std::vector<uint8_t> results(numberOfThreads, 0);
+
+    std::string testString("this is"
+                           "{% for value in loop %}"
+                           " a "
+                           "{{ value.x }}"
+                           "{% endfor %}");
+
+    for(uint32_t i = 0; i < numberOfThreads; i++)
+    {
+        threads.push_back(new std::thread([&, i]()
+        {
+            std::string errorMessage = "";
+            bool result = true;
+            for(uint32_t j = 0; j < 100; j++)
+            {
+                outputs[i].clear();
+                result = result && m_converter->convert(outputs[i],
+                                                        testString,
+                                                        m_testJsonString,
+                                                        errorMessage);
+            }
+            results[i] = result ? 1 : 0;
+        }));
+    }
+
+    for(uint32_t i = 0; i < numberOfThreads; i++)
+    {
+        threads[i]->join();
+        delete threads[i];
+
+        TEST_EQUAL(results[i], 1);
+        TEST_EQUAL(outputs[i], std::string("this is a test1 a test2 a test3"));
+    }
+}
+
+/**
+ * @brief templateCache_Test
+ */
+void
+Jinja2Converter_Test::templateCache_Test()
+{
+    std::string testString("this is a {{ item.sub_item }}");
+    std::string errorMessage = "";
+    std::string output = "";
+
+    m_converter->clearCache();
+    TemplateCacheStatistics before = m_converter->getCacheStatistics();
+    TEST_EQUAL(before.numberOfEntries, 0);
+
+    // first convert compiles the template, second one reuse it
+    m_converter->convert(output, testString, m_testJsonString, errorMessage);
+    output.clear();
+    bool result = m_converter->convert(output, testString, m_testJsonString, errorMessage);
+
+    TemplateCacheStatistics after = m_converter->getCacheStatistics();
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, std::string("this is a test_value"));
+    TEST_EQUAL(after.numberOfEntries, 1);
+    TEST_EQUAL(after.numberOfBytes, testString.size());
+    TEST_EQUAL(after.misses - before.misses, 1);
+    TEST_EQUAL(after.hits - before.hits, 1);
+
+    // reading the profile of a cached template doesn't change the statistics
+    TemplateProfile profile;
+    TEST_EQUAL(m_converter->getProfile(profile, testString), true);
+    TEST_EQUAL(m_converter->getProfile(profile, "not cached"), false);
+    before = after;
+    after = m_converter->getCacheStatistics();
+    TEST_EQUAL(after.hits, before.hits);
+    TEST_EQUAL(after.misses, before.misses);
+
+    // templates with syntax-errors are not cached
+    m_converter->convert(output, "{% if item ist x %}", m_testJsonString, errorMessage);
+    TEST_EQUAL(m_converter->getCacheStatistics().numberOfEntries, 1);
+
+    // fill cache over its limit
+    m_converter->setCacheLimits(1, 1024);
+    for(uint32_t i = 0; i < 64; i++)
+    {
+        output.clear();
+        m_converter->convert(output,
+                             "test " + std::to_string(i) + " {{ item2 }}",
+                             m_testJsonString,
+                             errorMessage);
+        TEST_EQUAL(output, "test " + std::to_string(i) + " 42");
+    }
+
+    after = m_converter->getCacheStatistics();
+    TEST_EQUAL(after.evictions > 0, true);
+    TEST_EQUAL(after.numberOfEntries < 64, true);
+
+    m_converter->setCacheLimits(1024, 64 * 1024 * 1024);
+    m_converter->clearCache();
+}
+
+/**
+ * @brief generated function for the generatedTemplate_Test, which doesn't render the template
+ */
+bool
+generatedTestFunction(DataMap*,
+                      std::string &output,
+                      std::string &)
+{
+    output.append("generated");
+    return true;
+}
+
+/**
+ * @brief generatedTemplate_Test
+ */
+void
+Jinja2Converter_Test::generatedTemplate_Test()
+{
+    const std::string templateString = "this is {{ item.sub_item }}";
+    std::string errorMessage = "";
+    std::string output = "";
+
+    // registered function is used instead of the template
+    TEST_EQUAL(registerGeneratedTemplate(templateString.c_str(),
+                                         templateString.size(),
+                                         &generatedTestFunction), true);
+    TEST_EQUAL(registerGeneratedTemplate(templateString.c_str(),
+                                         templateString.size(),
+                                         &generatedTestFunction), false);
+    TEST_EQUAL(m_converter->convert(output, templateString, m_testJsonString, errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("generated"));
+    TEST_EQUAL(getGeneratedTemplate(templateString), &generatedTestFunction);
+    TEST_EQUAL(getGeneratedTemplate("other {{ item }}"), nullptr);
+
+    // functions can be registered, while other threads search them without a lock
+    std::atomic<bool> lookupsCorrect(true);
+    std::vector<std::thread> threads;
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&]()
+        {
+            for(uint32_t j = 0; j < 1000; j++)
+            {
+                if(getGeneratedTemplate(templateString) != &generatedTestFunction) {
+                    lookupsCorrect.store(false);
+                }
+            }
+        });
+    }
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        const std::string otherString = "other " + std::to_string(i);
+        registerGeneratedTemplate(otherString.c_str(), otherString.size(), &generatedTestFunction);
+        unregisterGeneratedTemplate(otherString);
+    }
+    for(std::thread &thread : threads) {
+        thread.join();
+    }
+    TEST_EQUAL(lookupsCorrect.load(), true);
+
+    // generated functions can not check render-limits, so the template is used with limits
+    RenderLimits limits;
+    limits.maxOutputSize = 4;
+    m_converter->setRenderLimits(limits);
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output, templateString, m_testJsonString, errorMessage),
+               false);
+    TEST_NOT_EQUAL(errorMessage.find("output exceeds the limit of 4 bytes"), std::string::npos);
+    m_converter->setRenderLimits(RenderLimits());
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output, templateString, m_testJsonString, errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("generated"));
+
+    // fallback to the template after removing the function
+    TEST_EQUAL(unregisterGeneratedTemplate(templateString), true);
+    TEST_EQUAL(unregisterGeneratedTemplate(templateString), false);
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output, templateString, m_testJsonString, errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("this is test_value"));
+
+    // generate code
+    std::string code = "";
+    TEST_EQUAL(m_converter->generateCode({templateString, "{% for x in loop %}{{ x.x }}{% endfor %}"},
+                                         {"render_first", "render_second"},
+                                         code,
+                                         errorMessage), true);
+    TEST_NOT_EQUAL(code.find("render_first(Kitsunemimi::DataMap* input,"), std::string::npos);
+    TEST_NOT_EQUAL(code.find("render_second(Kitsunemimi::DataMap* input,"), std::string::npos);
+    TEST_NOT_EQUAL(code.find("registerGeneratedTemplate(T1_TEMPLATE"), std::string::npos);
+
+    // broken templates and missing names
+    TEST_EQUAL(m_converter->generateCode({"{% if item ist something %}"},
+                                         {"render_broken"},
+                                         code,
+                                         errorMessage), false);
+    TEST_EQUAL(m_converter->generateCode({templateString}, {}, code, errorMessage), false);
+}
+
+/**
+ * @brief include_Test
+ */
+void
+Jinja2Converter_Test::include_Test()
+{
+    std::string errorMessage = "";
+    std::string output = "";
+
+    // include without loader
+    TEST_EQUAL(m_converter->convert(output, "{% include \"header\" %}", "{}", errorMessage),
+               false);
+
+    std::map<std::string, std::string> files;
+    files["header"] = "H:{{ title }}|";
+    files["item"] = "({{ x.name }}{% for x in x.tags %}{{ x }}{% endfor %})";
+    files["nested"] = "N{% include \"header\" %}";
+    files["broken"] = "{% if title ist x %}";
+    files["cycle_a"] = "{% include \"cycle_b\" %}";
+    files["cycle_b"] = "{% include \"cycle_a\" %}";
+
+    uint32_t numberOfLoads = 0;
+    m_converter->setIncludeLoader([&](const std::string &name,
+                                      std::string &templateString,
+                                      std::string &loaderError)
+    {
+        numberOfLoads++;
+        auto it = files.find(name);
+        if(it == files.end())
+        {
+            loaderError = "file not found";
+            return false;
+        }
+        templateString = it->second;
+        return true;
+    });
+
+    const std::string input = "{\"title\": \"t\","
+                              " \"list\": [{\"name\": \"a\", \"tags\": [1, 2]},"
+                              "          {\"name\": \"b\", \"tags\": []}]}";
+
+    // loop-variables are forwarded into the included template
+    TEST_EQUAL(m_converter->convert(output,
+                                    "{% include \"header\" %}body"
+                                    "{% for x in list %}{% include \"item\" %}{% endfor %}",
+                                    input,
+                                    errorMessage), true);
+    TEST_EQUAL(output, std::string("H:t|body(a12)(b)"));
+    TEST_EQUAL(numberOfLoads, 2);
+
+    // each included template is loaded and compiled only once
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output, "{% include \"nested\" %}", input, errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("NH:t|"));
+    TEST_EQUAL(numberOfLoads, 3);
+    TEST_EQUAL(m_converter->getNumberOfIncludes(), 3);
+
+    // dependencies of included templates are dependencies of the including template
+    Jinja2Template* compiledTemplate = m_converter->compile("{% for x in list %}"
+                                                            "{% include \"item\" %}"
+                                                            "{% endfor %}"
+                                                            "{% include \"nested\" %}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        const std::vector<std::string> dependencies = compiledTemplate->getDependencies();
+        TEST_EQUAL(dependencies.size(), 2);
+        TEST_EQUAL(compiledTemplate->isAffected({"list.0.tags"}), true);
+        TEST_EQUAL(compiledTemplate->isAffected({"title"}), true);
+        TEST_EQUAL(compiledTemplate->isAffected({"x"}), false);
+
+        // resumable renders can also pause within included templates
+        Json::JsonItem jsonInput;
+        jsonInput.parse(input, errorMessage);
+        Jinja2RenderContinuation continuation;
+        compiledTemplate->beginRender(jsonInput.getItemContent()->toMap(), continuation);
+
+        std::string resumedOutput = "";
+        uint64_t numberOfSteps = 0;
+        while(continuation.isFinished() == false
+              && compiledTemplate->continueRender(continuation, 1, errorMessage))
+        {
+            resumedOutput.append(continuation.getData(), continuation.getSize());
+            continuation.consume(continuation.getSize());
+            numberOfSteps++;
+        }
+        TEST_EQUAL(resumedOutput, std::string("(a12)(b)NH:t|"));
+        TEST_EQUAL(numberOfSteps, 13);
+
+        delete compiledTemplate;
+    }
+
+    // missing, broken and cyclic includes
+    TEST_EQUAL(m_converter->convert(output, "{% include \"unknown\" %}", input, errorMessage),
+               false);
+    TEST_NOT_EQUAL(errorMessage.find("file not found"), std::string::npos);
+    TEST_EQUAL(m_converter->convert(output, "{% include \"broken\" %}", input, errorMessage),
+               false);
+    TEST_NOT_EQUAL(errorMessage.find("within included template 'broken'"), std::string::npos);
+    TEST_EQUAL(m_converter->convert(output, "{% include \"cycle_a\" %}", input, errorMessage),
+               false);
+    TEST_NOT_EQUAL(errorMessage.find("cycle_a -> cycle_b -> cycle_a"), std::string::npos);
+
+    // includes can not be converted into generated code
+    std::string code = "";
+    TEST_EQUAL(m_converter->generateCode({"{% include \"header\" %}"},
+                                         {"render_include"},
+                                         code,
+                                         errorMessage), false);
+
+    m_converter->setIncludeLoader(nullptr);
+    m_converter->clearIncludes();
+    m_converter->clearCache();
+    TEST_EQUAL(m_converter->getNumberOfIncludes(), 0);
+}
+
 /**
  * cleanupTestCase
  */
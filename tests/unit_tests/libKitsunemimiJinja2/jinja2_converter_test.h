@@ -37,13 +37,24 @@ private:
     void initTestCase();
 
     void plainText_Test();
+    void emptyTemplate_Test();
     void replace_Test();
+    void replaceValueTypes_Test();
     void ifCondition_Test();
+    void compareTypes_Test();
     void forLoop_Test();
+    void nestedControlFlow_Test();
+    void parsedJsonInput_Test();
+    void textScanning_Test();
 
     void parserFail_Test();
     void converterFail_Test();
 
+    void parallelConvert_Test();
+    void templateCache_Test();
+    void generatedTemplate_Test();
+    void include_Test();
+
     void cleanupTestCase();
 };
 
@@ -0,0 +1,223 @@
+/**
+ *  @file    jinja2_template_bundle_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include "jinja2_template_bundle_test.h"
+#include <libKitsunemimiJinja2/jinja2_converter.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_template_bundle.h>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+#include <libKitsunemimiJson/json_item.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief Jinja2TemplateBundle_Test::Jinja2TemplateBundle_Test
+ */
+Jinja2TemplateBundle_Test::Jinja2TemplateBundle_Test()
+    : Kitsunemimi::CompareTestHelper("Jinja2TemplateBundle_Test")
+{
+    initTestCase();
+
+    writeAndLoad_Test();
+    brokenFile_Test();
+
+    cleanupTestCase();
+}
+
+/**
+ * @brief initTestCase
+ */
+void
+Jinja2TemplateBundle_Test::initTestCase()
+{
+    m_converter = Kitsunemimi::Jinja2::Jinja2Converter::getInstance();
+    m_filePath = "/tmp/libKitsunemimiJinja2_bundle_test.bundle";
+
+    m_testJsonString = std::string(
+                "{\"item\": "
+                    "{ \"sub_item\": \"test_value\"},"
+                "\"item2\": 42,"
+                "\"loop\": "
+                    "[ {\"x\" :\"test1\" }, {\"x\" :\"test2\" }, {\"x\" :\"test3\" }]"
+                "}");
+
+    // write bundle, which is used by all tests
+    std::string errorMessage = "";
+    std::vector<std::string> names = {"replace", "control_flow"};
+    std::vector<Jinja2Template*> templates;
+    templates.push_back(m_converter->compile("this is a {{ item.sub_item }}", errorMessage));
+    templates.push_back(m_converter->compile("{% if item2 > 40 %}"
+                                             "{% for value in loop %}"
+                                             " a {{ value.x }}"
+                                             "{% endfor %}"
+                                             "{% else %}"
+                                             "nothing"
+                                             "{% endif %}",
+                                             errorMessage));
+
+    TEST_EQUAL(Jinja2TemplateBundle::writeFile(m_filePath, names, templates, errorMessage),
+               true);
+
+    for(Jinja2Template* compiledTemplate : templates) {
+        delete compiledTemplate;
+    }
+}
+
+/**
+ * @brief writeAndLoad_Test
+ */
+void
+Jinja2TemplateBundle_Test::writeAndLoad_Test()
+{
+    std::string errorMessage = "";
+    Jinja2TemplateBundle* bundle = new Jinja2TemplateBundle();
+    TEST_EQUAL(bundle->loadFile(m_filePath, errorMessage), true);
+    TEST_EQUAL(bundle->getNumberOfTemplates(), 2);
+    TEST_EQUAL(bundle->getTemplate("unknown") == nullptr, true);
+
+    Jinja2Template* replaceTemplate = bundle->getTemplate("replace");
+    Jinja2Template* controlFlowTemplate = bundle->getTemplate("control_flow");
+    TEST_NOT_EQUAL(replaceTemplate, nullptr);
+    TEST_NOT_EQUAL(controlFlowTemplate, nullptr);
+    if(replaceTemplate == nullptr
+            || controlFlowTemplate == nullptr)
+    {
+        delete bundle;
+        return;
+    }
+
+    // templates are still valid after the bundle is deleted
+    delete bundle;
+
+    Json::JsonItem input;
+    input.parse(m_testJsonString, errorMessage);
+
+    std::string output = "";
+    TEST_EQUAL(replaceTemplate->render(input.getItemContent()->toMap(), output, errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("this is a test_value"));
+
+    output.clear();
+    TEST_EQUAL(controlFlowTemplate->render(input.getItemContent()->toMap(),
+                                           output,
+                                           errorMessage),
+               true);
+    TEST_EQUAL(output, std::string(" a test1 a test2 a test3"));
+
+    // dependencies are not part of the file, but restored from the loaded bytecode
+    TEST_EQUAL(controlFlowTemplate->getNumberOfSegments(), 1);
+    TEST_EQUAL(controlFlowTemplate->getDependencies().size(), 2);
+    TEST_EQUAL(controlFlowTemplate->isAffected({"loop.1.x"}), true);
+    TEST_EQUAL(controlFlowTemplate->isAffected({"item"}), false);
+
+    // loaded templates can be written into a new bundle again
+    std::vector<std::string> names = {"copy"};
+    std::vector<Jinja2Template*> templates = {controlFlowTemplate};
+    const std::string copyPath = m_filePath + ".copy";
+    TEST_EQUAL(Jinja2TemplateBundle::writeFile(copyPath, names, templates, errorMessage), true);
+
+    Jinja2TemplateBundle copyBundle;
+    TEST_EQUAL(copyBundle.loadFile(copyPath, errorMessage), true);
+    Jinja2Template* copyTemplate = copyBundle.getTemplate("copy");
+    TEST_NOT_EQUAL(copyTemplate, nullptr);
+    if(copyTemplate != nullptr)
+    {
+        output.clear();
+        TEST_EQUAL(copyTemplate->render(input.getItemContent()->toMap(), output, errorMessage),
+                   true);
+        TEST_EQUAL(output, std::string(" a test1 a test2 a test3"));
+        delete copyTemplate;
+    }
+
+    remove(copyPath.c_str());
+    delete replaceTemplate;
+    delete controlFlowTemplate;
+}
+
+/**
+ * @brief brokenFile_Test
+ */
+void
+Jinja2TemplateBundle_Test::brokenFile_Test()
+{
+    std::string errorMessage = "";
+    Jinja2TemplateBundle bundle;
+    TEST_EQUAL(bundle.loadFile(m_filePath + ".not_existing", errorMessage), false);
+
+    std::ifstream inputFile(m_filePath, std::ios::binary);
+    std::stringstream buffer;
+    buffer << inputFile.rdbuf();
+    const std::string content = buffer.str();
+
+    Json::JsonItem input;
+    input.parse(m_testJsonString, errorMessage);
+
+    const std::string brokenPath = m_filePath + ".broken";
+
+    // incomplete file
+    std::ofstream truncated(brokenPath, std::ios::binary | std::ios::trunc);
+    truncated.write(content.c_str(), static_cast<std::streamsize>(content.size() / 2));
+    truncated.close();
+    TEST_EQUAL(bundle.loadFile(brokenPath, errorMessage), false);
+    TEST_EQUAL(bundle.getNumberOfTemplates(), 0);
+
+    // change each byte of the file. The bundle must be rejected or the templates must be
+    // rendered without crash.
+    bool allRejectedOrRendered = true;
+    for(uint64_t i = 0; i < content.size(); i++)
+    {
+        std::string brokenContent = content;
+        brokenContent[i] = static_cast<char>(brokenContent[i] ^ 0xA5);
+
+        std::ofstream brokenFile(brokenPath, std::ios::binary | std::ios::trunc);
+        brokenFile.write(brokenContent.c_str(), static_cast<std::streamsize>(content.size()));
+        brokenFile.close();
+
+        if(bundle.loadFile(brokenPath, errorMessage) == false) {
+            continue;
+        }
+
+        const std::vector<std::string> names = bundle.getNames();
+        for(const std::string &name : names)
+        {
+            Jinja2Template* compiledTemplate = bundle.getTemplate(name);
+            if(compiledTemplate == nullptr)
+            {
+                allRejectedOrRendered = false;
+                continue;
+            }
+
+            std::string output = "";
+            compiledTemplate->render(input.getItemContent()->toMap(), output, errorMessage);
+            delete compiledTemplate;
+        }
+    }
+    TEST_EQUAL(allRejectedOrRendered, true);
+
+    remove(brokenPath.c_str());
+}
+
+/**
+ * cleanupTestCase
+ */
+void
+Jinja2TemplateBundle_Test::cleanupTestCase()
+{
+    remove(m_filePath.c_str());
+    delete m_converter;
+}
+
+}
+}
@@ -0,0 +1,46 @@
+/**
+ *  @file    jinja2_template_bundle_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#ifndef JINJA2TEMPLATEBUNDLE_TEST_H
+#define JINJA2TEMPLATEBUNDLE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+#include <utility>
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Converter;
+
+class Jinja2TemplateBundle_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+
+public:
+    Jinja2TemplateBundle_Test();
+
+private:
+    Kitsunemimi::Jinja2::Jinja2Converter* m_converter = nullptr;
+    std::string m_filePath = "";
+    std::string m_testJsonString = "";
+
+    void initTestCase();
+
+    void writeAndLoad_Test();
+    void brokenFile_Test();
+
+    void cleanupTestCase();
+};
+
+}
+}
+
+#endif // JINJA2TEMPLATEBUNDLE_TEST_H
@@ -0,0 +1,181 @@
+/**
+ *  @file    jinja2_template_registry_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include "jinja2_template_registry_test.h"
+#include <libKitsunemimiJinja2/jinja2_template_registry.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+#include <libKitsunemimiJson/json_item.h>
+
+#include <thread>
+#include <atomic>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief Jinja2TemplateRegistry_Test::Jinja2TemplateRegistry_Test
+ */
+Jinja2TemplateRegistry_Test::Jinja2TemplateRegistry_Test()
+    : Kitsunemimi::CompareTestHelper("Jinja2TemplateRegistry_Test")
+{
+    updateAndGet_Test();
+    remove_Test();
+    concurrentUpdate_Test();
+}
+
+/**
+ * @brief updateAndGet_Test
+ */
+void
+Jinja2TemplateRegistry_Test::updateAndGet_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"item\": \"test_value\"}", errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    Jinja2TemplateRegistry registry;
+    TEST_EQUAL(registry.get("greeting"), nullptr);
+    TEST_EQUAL(registry.getVersion("greeting"), 0);
+
+    std::string output = "";
+    TEST_EQUAL(registry.render("greeting", inputMap, output, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("greeting"), std::string::npos);
+
+    TEST_EQUAL(registry.update("greeting", "v1 {{ item }}", errorMessage), true);
+    TEST_EQUAL(registry.getNumberOfTemplates(), 1);
+    const uint64_t firstVersion = registry.getVersion("greeting");
+    TEST_NOT_EQUAL(firstVersion, 0);
+
+    // old version stays valid while it is used, also after it was replaced
+    const std::shared_ptr<Jinja2Template> oldTemplate = registry.get("greeting");
+    TEST_NOT_EQUAL(oldTemplate, nullptr);
+    TEST_EQUAL(registry.update("greeting", "v2 {{ item }}", errorMessage), true);
+    TEST_EQUAL(registry.getVersion("greeting") > firstVersion, true);
+
+    output.clear();
+    TEST_EQUAL(oldTemplate->render(inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, std::string("v1 test_value"));
+
+    output.clear();
+    TEST_EQUAL(registry.render("greeting", inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, std::string("v2 test_value"));
+
+    // broken template keeps the current version
+    const uint64_t secondVersion = registry.getVersion("greeting");
+    TEST_EQUAL(registry.update("greeting", "v3 {% if item %}", errorMessage), false);
+    TEST_EQUAL(registry.getVersion("greeting"), secondVersion);
+
+    // static context
+    Json::JsonItem staticContext;
+    staticContext.parse("{\"env\": \"prod\"}", errorMessage);
+    TEST_EQUAL(registry.update("env",
+                               "{% if env is prod %}p{% else %}d{% endif %}",
+                               staticContext.getItemContent()->toMap(),
+                               errorMessage), true);
+    output.clear();
+    TEST_EQUAL(registry.render("env", inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, std::string("p"));
+    TEST_EQUAL(registry.getNames().size(), 2);
+}
+
+/**
+ * @brief remove_Test
+ */
+void
+Jinja2TemplateRegistry_Test::remove_Test()
+{
+    std::string errorMessage = "";
+    Jinja2TemplateRegistry registry;
+
+    TEST_EQUAL(registry.remove("missing"), false);
+    TEST_EQUAL(registry.update("first", "first", errorMessage), true);
+    TEST_EQUAL(registry.update("second", "second", errorMessage), true);
+
+    const std::shared_ptr<Jinja2Template> firstTemplate = registry.get("first");
+    TEST_EQUAL(registry.remove("first"), true);
+    TEST_EQUAL(registry.get("first"), nullptr);
+    TEST_EQUAL(registry.getNumberOfTemplates(), 1);
+    TEST_EQUAL(registry.getNames().at(0), std::string("second"));
+
+    std::string output = "";
+    TEST_EQUAL(firstTemplate->render(nullptr, output, errorMessage), true);
+    TEST_EQUAL(output, std::string("first"));
+}
+
+/**
+ * @brief concurrentUpdate_Test
+ */
+void
+Jinja2TemplateRegistry_Test::concurrentUpdate_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"item\": \"x\"}", errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    Jinja2TemplateRegistry registry;
+    TEST_EQUAL(registry.update("version", "0{{ item }}", errorMessage), true);
+
+    // readers render the whole time, while the template is replaced and other names are added
+    std::atomic<bool> finished(false);
+    std::atomic<uint64_t> numberOfErrors(0);
+    std::atomic<uint64_t> numberOfRenders(0);
+    std::vector<std::thread> readers;
+    for(uint32_t i = 0; i < 4; i++)
+    {
+        readers.push_back(std::thread([&]()
+        {
+            std::string output = "";
+            std::string readerError = "";
+            while(finished.load() == false)
+            {
+                output.clear();
+                if(registry.render("version", inputMap, output, readerError) == false
+                        || output.size() != 2
+                        || output[0] < '0'
+                        || output[0] > '9'
+                        || output[1] != 'x')
+                {
+                    numberOfErrors.fetch_add(1);
+                }
+                numberOfRenders.fetch_add(1);
+            }
+        }));
+    }
+
+    while(numberOfRenders.load() == 0) {
+        std::this_thread::yield();
+    }
+
+    for(uint32_t i = 1; i < 200; i++)
+    {
+        std::string updateError = "";
+        registry.update("version", std::to_string(i % 10) + "{{ item }}", updateError);
+        registry.update("other" + std::to_string(i % 7), "other", updateError);
+    }
+
+    finished.store(true);
+    for(std::thread &reader : readers) {
+        reader.join();
+    }
+
+    TEST_EQUAL(numberOfErrors.load(), 0);
+    TEST_EQUAL(numberOfRenders.load() > 0, true);
+    TEST_EQUAL(registry.getNumberOfTemplates(), 8);
+
+    std::string output = "";
+    TEST_EQUAL(registry.render("version", inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, std::string("9x"));
+}
+
+}
+}
@@ -0,0 +1,38 @@
+/**
+ *  @file    jinja2_template_registry_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#ifndef JINJA2TEMPLATEREGISTRY_TEST_H
+#define JINJA2TEMPLATEREGISTRY_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+#include <utility>
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+class Jinja2TemplateRegistry_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+
+public:
+    Jinja2TemplateRegistry_Test();
+
+private:
+    void updateAndGet_Test();
+    void remove_Test();
+    void concurrentUpdate_Test();
+};
+
+}
+}
+
+#endif // JINJA2TEMPLATEREGISTRY_TEST_H
@@ -0,0 +1,1359 @@
+/**
+ *  @file    jinja2_template_test.cpp
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include "jinja2_template_test.h"
+#include <libKitsunemimiJinja2/jinja2_converter.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_sink.h>
+#include <libKitsunemimiJinja2/jinja2_prepared_context.h>
+#include <libKitsunemimiCommon/common_items/data_items.h>
+#include <libKitsunemimiJson/json_item.h>
+
+#include <sstream>
+#include <algorithm>
+#include <thread>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+
+/**
+ * @brief Jinja2Template_Test::Jinja2Template_Test
+ */
+Jinja2Template_Test::Jinja2Template_Test()
+    : Kitsunemimi::CompareTestHelper("Jinja2Template_Test")
+{
+    initTestCase();
+
+    compile_Test();
+    renderMultipleTimes_Test();
+    longTemplate_Test();
+    nestingDepth_Test();
+    estimateOutputSize_Test();
+    renderIntoSink_Test();
+    loopVariables_Test();
+    renderBatch_Test();
+    parallelLoop_Test();
+    staticContext_Test();
+    profiling_Test();
+    dependencies_Test();
+    renderIncremental_Test();
+    spliceList_Test();
+    resumableRender_Test();
+    renderLimits_Test();
+    preparedContext_Test();
+
+    cleanupTestCase();
+}
+
+/**
+ * @brief initTestCase
+ */
+void
+Jinja2Template_Test::initTestCase()
+{
+    m_converter = Kitsunemimi::Jinja2::Jinja2Converter::getInstance();
+}
+
+/**
+ * @brief compile_Test
+ */
+void
+Jinja2Template_Test::compile_Test()
+{
+    std::string errorMessage = "";
+
+    Jinja2Template* compiledTemplate = m_converter->compile("this is a {{ item }}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    delete compiledTemplate;
+
+    compiledTemplate = m_converter->compile("this is {% if item ist something %}",
+                                            errorMessage);
+    TEST_EQUAL(compiledTemplate, nullptr);
+    TEST_NOT_EQUAL(errorMessage, "");
+}
+
+/**
+ * @brief renderMultipleTimes_Test
+ */
+void
+Jinja2Template_Test::renderMultipleTimes_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("this is a {{ item.sub_item }}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    Json::JsonItem firstInput;
+    firstInput.parse("{\"item\": { \"sub_item\": \"test_value\"}}", errorMessage);
+    Json::JsonItem secondInput;
+    secondInput.parse("{\"item\": { \"sub_item\": 42}}", errorMessage);
+
+    std::string output = "";
+    bool result = compiledTemplate->render(firstInput.getItemContent()->toMap(),
+                                           output,
+                                           errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, std::string("this is a test_value"));
+
+    output.clear();
+    result = compiledTemplate->render(secondInput.getItemContent()->toMap(),
+                                      output,
+                                      errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, std::string("this is a 42"));
+
+    // missing item in the input
+    Json::JsonItem brokenInput;
+    brokenInput.parse("{\"item2\": 42}", errorMessage);
+    output.clear();
+    result = compiledTemplate->render(brokenInput.getItemContent()->toMap(),
+                                      output,
+                                      errorMessage);
+    TEST_EQUAL(result, false);
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief longTemplate_Test
+ */
+void
+Jinja2Template_Test::longTemplate_Test()
+{
+    std::string errorMessage = "";
+    std::string testString = "";
+    std::string expectedOutput = "";
+    for(uint32_t i = 0; i < 50000; i++)
+    {
+        testString += "a{{ item }}";
+        expectedOutput += "a42";
+    }
+
+    Json::JsonItem input;
+    input.parse("{\"item\": 42}", errorMessage);
+
+    Jinja2Template* compiledTemplate = m_converter->compile(testString, errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    std::string output = "";
+    const bool result = compiledTemplate->render(input.getItemContent()->toMap(),
+                                                 output,
+                                                 errorMessage);
+    TEST_EQUAL(result, true);
+    TEST_EQUAL(output, expectedOutput);
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief nestingDepth_Test
+ */
+void
+Jinja2Template_Test::nestingDepth_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"item\": true}", errorMessage);
+
+    const uint32_t depths[2] = { Jinja2Template::MAX_NESTING_DEPTH,
+                                 Jinja2Template::MAX_NESTING_DEPTH + 1 };
+    for(uint32_t d = 0; d < 2; d++)
+    {
+        std::string testString = "";
+        for(uint32_t i = 0; i < depths[d]; i++) {
+            testString += "{% if item %}";
+        }
+        testString += "x";
+        for(uint32_t i = 0; i < depths[d]; i++) {
+            testString += "{% endif %}";
+        }
+
+        // too deep nested templates are already rejected while compiling
+        errorMessage = "";
+        Jinja2Template* compiledTemplate = m_converter->compile(testString, errorMessage);
+        TEST_EQUAL(compiledTemplate != nullptr, d == 0);
+        TEST_EQUAL(errorMessage.empty(), d == 0);
+        if(compiledTemplate == nullptr) {
+            continue;
+        }
+
+        std::string output = "";
+        const bool result = compiledTemplate->render(input.getItemContent()->toMap(),
+                                                     output,
+                                                     errorMessage);
+        TEST_EQUAL(result, true);
+        TEST_EQUAL(output, "x");
+
+        delete compiledTemplate;
+    }
+}
+
+/**
+ * @brief estimateOutputSize_Test
+ */
+void
+Jinja2Template_Test::estimateOutputSize_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("0123456789{{ item }}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    // before the first render only the literal text is known
+    TEST_EQUAL(compiledTemplate->estimateOutputSize(), 10);
+
+    Json::JsonItem input;
+    input.parse("{\"item\": \"abcdefghijklmnopqrst\"}", errorMessage);
+
+    std::string output = "";
+    TEST_EQUAL(compiledTemplate->render(input.getItemContent()->toMap(), output, errorMessage),
+               true);
+    TEST_EQUAL(output.size(), 30);
+    TEST_EQUAL(compiledTemplate->estimateOutputSize(), 30);
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief renderIntoSink_Test
+ */
+void
+Jinja2Template_Test::renderIntoSink_Test()
+{
+    std::string errorMessage = "";
+    std::string templateString = "";
+    for(uint32_t i = 0; i < 100; i++) {
+        templateString += "0123456789{{ x }}";
+    }
+
+    Jinja2Template* compiledTemplate = m_converter->compile(templateString, errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    Json::JsonItem jsonInput;
+    jsonInput.parse("{\"x\": \"abcdefghij\"}", errorMessage);
+
+    // output is forwarded in chunks, which are not much bigger than the chunk-size
+    std::string output = "";
+    uint32_t numberOfChunks = 0;
+    bool chunksTooBig = false;
+    Jinja2CallbackSink callbackSink([&](const char* data, const uint64_t size)
+                                    {
+                                        output.append(data, size);
+                                        numberOfChunks++;
+                                        chunksTooBig |= size > 128;
+                                        return true;
+                                    },
+                                    100);
+
+    TEST_EQUAL(compiledTemplate->render(jsonInput.getItemContent()->toMap(),
+                                        callbackSink,
+                                        errorMessage),
+               true);
+    TEST_EQUAL(output.size(), 2000);
+    TEST_EQUAL(callbackSink.getNumberOfWrittenBytes(), 2000);
+    TEST_EQUAL(numberOfChunks > 10, true);
+    TEST_EQUAL(chunksTooBig, false);
+
+    // stream-sink
+    std::ostringstream stream;
+    Jinja2StreamSink streamSink(stream);
+    TEST_EQUAL(compiledTemplate->render(jsonInput.getItemContent()->toMap(),
+                                        streamSink,
+                                        errorMessage),
+               true);
+    TEST_EQUAL(stream.str(), output);
+
+    // failing sink aborts the render
+    Jinja2CallbackSink failingSink([](const char*, const uint64_t) { return false; }, 100);
+    TEST_EQUAL(compiledTemplate->render(jsonInput.getItemContent()->toMap(),
+                                        failingSink,
+                                        errorMessage),
+               false);
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief loopVariables_Test
+ */
+void
+Jinja2Template_Test::loopVariables_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("{% for x in outer %}"
+                                                            "{{ x.name }}:"
+                                                            "{% for x in x.inner %}"
+                                                            "{{ x }}"
+                                                            "{% endfor %}"
+                                                            "{{ x.name }} "
+                                                            "{% endfor %}"
+                                                            "{{ x }}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    Json::JsonItem input;
+    input.parse("{\"x\": \"root\","
+                " \"outer\": [{\"name\": \"a\", \"inner\": [1, 2]},"
+                "             {\"name\": \"b\", \"inner\": [3]}]}",
+                errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    // inner loop-variable shadows the outer one and the input is not modified while rendering
+    for(uint32_t i = 0; i < 2; i++)
+    {
+        std::string output = "";
+        TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+        TEST_EQUAL(output, std::string("a:12a b:3b root"));
+        TEST_EQUAL(inputMap->size(), 2);
+        TEST_EQUAL(inputMap->get("x")->toString(), std::string("root"));
+    }
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief renderBatch_Test
+ */
+void
+Jinja2Template_Test::renderBatch_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("{% for x in loop %}"
+                                                            "{{ x }}"
+                                                            "{% endfor %}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    // inputs with different sizes of the loop, and one invalid input
+    const uint32_t numberOfInputs = 100;
+    std::vector<Json::JsonItem*> jsonInputs;
+    std::vector<DataMap*> inputs;
+    for(uint32_t i = 0; i < numberOfInputs; i++)
+    {
+        std::string input = "{\"loop\": [";
+        for(uint32_t j = 0; j < i; j++)
+        {
+            if(j != 0) {
+                input += ",";
+            }
+            input += "1";
+        }
+        input += "]}";
+
+        if(i == 42) {
+            input = "{\"no_loop\": 1}";
+        }
+
+        Json::JsonItem* jsonInput = new Json::JsonItem();
+        jsonInput->parse(input, errorMessage);
+        jsonInputs.push_back(jsonInput);
+        inputs.push_back(jsonInput->getItemContent()->toMap());
+    }
+
+    std::vector<std::string> results;
+    std::vector<std::string> errorMessages;
+    TEST_EQUAL(compiledTemplate->renderBatch(inputs, results, errorMessages, 4), false);
+    TEST_EQUAL(results.size(), numberOfInputs);
+    TEST_EQUAL(errorMessages.size(), numberOfInputs);
+
+    bool allCorrect = true;
+    for(uint32_t i = 0; i < numberOfInputs; i++)
+    {
+        if(i == 42)
+        {
+            TEST_NOT_EQUAL(errorMessages[i], "");
+            continue;
+        }
+
+        allCorrect &= results[i] == std::string(i, '1');
+        allCorrect &= errorMessages[i] == "";
+    }
+    TEST_EQUAL(allCorrect, true);
+
+    // loops of batch-renders are not split again, but have the same result
+    compiledTemplate->setParallelLoops(2, 4);
+    compiledTemplate->setProfiling(true);
+    TEST_EQUAL(compiledTemplate->renderBatch(inputs, results, errorMessages, 4), false);
+    allCorrect = true;
+    for(uint32_t i = 0; i < numberOfInputs; i++)
+    {
+        if(i != 42) {
+            allCorrect &= results[i] == std::string(i, '1');
+        }
+    }
+    TEST_EQUAL(allCorrect, true);
+    TEST_EQUAL(compiledTemplate->getProfile().parallelLoops, 0);
+
+    // the same template splits its loops, when it is rendered alone
+    std::string output = "";
+    TEST_EQUAL(compiledTemplate->render(inputs[10], output, errorMessage), true);
+    TEST_EQUAL(output, std::string(10, '1'));
+    TEST_EQUAL(compiledTemplate->getProfile().parallelLoops, 1);
+    compiledTemplate->setProfiling(false);
+
+    for(Json::JsonItem* jsonInput : jsonInputs) {
+        delete jsonInput;
+    }
+    delete compiledTemplate;
+}
+
+/**
+ * @brief parallelLoop_Test
+ */
+void
+Jinja2Template_Test::parallelLoop_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("begin "
+                                                            "{% for x in loop %}"
+                                                            "{{ x.id }}:"
+                                                            "{% for y in x.list %}"
+                                                            "{{ y }}"
+                                                            "{% endfor %}"
+                                                            "{{ name }} "
+                                                            "{% endfor %}"
+                                                            "end",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    std::string input = "{\"name\": \"n\", \"loop\": [";
+    std::string expected = "begin ";
+    for(uint32_t i = 0; i < 1000; i++)
+    {
+        if(i != 0) {
+            input += ",";
+        }
+        input += "{\"id\": " + std::to_string(i) + ", \"list\": [";
+        expected += std::to_string(i) + ":";
+        for(uint32_t j = 0; j < i % 7; j++)
+        {
+            if(j != 0) {
+                input += ",";
+            }
+            input += std::to_string(j);
+            expected += std::to_string(j);
+        }
+        input += "]}";
+        expected += "n ";
+    }
+    input += "]}";
+    expected += "end";
+
+    Json::JsonItem jsonInput;
+    jsonInput.parse(input, errorMessage);
+    DataMap* inputMap = jsonInput.getItemContent()->toMap();
+
+    // output must be the same like the sequential output
+    compiledTemplate->setParallelLoops(100, 4);
+    std::string output = "";
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, expected);
+
+    std::ostringstream stream;
+    Jinja2StreamSink streamSink(stream, 256);
+    TEST_EQUAL(compiledTemplate->render(inputMap, streamSink, errorMessage), true);
+    TEST_EQUAL(stream.str(), expected);
+
+    // finished chunks of a parallel loop are written into the sink one after another by the
+    // calling thread, and not as one block at the end of the loop
+    std::string sinkOutput = "";
+    uint32_t numberOfWrites = 0;
+    bool otherThread = false;
+    const std::thread::id callerId = std::this_thread::get_id();
+    Jinja2CallbackSink callbackSink([&](const char* data, const uint64_t size)
+                                    {
+                                        sinkOutput.append(data, size);
+                                        numberOfWrites++;
+                                        otherThread |= std::this_thread::get_id() != callerId;
+                                        return true;
+                                    },
+                                    256);
+    TEST_EQUAL(compiledTemplate->render(inputMap, callbackSink, errorMessage), true);
+    TEST_EQUAL(sinkOutput, expected);
+    TEST_EQUAL(numberOfWrites > 10, true);
+    TEST_EQUAL(otherThread, false);
+
+    // a failing sink stops the parallel loop
+    Jinja2CallbackSink failingSink([](const char*, const uint64_t) { return false; }, 256);
+    TEST_EQUAL(compiledTemplate->render(inputMap, failingSink, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("failed to write the output into the sink"),
+                   std::string::npos);
+
+    // loops below the threshold are rendered sequentially
+    compiledTemplate->setParallelLoops(100000, 4);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, expected);
+
+    // errors of a thread are returned
+    Json::JsonItem brokenInput;
+    brokenInput.parse("{\"loop\": " + input.substr(input.find("[")), errorMessage);
+    compiledTemplate->setParallelLoops(100, 4);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(brokenInput.getItemContent()->toMap(),
+                                        output,
+                                        errorMessage),
+               false);
+    TEST_NOT_EQUAL(errorMessage, "");
+    delete compiledTemplate;
+
+    // inner parallel loops of a sequential outer loop reuse the threads of the pool
+    compiledTemplate = m_converter->compile("{% for x in loop %}"
+                                            "{% for y in x.list %}{{ y }}{% endfor %}|"
+                                            "{% endfor %}",
+                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        std::string nestedExpected = "";
+        for(uint32_t i = 0; i < 1000; i++)
+        {
+            for(uint32_t j = 0; j < i % 7; j++) {
+                nestedExpected += std::to_string(j);
+            }
+            nestedExpected += "|";
+        }
+
+        compiledTemplate->setParallelLoops(3, 4);
+        output.clear();
+        TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+        TEST_EQUAL(output, nestedExpected);
+        delete compiledTemplate;
+    }
+}
+
+/**
+ * @brief staticContext_Test
+ */
+void
+Jinja2Template_Test::staticContext_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem staticContext;
+    staticContext.parse("{\"env\": \"prod\", \"version\": 3}", errorMessage);
+
+    Jinja2Template* compiledTemplate = m_converter->compile(
+                "{% if env is prod %}A{% else %}B{% endif %}"
+                "-{{ version }}-{{ user }}-"
+                "{% for env in list %}{% if env is prod %}x{% endif %}{% endfor %}",
+                staticContext.getItemContent()->toMap(),
+                errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    // static values are not necessary within the input and can not be changed by the input,
+    // but loop-variables with the same name shadow the static values
+    Json::JsonItem input;
+    input.parse("{\"user\": \"u\", \"version\": 4, \"list\": [\"dev\", \"prod\"]}",
+                errorMessage);
+
+    std::string output = "";
+    TEST_EQUAL(compiledTemplate->render(input.getItemContent()->toMap(), output, errorMessage),
+               true);
+    TEST_EQUAL(output, std::string("A-3-u-x"));
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief profiling_Test
+ */
+void
+Jinja2Template_Test::profiling_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("list:\n"
+                                                            "{% for x in loop %}"
+                                                            "{% if x.id > 1 %}{{ x.name }}"
+                                                            "{% else %}-"
+                                                            "{% endif %}"
+                                                            "{% endfor %}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    Json::JsonItem input;
+    input.parse("{\"loop\": [{\"id\": 1, \"name\": \"a\"},"
+                "           {\"id\": 2, \"name\": \"b\"},"
+                "           {\"id\": 3, \"name\": \"c\"}]}",
+                errorMessage);
+
+    // without profiling only the parse-time is known
+    std::string output = "";
+    TEST_EQUAL(compiledTemplate->isProfiling(), false);
+    TEST_EQUAL(compiledTemplate->render(input.getItemContent()->toMap(), output, errorMessage),
+               true);
+    TemplateProfile profile = compiledTemplate->getProfile();
+    TEST_EQUAL(profile.numberOfRenders, 0);
+    TEST_EQUAL(profile.instructions.size(), 0);
+    TEST_NOT_EQUAL(profile.parseTime, 0);
+
+    // counters of two renders
+    compiledTemplate->setProfiling(true);
+    TEST_EQUAL(compiledTemplate->isProfiling(), true);
+    for(uint32_t i = 0; i < 2; i++)
+    {
+        output = "";
+        TEST_EQUAL(compiledTemplate->render(input.getItemContent()->toMap(),
+                                            output,
+                                            errorMessage), true);
+    }
+    TEST_EQUAL(output, std::string("list:\n-bc"));
+
+    profile = compiledTemplate->getProfile();
+    TEST_EQUAL(profile.numberOfRenders, 2);
+    TEST_EQUAL(profile.loopIterations, 6);
+    TEST_EQUAL(profile.emittedBytes, 2 * output.size());
+    TEST_EQUAL(profile.replaceLookups, 2 * 2 * 2);
+    TEST_EQUAL(profile.ifLookups, 2 * 3 * 2);
+    TEST_EQUAL(profile.forLookups, 2);
+    TEST_EQUAL(profile.instructions.size(), 7);
+
+    // text, for, if, replace, else, text, endfor
+    if(profile.instructions.size() == 7)
+    {
+        TEST_EQUAL(profile.instructions[0].type, std::string("text"));
+        TEST_EQUAL(profile.instructions[0].line, 1);
+        TEST_EQUAL(profile.instructions[0].column, 1);
+        TEST_EQUAL(profile.instructions[1].type, std::string("for"));
+        TEST_EQUAL(profile.instructions[1].line, 2);
+        TEST_EQUAL(profile.instructions[1].column, 1);
+        TEST_EQUAL(profile.instructions[1].executions, 2);
+        TEST_EQUAL(profile.instructions[2].type, std::string("if"));
+        TEST_EQUAL(profile.instructions[2].column, 20);
+        TEST_EQUAL(profile.instructions[2].executions, 6);
+        TEST_EQUAL(profile.instructions[3].type, std::string("replace"));
+        TEST_EQUAL(profile.instructions[3].executions, 4);
+        TEST_EQUAL(profile.instructions[4].type, std::string("else"));
+        TEST_EQUAL(profile.instructions[6].type, std::string("endfor"));
+        TEST_EQUAL(profile.instructions[6].executions, 6);
+    }
+
+    const std::string dump = compiledTemplate->dumpProfile();
+    TEST_NOT_EQUAL(dump.find("renders: 2"), std::string::npos);
+    TEST_NOT_EQUAL(dump.find("2:20"), std::string::npos);
+
+    // the same counters with a parallel loop
+    compiledTemplate->resetProfile();
+    compiledTemplate->setParallelLoops(2, 2);
+    output = "";
+    TEST_EQUAL(compiledTemplate->render(input.getItemContent()->toMap(), output, errorMessage),
+               true);
+    profile = compiledTemplate->getProfile();
+    TEST_EQUAL(profile.numberOfRenders, 1);
+    TEST_EQUAL(profile.loopIterations, 3);
+    TEST_EQUAL(profile.emittedBytes, output.size());
+    TEST_EQUAL(profile.ifLookups, 3 * 2);
+    if(profile.instructions.size() == 7) {
+        TEST_EQUAL(profile.instructions[6].executions, 3);
+    }
+
+    // a resumable render is profiled as one render, also if it was paused
+    compiledTemplate->resetProfile();
+    Jinja2RenderContinuation continuation;
+    compiledTemplate->beginRender(input.getItemContent()->toMap(), continuation);
+    bool success = true;
+    while(success
+          && continuation.isFinished() == false)
+    {
+        success = compiledTemplate->continueRender(continuation, 2, errorMessage);
+        continuation.consume(continuation.getSize());
+    }
+    TEST_EQUAL(success, true);
+    profile = compiledTemplate->getProfile();
+    TEST_EQUAL(profile.numberOfRenders, 1);
+    TEST_EQUAL(profile.loopIterations, 3);
+    TEST_EQUAL(profile.emittedBytes, output.size());
+    TEST_EQUAL(profile.ifLookups, 3 * 2);
+    if(profile.instructions.size() == 7) {
+        TEST_EQUAL(profile.instructions[6].executions, 3);
+    }
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief dependencies_Test
+ */
+void
+Jinja2Template_Test::dependencies_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("name: {{ service.name }}\n"
+                                                            "{% if debug is true %}"
+                                                            "level: {{ log.level }}"
+                                                            "{% else %}-{% endif %}\n"
+                                                            "{% for x in hosts %}"
+                                                            "{% for y in x.ports %}"
+                                                            "{{ x.name }}:{{ y }} "
+                                                            "{% endfor %}"
+                                                            "{% endfor %}\n"
+                                                            "{{ service.name }}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    // paths of loop-variables are replaced by the path of the array
+    const std::vector<std::string> dependencies = compiledTemplate->getDependencies();
+    TEST_EQUAL(dependencies.size(), 4);
+    if(dependencies.size() == 4)
+    {
+        TEST_EQUAL(dependencies.at(0), std::string("service.name"));
+        TEST_EQUAL(dependencies.at(1), std::string("debug"));
+        TEST_EQUAL(dependencies.at(2), std::string("log.level"));
+        TEST_EQUAL(dependencies.at(3), std::string("hosts"));
+    }
+
+    // text, replacement, text, if-condition, text, for-loop, text, replacement
+    TEST_EQUAL(compiledTemplate->getNumberOfSegments(), 8);
+    TEST_EQUAL(compiledTemplate->getSegmentDependencies(0).size(), 0);
+    TEST_EQUAL(compiledTemplate->getSegmentDependencies(3).size(), 2);
+    TEST_EQUAL(compiledTemplate->getSegmentDependencies(5).size(), 1);
+    TEST_EQUAL(compiledTemplate->getSegmentDependencies(8).size(), 0);
+
+    // changed paths match the dependencies, their parents and their children
+    TEST_EQUAL(compiledTemplate->isAffected({"service.name"}), true);
+    TEST_EQUAL(compiledTemplate->isAffected({"service"}), true);
+    TEST_EQUAL(compiledTemplate->isAffected({"hosts.0.ports"}), true);
+    TEST_EQUAL(compiledTemplate->isAffected({""}), true);
+    TEST_EQUAL(compiledTemplate->isAffected({"service.id", "log.file", "host", "x"}), false);
+    TEST_EQUAL(compiledTemplate->isAffected({}), false);
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief renderIncremental_Test
+ */
+void
+Jinja2Template_Test::renderIncremental_Test()
+{
+    std::string errorMessage = "";
+    Jinja2Template* compiledTemplate = m_converter->compile("A{{ a }}B"
+                                                            "{% if mode is on %}on{% endif %}"
+                                                            "C{% for x in list %}{{ x }}{% endfor %}"
+                                                            "D{{ b.c }}",
+                                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    Json::JsonItem input;
+    input.parse("{\"a\": 1, \"mode\": \"on\", \"list\": [1, 2], \"b\": {\"c\": \"x\"}}",
+                errorMessage);
+
+    // first render with an empty state renders all segments
+    Jinja2RenderState state;
+    bool changed = false;
+    TEST_EQUAL(compiledTemplate->renderIncremental(input.getItemContent()->toMap(),
+                                                   {},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    TEST_EQUAL(changed, true);
+    TEST_EQUAL(state.getOutput(), std::string("A1BonC12Dx"));
+    TEST_EQUAL(state.getNumberOfRenderedSegments(), compiledTemplate->getNumberOfSegments());
+
+    // change of an unused path renders nothing
+    TEST_EQUAL(compiledTemplate->renderIncremental(input.getItemContent()->toMap(),
+                                                   {"unused"},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    TEST_EQUAL(changed, false);
+    TEST_EQUAL(state.getNumberOfRenderedSegments(), 0);
+    TEST_EQUAL(state.getOutput(), std::string("A1BonC12Dx"));
+
+    // only the segment of the changed path is rendered again
+    Json::JsonItem changedInput;
+    changedInput.parse("{\"a\": 1, \"mode\": \"on\", \"list\": [3], \"b\": {\"c\": \"y\"}}",
+                       errorMessage);
+    TEST_EQUAL(compiledTemplate->renderIncremental(changedInput.getItemContent()->toMap(),
+                                                   {"list"},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    TEST_EQUAL(changed, true);
+    TEST_EQUAL(state.getNumberOfRenderedSegments(), 1);
+    TEST_EQUAL(state.getOutput(), std::string("A1BonC3Dx"));
+
+    // segment is rendered, but the output is the same
+    TEST_EQUAL(compiledTemplate->renderIncremental(changedInput.getItemContent()->toMap(),
+                                                   {"mode"},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    TEST_EQUAL(changed, false);
+    TEST_EQUAL(state.getNumberOfRenderedSegments(), 1);
+
+    TEST_EQUAL(compiledTemplate->renderIncremental(changedInput.getItemContent()->toMap(),
+                                                   {"b"},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    TEST_EQUAL(changed, true);
+    TEST_EQUAL(state.getOutput(), std::string("A1BonC3Dy"));
+
+    // state is cleared after an error
+    Json::JsonItem brokenInput;
+    brokenInput.parse("{\"a\": 1, \"mode\": \"on\", \"list\": [3]}", errorMessage);
+    TEST_EQUAL(compiledTemplate->renderIncremental(brokenInput.getItemContent()->toMap(),
+                                                   {"b.c"},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), false);
+    TEST_EQUAL(state.getOutput(), std::string(""));
+
+    // the state of a deleted template is not reused by a new template, also if the new one
+    // has the same template-string and gets the same address
+    TEST_EQUAL(compiledTemplate->renderIncremental(input.getItemContent()->toMap(),
+                                                   {},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    const std::string templateString = "A{{ a }}B"
+                                       "{% if mode is on %}on{% endif %}"
+                                       "C{% for x in list %}{{ x }}{% endfor %}"
+                                       "D{{ b.c }}";
+    delete compiledTemplate;
+    compiledTemplate = m_converter->compile(templateString, errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+    TEST_EQUAL(compiledTemplate->renderIncremental(changedInput.getItemContent()->toMap(),
+                                                   {},
+                                                   state,
+                                                   changed,
+                                                   errorMessage), true);
+    TEST_EQUAL(changed, true);
+    TEST_EQUAL(state.getOutput(), std::string("A1BonC3Dy"));
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief spliceList_Test
+ */
+void
+Jinja2Template_Test::spliceList_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"s\": \"text\", \"i\": -42, \"b\": true, \"f\": 1.5,"
+                " \"m\": {\"k\": [1]}}",
+                errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    // templates with only text and replacements are rendered as splice-list
+    std::string templateString = "<{{ s }}|{{ i }}{{ b }}|{{ f }}|{{ m.k }}>";
+    for(uint32_t i = 0; i < 40; i++) {
+        templateString += "{{ s }}";
+    }
+
+    Jinja2Template* compiledTemplate = m_converter->compile(templateString, errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+    TEST_EQUAL(compiledTemplate->getStatistics().isSpliceList, true);
+
+    std::string expected = "<text|-42true|1.500000|[1]>";
+    for(uint32_t i = 0; i < 40; i++) {
+        expected += "text";
+    }
+
+    std::string output = "prefix";
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, "prefix" + expected);
+
+    std::ostringstream stream;
+    Jinja2StreamSink sink(stream, 8);
+    TEST_EQUAL(compiledTemplate->render(inputMap, sink, errorMessage), true);
+    TEST_EQUAL(stream.str(), expected);
+
+    // profiling uses the interpreter with the same output
+    compiledTemplate->setProfiling(true);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, expected);
+    delete compiledTemplate;
+
+    // more paths, than values on the stack
+    templateString = "";
+    expected = "";
+    for(uint32_t i = 0; i < 40; i++)
+    {
+        templateString += "{{ m.k" + std::to_string(i) + " }}{{ i }}";
+        expected += "-42";
+    }
+    compiledTemplate = m_converter->compile(templateString, errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        output.clear();
+        TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+        TEST_NOT_EQUAL(errorMessage.find("k0"), std::string::npos);
+
+        Json::JsonItem bigInput;
+        std::string bigInputString = "{\"i\": -42, \"m\": {";
+        for(uint32_t i = 0; i < 40; i++)
+        {
+            if(i != 0) {
+                bigInputString += ", ";
+            }
+            bigInputString += "\"k" + std::to_string(i) + "\": \"\"";
+        }
+        bigInputString += "}}";
+        bigInput.parse(bigInputString, errorMessage);
+
+        output.clear();
+        TEST_EQUAL(compiledTemplate->render(bigInput.getItemContent()->toMap(),
+                                            output,
+                                            errorMessage), true);
+        TEST_EQUAL(output, expected);
+        delete compiledTemplate;
+    }
+
+    // missing paths
+    compiledTemplate = m_converter->compile("a{{ s }}b{{ unknown }}c", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        output.clear();
+        TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+        TEST_NOT_EQUAL(errorMessage.find("unknown"), std::string::npos);
+        delete compiledTemplate;
+    }
+
+    // control-flow is rendered by the interpreter, unless it is removed by the static context
+    compiledTemplate = m_converter->compile("{% if b %}{{ s }}{% endif %}", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        TEST_EQUAL(compiledTemplate->getStatistics().isSpliceList, false);
+        delete compiledTemplate;
+    }
+
+    compiledTemplate = m_converter->compile("{% if b %}{{ s }}{% endif %}",
+                                            inputMap,
+                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        TEST_EQUAL(compiledTemplate->getStatistics().isSpliceList, true);
+        delete compiledTemplate;
+    }
+}
+
+/**
+ * @brief resumableRender_Test
+ */
+void
+Jinja2Template_Test::resumableRender_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"title\": \"list\", \"show\": true,"
+                " \"rows\": [{\"name\": \"a\", \"values\": [1, 2, 3]},"
+                "          {\"name\": \"b\", \"values\": [4]}]}",
+                errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    Jinja2Template* compiledTemplate = m_converter->compile(
+                "<{{ title }}>"
+                "{% for row in rows %}"
+                    "[{{ row.name }}:{% for value in row.values %} {{ value }}{% endfor %}]"
+                "{% endfor %}"
+                "{% if show %}shown{% else %}hidden{% endif %}",
+                errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    std::string expected = "";
+    TEST_EQUAL(compiledTemplate->render(inputMap, expected, errorMessage), true);
+
+    // the output is consumed only partially, like by a socket with a full buffer
+    Jinja2RenderContinuation continuation;
+    TEST_EQUAL(continuation.isFinished(), true);
+    compiledTemplate->beginRender(inputMap, continuation);
+    TEST_EQUAL(continuation.isFinished(), false);
+
+    std::string output = "";
+    uint64_t numberOfSteps = 0;
+    bool success = true;
+    while(continuation.isFinished() == false
+          || continuation.getSize() > 0)
+    {
+        success = compiledTemplate->continueRender(continuation, 4, errorMessage) && success;
+        TEST_EQUAL(continuation.getSize() < 4 + 8, true);
+
+        const uint64_t size = std::min(continuation.getSize(), static_cast<uint64_t>(3));
+        output.append(continuation.getData(), size);
+        continuation.consume(size);
+        numberOfSteps++;
+    }
+    TEST_EQUAL(success, true);
+    TEST_EQUAL(output, expected);
+    TEST_EQUAL(numberOfSteps >= expected.size() / 3, true);
+
+    // a full buffer pauses the render without any progress
+    compiledTemplate->beginRender(inputMap, continuation);
+    TEST_EQUAL(compiledTemplate->continueRender(continuation, 8, errorMessage), true);
+    const uint64_t pendingSize = continuation.getSize();
+    TEST_EQUAL(compiledTemplate->continueRender(continuation, 8, errorMessage), true);
+    TEST_EQUAL(continuation.getSize(), pendingSize);
+
+    // without pending output even a pending-size of 0 renders the next text or value
+    compiledTemplate->beginRender(inputMap, continuation);
+    output.clear();
+    numberOfSteps = 0;
+    success = true;
+    while(success
+          && continuation.isFinished() == false
+          && numberOfSteps < 1000)
+    {
+        success = compiledTemplate->continueRender(continuation, 0, errorMessage);
+        TEST_NOT_EQUAL(continuation.getSize() == 0 && continuation.isFinished() == false, true);
+        output.append(continuation.getData(), continuation.getSize());
+        continuation.consume(continuation.getSize());
+        numberOfSteps++;
+    }
+    TEST_EQUAL(success, true);
+    TEST_EQUAL(output, expected);
+    TEST_EQUAL(numberOfSteps > 1, true);
+
+    // the whole output at once
+    compiledTemplate->beginRender(inputMap, continuation);
+    TEST_EQUAL(compiledTemplate->continueRender(continuation, UINT64_MAX, errorMessage), true);
+    TEST_EQUAL(continuation.isFinished(), true);
+    TEST_EQUAL(std::string(continuation.getData(), continuation.getSize()), expected);
+
+    // the paths are searched in the index of a prepared context
+    Jinja2PreparedContext context(inputMap);
+    compiledTemplate->beginRender(context, continuation);
+    TEST_EQUAL(compiledTemplate->continueRender(continuation, UINT64_MAX, errorMessage), true);
+    TEST_EQUAL(continuation.isFinished(), true);
+    TEST_EQUAL(std::string(continuation.getData(), continuation.getSize()), expected);
+
+    // continuation of another template
+    Jinja2Template* otherTemplate = m_converter->compile("{{ unknown }}", errorMessage);
+    TEST_NOT_EQUAL(otherTemplate, nullptr);
+    if(otherTemplate != nullptr)
+    {
+        TEST_EQUAL(otherTemplate->continueRender(continuation, 8, errorMessage), false);
+
+        // failed renders finish the continuation
+        otherTemplate->beginRender(inputMap, continuation);
+        TEST_EQUAL(otherTemplate->continueRender(continuation, 8, errorMessage), false);
+        TEST_NOT_EQUAL(errorMessage.find("unknown"), std::string::npos);
+        TEST_EQUAL(continuation.isFinished(), true);
+        delete otherTemplate;
+    }
+
+    delete compiledTemplate;
+}
+
+/**
+ * @brief renderLimits_Test
+ */
+void
+Jinja2Template_Test::renderLimits_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"name\": \"abcd\","
+                " \"rows\": [{\"values\": [1, 2]}, {\"values\": [3, 4]}, {\"values\": [5, 6]}]}",
+                errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    // output is "1 2 3 4 5 6 " with 3 + 6 loop-iterations and a nesting-depth of 2
+    Jinja2Template* compiledTemplate = m_converter->compile(
+                "{% for row in rows %}{% for value in row.values %}{{ value }} {% endfor %}"
+                "{% endfor %}",
+                errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate == nullptr) {
+        return;
+    }
+
+    RenderLimits limits;
+    limits.maxOutputSize = 12;
+    limits.maxLoopIterations = 9;
+    limits.maxNestingDepth = 2;
+    compiledTemplate->setRenderLimits(limits);
+    TEST_EQUAL(compiledTemplate->getRenderLimits().maxOutputSize, 12);
+
+    // output, which already exist, doesn't count
+    std::string output = "prefix";
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+    TEST_EQUAL(output, std::string("prefix1 2 3 4 5 6 "));
+
+    limits.maxOutputSize = 11;
+    compiledTemplate->setRenderLimits(limits);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("output exceeds the limit of 11 bytes"), std::string::npos);
+    TEST_EQUAL(output.size() <= 12, true);
+
+    // the limit is checked for all flushed chunks together
+    std::ostringstream stream;
+    Jinja2StreamSink sink(stream, 4);
+    TEST_EQUAL(compiledTemplate->render(inputMap, sink, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("output exceeds"), std::string::npos);
+    TEST_EQUAL(stream.str().size() <= 12, true);
+
+    limits.maxOutputSize = 12;
+    limits.maxLoopIterations = 8;
+    compiledTemplate->setRenderLimits(limits);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("loop-iterations exceed the limit of 8"), std::string::npos);
+    TEST_NOT_EQUAL(errorMessage.find("row.values"), std::string::npos);
+
+    limits.maxLoopIterations = 0;
+    limits.maxNestingDepth = 1;
+    compiledTemplate->setRenderLimits(limits);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("nesting-depth of 2 exceeds the limit of 1"),
+                   std::string::npos);
+    TEST_EQUAL(output, "");
+
+    // parallel loops check the limits of all chunks together
+    limits.maxNestingDepth = 0;
+    limits.maxLoopIterations = 8;
+    compiledTemplate->setRenderLimits(limits);
+    compiledTemplate->setParallelLoops(1, 4);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("loop-iterations exceed"), std::string::npos);
+
+    limits.maxLoopIterations = 0;
+    limits.maxOutputSize = 11;
+    compiledTemplate->setRenderLimits(limits);
+    output.clear();
+    TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("output exceeds"), std::string::npos);
+    compiledTemplate->setParallelLoops(0);
+
+    // resumable renders count also the consumed output
+    Jinja2RenderContinuation continuation;
+    compiledTemplate->beginRender(inputMap, continuation);
+    bool success = true;
+    while(success
+          && continuation.isFinished() == false)
+    {
+        success = compiledTemplate->continueRender(continuation, 2, errorMessage);
+        continuation.consume(continuation.getSize());
+    }
+    TEST_EQUAL(success, false);
+    TEST_NOT_EQUAL(errorMessage.find("output exceeds"), std::string::npos);
+    delete compiledTemplate;
+
+    // templates with only text and replacements
+    compiledTemplate = m_converter->compile("name: {{ name }}", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        limits = RenderLimits();
+        limits.maxOutputSize = 9;
+        compiledTemplate->setRenderLimits(limits);
+        output.clear();
+        TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), false);
+        TEST_EQUAL(output, "");
+
+        limits.maxOutputSize = 10;
+        compiledTemplate->setRenderLimits(limits);
+        TEST_EQUAL(compiledTemplate->render(inputMap, output, errorMessage), true);
+        TEST_EQUAL(output, "name: abcd");
+        delete compiledTemplate;
+    }
+
+    // incremental renders have the limits of one render for all segments together
+    compiledTemplate = m_converter->compile("{% for row in rows %}x{% endfor %}|{{ name }}|"
+                                            "{% for row in rows %}y{% endfor %}",
+                                            errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        Jinja2RenderState state;
+        bool changed = false;
+        limits = RenderLimits();
+        limits.maxLoopIterations = 5;
+        compiledTemplate->setRenderLimits(limits);
+        TEST_EQUAL(compiledTemplate->renderIncremental(inputMap, {}, state, changed, errorMessage),
+                   false);
+        TEST_NOT_EQUAL(errorMessage.find("loop-iterations exceed"), std::string::npos);
+
+        limits.maxLoopIterations = 0;
+        limits.maxOutputSize = 11;
+        compiledTemplate->setRenderLimits(limits);
+        TEST_EQUAL(compiledTemplate->renderIncremental(inputMap, {}, state, changed, errorMessage),
+                   false);
+        TEST_NOT_EQUAL(errorMessage.find("output exceeds"), std::string::npos);
+
+        limits.maxOutputSize = 12;
+        compiledTemplate->setRenderLimits(limits);
+        TEST_EQUAL(compiledTemplate->renderIncremental(inputMap, {}, state, changed, errorMessage),
+                   true);
+        TEST_EQUAL(state.getOutput(), "xxx|abcd|yyy");
+
+        // the reused output of not affected segments is also counted
+        limits.maxOutputSize = 11;
+        compiledTemplate->setRenderLimits(limits);
+        TEST_EQUAL(compiledTemplate->renderIncremental(inputMap,
+                                                       {"name"},
+                                                       state,
+                                                       changed,
+                                                       errorMessage), false);
+        TEST_NOT_EQUAL(errorMessage.find("output exceeds"), std::string::npos);
+        delete compiledTemplate;
+    }
+
+    // limits of the converter are used by convert
+    limits = RenderLimits();
+    limits.maxLoopIterations = 2;
+    m_converter->setRenderLimits(limits);
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output,
+                                    "{% for row in rows %}x{% endfor %}",
+                                    inputMap,
+                                    errorMessage), false);
+    TEST_NOT_EQUAL(errorMessage.find("loop-iterations exceed the limit of 2"), std::string::npos);
+
+    m_converter->setRenderLimits(RenderLimits());
+    output.clear();
+    TEST_EQUAL(m_converter->convert(output,
+                                    "{% for row in rows %}x{% endfor %}",
+                                    inputMap,
+                                    errorMessage), true);
+    TEST_EQUAL(output, "xxx");
+}
+
+/**
+ * @brief preparedContext_Test
+ */
+void
+Jinja2Template_Test::preparedContext_Test()
+{
+    std::string errorMessage = "";
+    Json::JsonItem input;
+    input.parse("{\"name\": \"abcd\", \"user\": {\"id\": 7, \"address\": {\"city\": \"Berlin\"}},"
+                " \"list\": [\"a\", \"b\"], \"a.b\": \"x\", \"a\": {\"b\": \"y\"}}",
+                errorMessage);
+    DataMap* inputMap = input.getItemContent()->toMap();
+
+    // keys with a dot can not be reached by a path and are not indexed
+    Jinja2PreparedContext context(inputMap);
+    TEST_EQUAL(context.getInput(), inputMap);
+    TEST_EQUAL(context.getNumberOfPaths(), 8);
+    TEST_EQUAL(context.get("user.address.city")->toString(), std::string("Berlin"));
+    TEST_EQUAL(context.get("a.b")->toString(), std::string("y"));
+    TEST_EQUAL(context.get("user.missing"), nullptr);
+    TEST_EQUAL(context.get("list.0"), nullptr);
+
+    // splice-list
+    Jinja2Template* compiledTemplate = m_converter->compile(
+                "{{ name }}-{{ user.address.city }}-{{ a.b }}", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        std::string output = "";
+        TEST_EQUAL(compiledTemplate->render(context, output, errorMessage), true);
+        TEST_EQUAL(output, "abcd-Berlin-y");
+        delete compiledTemplate;
+    }
+
+    // loop-variables shadow the paths of the context
+    compiledTemplate = m_converter->compile(
+                "{% for name in list %}{{ name }}{% endfor %}|{{ name }}|"
+                "{% if user.id == 7 %}seven{% endif %}", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        std::string output = "";
+        TEST_EQUAL(compiledTemplate->render(context, output, errorMessage), true);
+        TEST_EQUAL(output, "ab|abcd|seven");
+
+        std::ostringstream stream;
+        Jinja2StreamSink sink(stream, 4);
+        TEST_EQUAL(compiledTemplate->render(context, sink, errorMessage), true);
+        TEST_EQUAL(stream.str(), "ab|abcd|seven");
+        delete compiledTemplate;
+    }
+
+    // missing paths have the same error as without context
+    compiledTemplate = m_converter->compile("{{ name }}{{ user.missing }}", errorMessage);
+    TEST_NOT_EQUAL(compiledTemplate, nullptr);
+    if(compiledTemplate != nullptr)
+    {
+        std::string output = "";
+        TEST_EQUAL(compiledTemplate->render(context, output, errorMessage), false);
+        TEST_NOT_EQUAL(errorMessage.find("user.missing"), std::string::npos);
+        delete compiledTemplate;
+    }
+
+    // the same context for different templates of the converter
+    std::string output = "";
+    TEST_EQUAL(m_converter->convert(output, "{{ user.id }}", context, errorMessage), true);
+    TEST_EQUAL(m_converter->convert(output, " {{ name }}", context, errorMessage), true);
+    TEST_EQUAL(output, "7 abcd");
+
+    // an empty input has no paths
+    Json::JsonItem emptyInput;
+    emptyInput.parse("{}", errorMessage);
+    Jinja2PreparedContext emptyContext(emptyInput.getItemContent()->toMap());
+    TEST_EQUAL(emptyContext.getNumberOfPaths(), 0);
+    TEST_EQUAL(emptyContext.get("name"), nullptr);
+}
+
+/**
+ * cleanupTestCase
+ */
+void
+Jinja2Template_Test::cleanupTestCase()
+{
+    delete m_converter;
+}
+
+}
+}
@@ -0,0 +1,59 @@
+/**
+ *  @file    jinja2_template_test.h
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#ifndef JINJA2TEMPLATE_TEST_H
+#define JINJA2TEMPLATE_TEST_H
+
+#include <libKitsunemimiCommon/test_helper/compare_test_helper.h>
+#include <utility>
+#include <string>
+#include <vector>
+
+namespace Kitsunemimi
+{
+namespace Jinja2
+{
+class Jinja2Converter;
+
+class Jinja2Template_Test
+        : public Kitsunemimi::CompareTestHelper
+{
+
+public:
+    Jinja2Template_Test();
+
+private:
+    Kitsunemimi::Jinja2::Jinja2Converter* m_converter = nullptr;
+
+    void initTestCase();
+
+    void compile_Test();
+    void renderMultipleTimes_Test();
+    void longTemplate_Test();
+    void nestingDepth_Test();
+    void estimateOutputSize_Test();
+    void renderIntoSink_Test();
+    void loopVariables_Test();
+    void renderBatch_Test();
+    void parallelLoop_Test();
+    void staticContext_Test();
+    void profiling_Test();
+    void dependencies_Test();
+    void renderIncremental_Test();
+    void spliceList_Test();
+    void resumableRender_Test();
+    void renderLimits_Test();
+    void preparedContext_Test();
+
+    void cleanupTestCase();
+};
+
+}
+}
+
+#endif // JINJA2TEMPLATE_TEST_H
@@ -7,8 +7,14 @@
 */
 
 #include <libKitsunemimiJinja2/jinja2_converter_test.h>
+#include <libKitsunemimiJinja2/jinja2_template_test.h>
+#include <libKitsunemimiJinja2/jinja2_template_bundle_test.h>
+#include <libKitsunemimiJinja2/jinja2_template_registry_test.h>
 
 int main()
 {
-    Kitsunemimi::Jinja2::Jinja2Converter_Test test;
+    Kitsunemimi::Jinja2::Jinja2Converter_Test converterTest;
+    Kitsunemimi::Jinja2::Jinja2Template_Test templateTest;
+    Kitsunemimi::Jinja2::Jinja2TemplateBundle_Test templateBundleTest;
+    Kitsunemimi::Jinja2::Jinja2TemplateRegistry_Test templateRegistryTest;
 }
@@ -18,9 +18,17 @@ LIBS += -L../../../libKitsunemimiCommon/src/debug -lKitsunemimiCommon
 LIBS += -L../../../libKitsunemimiCommon/src/release -lKitsunemimiCommon
 INCLUDEPATH += ../../../libKitsunemimiCommon/include
 
+LIBS += -lpthread
+
 SOURCES += \
         main.cpp \
-    libKitsunemimiJinja2/jinja2_converter_test.cpp
+    libKitsunemimiJinja2/jinja2_converter_test.cpp \
+    libKitsunemimiJinja2/jinja2_template_test.cpp \
+    libKitsunemimiJinja2/jinja2_template_bundle_test.cpp \
+    libKitsunemimiJinja2/jinja2_template_registry_test.cpp
 
 HEADERS += \
-    libKitsunemimiJinja2/jinja2_converter_test.h
+    libKitsunemimiJinja2/jinja2_converter_test.h \
+    libKitsunemimiJinja2/jinja2_template_test.h \
+    libKitsunemimiJinja2/jinja2_template_bundle_test.h \
+    libKitsunemimiJinja2/jinja2_template_registry_test.h
@@ -0,0 +1,328 @@
+/**
+ *  @file    main.cpp
+ *
+ *  @brief   offline-compiler for jinja2-templates. It validates templates, prints statistics
+ *           of the compiled templates and writes them into a bundle-file or generates
+ *           C++-code for them.
+ *
+ *  @author  Tobias Anker <tobias.anker@kitsunemimi.moe>
+ *
+ *  @copyright MIT License
+*/
+
+#include <libKitsunemimiJinja2/jinja2_converter.h>
+#include <libKitsunemimiJinja2/jinja2_template.h>
+#include <libKitsunemimiJinja2/jinja2_template_bundle.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+
+using Kitsunemimi::Jinja2::Jinja2Converter;
+using Kitsunemimi::Jinja2::Jinja2Template;
+using Kitsunemimi::Jinja2::Jinja2TemplateBundle;
+using Kitsunemimi::Jinja2::TemplateStatistics;
+
+/**
+ * @brief print usage of the tool
+ */
+void
+printUsage()
+{
+    std::cout << "usage: jinja2c [--stats] [--bundle <OUTPUT_FILE>] [--generate <OUTPUT_FILE>] "
+                 "[--include-dir <DIR>] <TEMPLATE_FILE>...\n"
+              << "\n"
+              << "    Compiles all given template-files and exits with 1, if one of them is "
+                 "invalid.\n"
+              << "\n"
+              << "    --stats                  print statistics of each compiled template\n"
+              << "    --bundle <OUTPUT_FILE>   write all compiled templates into a bundle-file.\n"
+              << "                             The path of each template-file is its name "
+                 "within the bundle.\n"
+              << "    --generate <OUTPUT_FILE> write a C++-file with one function for each "
+                 "template,\n"
+              << "                             which is used by the converter instead of "
+                 "the template.\n"
+              << "    --include-dir <DIR>      directory with the files of included "
+                 "templates\n"
+              << "    --help                   print this help"
+              << std::endl;
+}
+
+/**
+ * @brief read the complete content of a file
+ *
+ * @param filePath path of the file
+ * @param content reference for the content of the file
+ *
+ * @return false, if the file can not be read, else true
+ */
+bool
+readFile(const std::string &filePath,
+         std::string &content)
+{
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if(file.is_open() == false) {
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+
+    return file.bad() == false;
+}
+
+/**
+ * @brief write a string into a file
+ *
+ * @param filePath path of the file
+ * @param content content to write
+ *
+ * @return false, if the file can not be written, else true
+ */
+bool
+writeFile(const std::string &filePath,
+          const std::string &content)
+{
+    std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(file.is_open() == false) {
+        return false;
+    }
+
+    file << content;
+    file.close();
+
+    return file.fail() == false;
+}
+
+/**
+ * @brief create the name of the generated function of a template-file
+ *
+ * @param filePath path of the template-file
+ * @param existingNames already used names
+ *
+ * @return valid and unique C++-identifier based on the name of the file
+ */
+std::string
+createFunctionName(const std::string &filePath,
+                   const std::vector<std::string> &existingNames)
+{
+    const uint64_t slash = filePath.find_last_of('/');
+    const std::string fileName = (slash == std::string::npos) ? filePath
+                                                              : filePath.substr(slash + 1);
+
+    std::string name = "jinja2_";
+    for(const char character : fileName)
+    {
+        if(isalnum(static_cast<unsigned char>(character))) {
+            name += character;
+        } else {
+            name += '_';
+        }
+    }
+
+    // files with the same name in different directories get a number
+    std::string result = name;
+    uint32_t counter = 1;
+    while(std::find(existingNames.begin(), existingNames.end(), result) != existingNames.end())
+    {
+        result = name + "_" + std::to_string(counter);
+        counter++;
+    }
+
+    return result;
+}
+
+/**
+ * @brief print statistics of a compiled template
+ *
+ * @param filePath path of the template-file
+ * @param compiledTemplate compiled template
+ */
+void
+printStatistics(const std::string &filePath,
+                Jinja2Template* compiledTemplate)
+{
+    const TemplateStatistics statistics = compiledTemplate->getStatistics();
+
+    std::cout << filePath << ":\n"
+              << "    instructions:         " << statistics.numberOfInstructions << "\n"
+              << "    literal bytes:        " << statistics.literalSize << "\n"
+              << "    dynamic paths:        " << statistics.numberOfPaths << "\n"
+              << "    keys:                 " << statistics.numberOfKeys << "\n"
+              << "    conditions:           " << statistics.numberOfConditions << "\n"
+              << "    max nesting-depth:    " << statistics.maxNestingDepth << "\n"
+              << "    bytecode bytes:       " << statistics.bytecodeSize << "\n"
+              << "    splice-list:          " << (statistics.isSpliceList ? "yes" : "no")
+              << std::endl;
+}
+
+int
+main(int argc, char *argv[])
+{
+    bool printStats = false;
+    std::string bundlePath = "";
+    std::string generatePath = "";
+    std::string includeDir = "";
+    std::vector<std::string> filePaths;
+
+    // parse arguments
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string argument(argv[i]);
+        if(argument == "--help")
+        {
+            printUsage();
+            return 0;
+        }
+        else if(argument == "--stats")
+        {
+            printStats = true;
+        }
+        else if(argument == "--bundle")
+        {
+            if(i + 1 >= argc)
+            {
+                std::cerr << "ERROR: missing output-file for --bundle" << std::endl;
+                return 1;
+            }
+            i++;
+            bundlePath = argv[i];
+        }
+        else if(argument == "--generate")
+        {
+            if(i + 1 >= argc)
+            {
+                std::cerr << "ERROR: missing output-file for --generate" << std::endl;
+                return 1;
+            }
+            i++;
+            generatePath = argv[i];
+        }
+        else if(argument == "--include-dir")
+        {
+            if(i + 1 >= argc)
+            {
+                std::cerr << "ERROR: missing directory for --include-dir" << std::endl;
+                return 1;
+            }
+            i++;
+            includeDir = argv[i];
+        }
+        else
+        {
+            filePaths.push_back(argument);
+        }
+    }
+
+    if(filePaths.size() == 0)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // compile all templates
+    Jinja2Converter* converter = Jinja2Converter::getInstance();
+    if(includeDir != "")
+    {
+        // name of an include is the path of its file within the include-directory
+        converter->setIncludeLoader([includeDir](const std::string &name,
+                                                 std::string &templateString,
+                                                 std::string &errorMessage)
+        {
+            const std::string includePath = includeDir + "/" + name;
+            if(readFile(includePath, templateString) == false)
+            {
+                errorMessage = "can not read file: " + includePath;
+                return false;
+            }
+            return true;
+        });
+    }
+
+    std::vector<Jinja2Template*> templates;
+    std::vector<std::string> contents;
+    bool success = true;
+
+    for(const std::string &filePath : filePaths)
+    {
+        std::string content = "";
+        if(readFile(filePath, content) == false)
+        {
+            std::cerr << "ERROR: can not read file: " << filePath << std::endl;
+            success = false;
+            continue;
+        }
+
+        std::string errorMessage = "";
+        Jinja2Template* compiledTemplate = converter->compile(content, errorMessage);
+        if(compiledTemplate == nullptr)
+        {
+            std::cerr << "ERROR: invalid template: " << filePath << "\n"
+                      << errorMessage << std::endl;
+            success = false;
+            continue;
+        }
+
+        if(printStats) {
+            printStatistics(filePath, compiledTemplate);
+        }
+
+        templates.push_back(compiledTemplate);
+        contents.push_back(content);
+    }
+
+    // bundle is only written, if all templates are valid
+    if(success
+            && bundlePath != "")
+    {
+        std::string errorMessage = "";
+        if(Jinja2TemplateBundle::writeFile(bundlePath,
+                                           filePaths,
+                                           templates,
+                                           errorMessage) == false)
+        {
+            std::cerr << "ERROR: " << errorMessage << std::endl;
+            success = false;
+        }
+    }
+
+    // code is only generated, if all templates are valid
+    if(success
+            && generatePath != "")
+    {
+        std::vector<std::string> functionNames;
+        for(const std::string &filePath : filePaths) {
+            functionNames.push_back(createFunctionName(filePath, functionNames));
+        }
+
+        std::string code = "";
+        std::string errorMessage = "";
+        if(converter->generateCode(contents, functionNames, code, errorMessage) == false)
+        {
+            std::cerr << "ERROR: " << errorMessage << std::endl;
+            success = false;
+        }
+        else if(writeFile(generatePath, code) == false)
+        {
+            std::cerr << "ERROR: can not write file: " << generatePath << std::endl;
+            success = false;
+        }
+    }
+
+    for(Jinja2Template* compiledTemplate : templates) {
+        delete compiledTemplate;
+    }
+    delete converter;
+
+    if(success) {
+        return 0;
+    }
+
+    return 1;
+}
@@ -0,0 +1,9 @@
+TEMPLATE = subdirs
+CONFIG += ordered
+QT -= qt core gui
+CONFIG += c++14
+
+SUBDIRS = \
+    jinja2c
+
+tools.depends = src